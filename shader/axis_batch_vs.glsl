@@ -0,0 +1,18 @@
+#version 430 core
+#extension GL_ARB_shader_draw_parameters : require
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aColor;
+
+#include "include/frame_context.glsl"
+
+// model matrices of the batched draws, indexed by the draw id of the multi draw
+layout(std430, binding = 1) readonly buffer BatchTransforms {
+	mat4 models[];
+};
+
+out vec3 vColor;
+void main()
+{
+	vColor = aColor;
+	gl_Position = projection * view * models[gl_DrawIDARB] * vec4(aPos, 1.0f);
+}
\ No newline at end of file
@@ -2,8 +2,7 @@
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aColor;
 
-uniform mat4 view;
-uniform mat4 projection;
+#include "include/frame_context.glsl"
 
 out vec3 vColor;
 void main()
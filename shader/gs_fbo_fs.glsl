@@ -2,11 +2,22 @@
 precision highp float;
 uniform vec4 color;
 uniform sampler2D colorTexture;
+uniform vec2 uvScale;  // part of the texture covered by the splat pass, it may render below full size
+uniform int upscaleFilter;  // 0 bilinear, 1 contrast adaptive sharpening
+uniform float sharpness;
 in vec2 frag_uv;
 out vec4 fragColor;
 
+// keeps the bilinear footprint inside the rendered rectangle, texels beyond it are stale
+vec2 ClampToRendered(vec2 uv, vec2 texelSize)
+{
+	return clamp(uv, 0.5 * texelSize, uvScale - 0.5 * texelSize);
+}
+
 void main(void)
 {
+	vec2 texelSize = 1.0 / vec2(textureSize(colorTexture, 0));
+	vec2 uv = ClampToRendered(frag_uv * uvScale, texelSize);
 	//#ifdef USE_SUPERSAMPLING
 	//	// per pixel screen space partial derivatives
 	//	vec2 dx = dFdx(frag_uv) * 0.25; // horizontal offset
@@ -20,8 +31,22 @@ void main(void)
 	//	texColor += texture(colorTexture, vec2(frag_uv - dx - dy));
 	//	texColor *= 0.25;
 	//#else
-	vec4 texColor = texture(colorTexture, frag_uv);
+	vec4 texColor = texture(colorTexture, uv);
 	//#endif
 
+	if (upscaleFilter == 1) {
+		// sharpen against the cross of neighbouring source texels, the amount follows the local
+		// contrast as in AMD CAS and the result stays within the neighbourhood so edges do not ring
+		vec4 n = texture(colorTexture, ClampToRendered(uv + vec2(0.0, texelSize.y), texelSize));
+		vec4 s = texture(colorTexture, ClampToRendered(uv - vec2(0.0, texelSize.y), texelSize));
+		vec4 e = texture(colorTexture, ClampToRendered(uv + vec2(texelSize.x, 0.0), texelSize));
+		vec4 w = texture(colorTexture, ClampToRendered(uv - vec2(texelSize.x, 0.0), texelSize));
+		vec4 minColor = min(texColor, min(min(n, s), min(e, w)));
+		vec4 maxColor = max(texColor, max(max(n, s), max(e, w)));
+		vec4 amount = sqrt(clamp(min(minColor, 1.0 - maxColor) / max(maxColor, vec4(1e-4)), 0.0, 1.0));
+		vec4 weight = -amount / mix(8.0, 5.0, sharpness);
+		vec4 sharpened = (texColor + weight * (n + s + e + w)) / (1.0 + 4.0 * weight);
+		texColor = clamp(sharpened, minColor, maxColor);
+	}
 	fragColor = texColor;
 }
@@ -0,0 +1,42 @@
+#version 430 core
+
+// Expands the splat records of the preprocess pass into quads, one instance per record.
+
+precision highp float;
+precision highp int;
+
+layout(location = 0) in vec2 position;
+
+#include "include/frame_context.glsl"
+#include "include/gs_splat_record.glsl"
+
+layout(std430, binding = 1) readonly buffer RecordBuffer {
+	SplatRecord records[];
+};
+
+out vec2 vPosition;
+out vec2 vCenter;
+out vec4 vColor;
+out mat2 vCov2d_inv;
+
+void main()
+{
+	SplatRecord record = records[gl_InstanceID];
+	vPosition = position;
+	vColor = record.color;
+	vCov2d_inv = mat2(record.conic.xy, record.conic.zw);
+	if (record.clip.w == 0.0f)
+	{
+		// outside of the clip volume, the quad is dropped before rasterization
+		gl_Position = vec4(0.0f, 0.0f, 2.0f, 1.0f);
+		vCenter = vec2(100.0f, 100.0f);
+		return;
+	}
+
+	vec2 ndc = record.clip.xy / record.clip.w;
+	vCenter = 0.5f * (viewport + ndc * viewport);
+
+	vec2 offset = position.x * record.axes.xy + position.y * record.axes.zw;
+	offset *= (2.0f / viewport) * record.clip.w;
+	gl_Position = record.clip + vec4(offset, 0.0f, 0.0f);
+}
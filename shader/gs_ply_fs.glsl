@@ -6,8 +6,10 @@ in mat2 vCov2d_inv;
 in vec4 vConic_opacity;
 in vec2 vCenter;
 in vec4 vConic;
-uniform int showGaussian;
 uniform int showHotspots;
+#include "include/frame_context.glsl"
+// size of the splat pass, vCenter and the conic are in the pixels of the FrameContext viewport
+uniform vec2 renderSize;
 
 layout(location = 0) out vec4 fragColor;
 layout(location = 1) out vec4 hotspots;
@@ -15,18 +17,13 @@ layout(location = 1) out vec4 hotspots;
 void main()
 {
 	float minAlpha = 1.0f / 256.0f;
-	vec2 d = (vCenter - gl_FragCoord.xy);
+	// sampled at the screen position of the pixel centre like the tile backend, the pass may be scaled down
+	vec2 d = (vCenter - gl_FragCoord.xy * viewport / renderSize);
 	float g = exp(-0.5f * dot(d, vCov2d_inv * d));
 	if (vColor.a * g <= minAlpha)
 	{
 		discard;
 	}
 
-	if (showGaussian == 1)
-	{
-		fragColor = vec4(vColor);
-	}
-	else {
-		fragColor = vec4(vColor.rgb * vColor.a * g, vColor.a * g);
-	}
+	fragColor = vec4(vColor.rgb * vColor.a * g, vColor.a * g);
 }
\ No newline at end of file
@@ -0,0 +1,49 @@
+#version 430 core
+layout(local_size_x = 256) in;
+
+// variants, defined by GSPlyObj
+// SH_DEGREE: number of spherical harmonics bands evaluated on top of the base color, 0 to 3
+
+precision highp float;
+precision highp int;
+
+uniform highp usampler2D u_texture;
+uniform uint splatCount;
+#include "include/frame_context.glsl"
+#include "include/gs_ply_common.glsl"
+#include "include/gs_splat_record.glsl"
+
+// texture slots in draw order, from the CPU sorters' index buffer or the GPU sorter's value buffer
+layout(std430, binding = 0) readonly buffer DepthBuffer {
+	uint index[];
+};
+
+layout(std430, binding = 1) writeonly buffer RecordBuffer {
+	SplatRecord records[];
+};
+
+void main()
+{
+	uint i = gl_GlobalInvocationID.x;
+	if (i >= splatCount)
+	{
+		return;
+	}
+
+	ProjectedSplat splat;
+	SplatRecord record;
+	if (!projectSplat(index[i], splat))
+	{
+		record.clip = vec4(0.0f);
+		record.axes = vec4(0.0f);
+		record.conic = vec4(1.0f, 0.0f, 0.0f, 1.0f);
+		record.color = vec4(0.0f);
+		records[i] = record;
+		return;
+	}
+	record.clip = splat.clip;
+	record.axes = vec4(splat.majorAxis, splat.minorAxis);
+	record.conic = vec4(splat.cov2dInv[0], splat.cov2dInv[1]);
+	record.color = splat.color;
+	records[i] = record;
+}
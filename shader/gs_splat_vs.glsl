@@ -4,9 +4,7 @@ precision highp float;
 precision highp int;
 
 uniform highp usampler2D u_texture;
-uniform mat4 view, projection;
-uniform vec2 focal;
-uniform vec2 viewport, nearFar;
+#include "include/frame_context.glsl"
 
 layout(location = 0) in vec2 position;
 //#ifdef USE_GPU_SORT
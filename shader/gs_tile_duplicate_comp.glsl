@@ -0,0 +1,74 @@
+#version 430 core
+layout(local_size_x = 256) in;
+
+// Emits one duplicate per tile overlapped by a splat record, keyed by the view depth of the splat.
+// Duplicates beyond capacity are counted but not written, the host grows the buffers and runs again.
+
+precision highp float;
+precision highp int;
+
+uniform uint splatCount;
+uniform uint capacity;
+#include "include/frame_context.glsl"
+#include "include/gs_splat_record.glsl"
+#include "include/gs_tile_common.glsl"
+
+layout(std430, binding = 0) readonly buffer RecordBuffer {
+	SplatRecord records[];
+};
+
+layout(std430, binding = 1) buffer CounterBuffer {
+	uint duplicateCount;
+};
+
+layout(std430, binding = 2) writeonly buffer KeyBuffer {
+	uint keys[];
+};
+
+layout(std430, binding = 3) writeonly buffer ValueBuffer {
+	uint values[];
+};
+
+layout(std430, binding = 4) writeonly buffer DuplicateBuffer {
+	uvec2 duplicates[];  // tile, record
+};
+
+void main()
+{
+	uint i = gl_GlobalInvocationID.x;
+	if (i >= splatCount)
+	{
+		return;
+	}
+
+	SplatRecord record = records[i];
+	// w = 0 marks the splats the preprocess pass dropped, splats behind the camera have a negative w
+	if (record.clip.w <= 0.0f)
+	{
+		return;
+	}
+	uvec4 rect;
+	if (!getTileRect(record, rect))
+	{
+		return;
+	}
+
+	uint base = atomicAdd(duplicateCount, (rect.z - rect.x) * (rect.w - rect.y));
+	// positive floats keep their order as bits, so the view depth sorts as an unsigned key
+	uint depthKey = floatBitsToUint(record.clip.w);
+	uint gridWidth = getTileGrid().x;
+	uint slot = base;
+	for (uint y = rect.y; y < rect.w; y++)
+	{
+		for (uint x = rect.x; x < rect.z; x++, slot++)
+		{
+			if (slot >= capacity)
+			{
+				return;
+			}
+			keys[slot] = depthKey;
+			values[slot] = slot;
+			duplicates[slot] = uvec2(y * gridWidth + x, i);
+		}
+	}
+}
@@ -0,0 +1,32 @@
+#version 430 core
+layout(local_size_x = 256) in;
+
+// Runs between the depth and the tile passes of the radix sort. The duplicates are in depth order,
+// their keys become the tile and their values the record, so the stable tile passes end in (tile, depth) order.
+
+uniform uint duplicateCount;
+
+layout(std430, binding = 0) writeonly buffer KeyBuffer {
+	uint keys[];
+};
+
+layout(std430, binding = 1) buffer ValueBuffer {
+	uint values[];
+};
+
+layout(std430, binding = 2) readonly buffer DuplicateBuffer {
+	uvec2 duplicates[];  // tile, record
+};
+
+void main()
+{
+	uint i = gl_GlobalInvocationID.x;
+	if (i >= duplicateCount)
+	{
+		return;
+	}
+
+	uvec2 duplicate = duplicates[values[i]];
+	keys[i] = duplicate.x;
+	values[i] = duplicate.y;
+}
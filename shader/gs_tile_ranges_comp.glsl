@@ -0,0 +1,33 @@
+#version 430 core
+layout(local_size_x = 256) in;
+
+// Finds the range of every tile in the sorted duplicates, tiles without splats keep the cleared (0, 0).
+
+uniform uint duplicateCount;
+
+layout(std430, binding = 0) readonly buffer KeyBuffer {
+	uint keys[];
+};
+
+layout(std430, binding = 1) writeonly buffer RangeBuffer {
+	uvec2 ranges[];  // first, end
+};
+
+void main()
+{
+	uint i = gl_GlobalInvocationID.x;
+	if (i >= duplicateCount)
+	{
+		return;
+	}
+
+	uint tile = keys[i];
+	if (i == 0u || keys[i - 1u] != tile)
+	{
+		ranges[tile].x = i;
+	}
+	if (i == duplicateCount - 1u || keys[i + 1u] != tile)
+	{
+		ranges[tile].y = i + 1u;
+	}
+}
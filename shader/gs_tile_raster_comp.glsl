@@ -0,0 +1,103 @@
+#version 430 core
+layout(local_size_x = 16, local_size_y = 16) in;
+
+// One workgroup per tile, one invocation per pixel. The splats of the tile are staged in shared memory
+// a batch at a time and blended front to back, a pixel stops once its transmittance is used up and the
+// tile stops once all of its pixels have. The output is premultiplied like the blended quads.
+
+precision highp float;
+precision highp int;
+
+#include "include/frame_context.glsl"
+#include "include/gs_splat_record.glsl"
+#include "include/gs_tile_common.glsl"
+
+layout(binding = 0) writeonly uniform image2D u_output;
+
+layout(std430, binding = 0) readonly buffer RecordBuffer {
+	SplatRecord records[];
+};
+
+layout(std430, binding = 1) readonly buffer ValueBuffer {
+	uint values[];  // records in (tile, depth) order
+};
+
+layout(std430, binding = 2) readonly buffer RangeBuffer {
+	uvec2 ranges[];
+};
+
+const float MIN_ALPHA = 1.0f / 256.0f;
+const float MAX_ALPHA = 0.99f;
+const float MIN_TRANSMITTANCE = 0.0001f;
+
+shared vec2 batchCenter[TILE_PIXELS];
+shared vec4 batchConic[TILE_PIXELS];
+shared vec4 batchColor[TILE_PIXELS];
+shared uint doneCount;
+
+void main()
+{
+	uvec2 pixel = gl_GlobalInvocationID.xy;
+	uint localIndex = gl_LocalInvocationIndex;
+	bool inside = all(lessThan(pixel, uvec2(renderSize)));
+	// the records are in screen pixels, the image may be rendered at a lower resolution
+	vec2 samplePos = (vec2(pixel) + 0.5f) * viewport / renderSize;
+	uvec2 range = ranges[gl_WorkGroupID.y * getTileGrid().x + gl_WorkGroupID.x];
+
+	vec3 color = vec3(0.0f);
+	float transmittance = 1.0f;
+	bool done = !inside;
+	for (uint first = range.x; first < range.y; first += TILE_PIXELS)
+	{
+		if (localIndex == 0u)
+		{
+			doneCount = 0u;
+		}
+		barrier();
+		if (done)
+		{
+			atomicAdd(doneCount, 1u);
+		}
+		barrier();
+		if (doneCount == TILE_PIXELS)
+		{
+			break;
+		}
+
+		uint i = first + localIndex;
+		if (i < range.y)
+		{
+			SplatRecord record = records[values[i]];
+			batchCenter[localIndex] = getRecordCenter(record);
+			batchConic[localIndex] = record.conic;
+			batchColor[localIndex] = record.color;
+		}
+		barrier();
+
+		uint batchSize = min(TILE_PIXELS, range.y - first);
+		for (uint j = 0u; !done && j < batchSize; j++)
+		{
+			vec2 d = batchCenter[j] - samplePos;
+			vec4 conic = batchConic[j];
+			float alpha = min(MAX_ALPHA, batchColor[j].a * exp(-0.5f * dot(d, mat2(conic.xy, conic.zw) * d)));
+			if (alpha <= MIN_ALPHA)
+			{
+				continue;
+			}
+			float nextTransmittance = transmittance * (1.0f - alpha);
+			if (nextTransmittance < MIN_TRANSMITTANCE)
+			{
+				done = true;
+				break;
+			}
+			color += batchColor[j].rgb * alpha * transmittance;
+			transmittance = nextTransmittance;
+		}
+		barrier();
+	}
+
+	if (inside)
+	{
+		imageStore(u_output, ivec2(pixel), vec4(color, 1.0f - transmittance));
+	}
+}
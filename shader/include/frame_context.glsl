@@ -0,0 +1,12 @@
+// Per-frame values shared by every program, filled by RenderMain. The member order has to match
+// struct FrameContext in src/draw/frame_context.h
+layout(std140) uniform FrameContext {
+	mat4 projection;
+	mat4 view;
+	mat4 model;
+	vec4 camPos;
+	vec2 viewport;
+	vec2 focal;
+	vec2 tanFov;
+	vec2 nearFar;
+};
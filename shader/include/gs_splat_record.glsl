@@ -0,0 +1,7 @@
+// one projected splat per drawn instance, written by gs_ply_preprocess_comp.glsl in draw order
+struct SplatRecord {
+	vec4 clip;   // clip space centre, w = 0 marks a splat that is not drawn
+	vec4 axes;   // major axis xy, minor axis zw, in pixels
+	vec4 conic;  // inverse 2D covariance, columns xy and zw
+	vec4 color;
+};
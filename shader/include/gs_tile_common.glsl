@@ -0,0 +1,37 @@
+// Screen tiling shared by the passes of the tile rasterizer (GSTileRasterizer).
+// Include after the FrameContext block and gs_splat_record.glsl. The records are projected for
+// the FrameContext viewport, the tiles cover the renderSize pixels of the splat framebuffer.
+#define TILE_SIZE 16u
+#define TILE_PIXELS (TILE_SIZE * TILE_SIZE)
+
+uniform vec2 renderSize;
+
+uvec2 getTileGrid()
+{
+	return (uvec2(renderSize) + TILE_SIZE - 1u) / TILE_SIZE;
+}
+
+vec2 toRenderPixels(vec2 screenPixels)
+{
+	return screenPixels * renderSize / viewport;
+}
+
+// centre in screen pixels, lower left origin like gl_FragCoord
+vec2 getRecordCenter(SplatRecord record)
+{
+	vec2 ndc = record.clip.xy / record.clip.w;
+	return 0.5f * (viewport + ndc * viewport);
+}
+
+// tiles overlapped by the 3 sigma ellipse of the record, rect.xy inclusive and rect.zw exclusive
+bool getTileRect(SplatRecord record, out uvec4 rect)
+{
+	vec2 center = toRenderPixels(getRecordCenter(record));
+	// half size of the box around the ellipse spanned by the two axes
+	vec2 extent = toRenderPixels(sqrt(record.axes.xy * record.axes.xy + record.axes.zw * record.axes.zw));
+	vec2 grid = vec2(getTileGrid());
+	vec2 rectMin = clamp(floor((center - extent) / float(TILE_SIZE)), vec2(0.0f), grid);
+	vec2 rectMax = clamp(ceil((center + extent) / float(TILE_SIZE)), vec2(0.0f), grid);
+	rect = uvec4(rectMin, rectMax);
+	return all(lessThan(rect.xy, rect.zw));
+}
@@ -3,9 +3,39 @@ out vec4 FragColor;
 
 in vec2 vTexCoord;
 in vec3 vColor;
-uniform sampler2D texture1;
+// the resident tiles of MapTileEngine, one 256 x 256 tile with its mips per layer
+uniform sampler2DArray tileCache;
+// quadtree over them, per node the first of its four children (-1 for a leaf) and its layer (-1 while not resident)
+uniform isamplerBuffer tileTree;
+
+const vec4 LOADING_COLOR = vec4(0.5, 0.5, 0.5, 1.0);
+const int MAX_LEVEL = 23;
 
 void main()
 {
-	FragColor = texture(texture1, vTexCoord);
-};
\ No newline at end of file
+	// taken before the branches, the tile seams would break the derivatives of the local uv
+	vec2 uvDx = dFdx(vTexCoord);
+	vec2 uvDy = dFdy(vTexCoord);
+	// the pyramid counts rows from the north and wraps around the globe
+	vec2 uv = vec2(fract(vTexCoord.x), clamp(1.0 - vTexCoord.y, 0.0, 0.99999994));
+
+	// walk down to the finest resident tile, its ancestors stand in while it loads
+	ivec2 node = texelFetch(tileTree, 0).xy;
+	int layer = -1;
+	float tileCount = 1.0;
+	for (int level = 0; level < MAX_LEVEL; level++) {
+		if (node.y >= 0) {
+			layer = node.y;
+			tileCount = exp2(float(level));
+		}
+		if (node.x < 0)
+			break;
+		ivec2 child = ivec2(uv * exp2(float(level + 1))) & 1;
+		node = texelFetch(tileTree, node.x + child.x + 2 * child.y).xy;
+	}
+	if (layer < 0) {
+		FragColor = LOADING_COLOR;
+		return;
+	}
+	FragColor = textureGrad(tileCache, vec3(fract(uv * tileCount), float(layer)), uvDx * tileCount, uvDy * tileCount);
+}
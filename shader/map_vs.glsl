@@ -1,19 +1,43 @@
 #version 330 core
-layout(location = 0) in vec3 aPos;
-layout(location = 1) in vec3 aColor;
-layout(location = 2) in vec2 aTexCoord;
-
 out vec3 vColor;
 out vec2 vTexCoord;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+#include "include/frame_context.glsl"
+
+// the grid has no vertex buffer, its vertices are made from gl_VertexID: one triangle strip per row of cells,
+// joined to the next row by repeating its last and the next first vertex
+uniform int gridWidth;
+uniform int gridHeight;
+uniform vec4 gridRect;  // left, bottom, right, top
+uniform float transformScale;  // 0 for the plane, 1 for the globe
 
+const float PI = 3.1415926535;
 
 void main()
 {
-	gl_Position = projection * view * model * vec4(aPos, 1.0f);
-	vColor = aColor;
-	vTexCoord = aTexCoord;
-}
\ No newline at end of file
+	int rowLength = 2 * gridWidth + 4;
+	int row = gl_VertexID / rowLength;
+	int k = gl_VertexID - row * rowLength;
+	// bottom then top vertex of each column, keeps the winding of the triangles
+	ivec2 vertex = ivec2(k >> 1, row + (k & 1));
+	if (k == rowLength - 2)
+		vertex = ivec2(gridWidth, row + 1);
+	else if (k == rowLength - 1)
+		vertex = ivec2(0, row + 1);
+	vec2 uv = vec2(vertex) / vec2(gridWidth, gridHeight);
+	vec2 grid = mix(gridRect.xy, gridRect.zw, uv);
+
+	// x spans the longitudes and y the latitudes
+	float lat = grid.y * 90.0;
+	float radLon = radians(grid.x * 180.0 - 90.0);
+	float radLat = radians(lat);
+	vec3 sphere = vec3(cos(radLat) * cos(radLon), sin(radLat), cos(radLat) * sin(radLon));
+	// web mercator, the caps it does not reach keep the grid uv
+	vec2 mercator = uv;
+	if (abs(lat) < 85.0)
+		mercator = (vec2(radLon, log(tan(PI / 4.0 + radLat / 2.0))) / PI + 1.0) * 0.5;
+
+	gl_Position = projection * view * model * vec4(mix(vec3(grid, 0.0), sphere, transformScale), 1.0);
+	vColor = vec3(0.0);
+	vTexCoord = mix(uv, mercator, transformScale);
+}
@@ -8,6 +8,9 @@
 #extension GL_KHR_shader_subgroup_arithmetic : enable
 #extension GL_KHR_shader_subgroup_ballot : enable
 
+// SHARED_MEMORY_SCAN: scans the bins in shared memory instead of with subgroup operations, defined by
+// the host when subgroups are unsupported or narrower than SUBGROUP_SIZE (e.g. Mesa llvmpipe)
+
 #define WORKGROUP_SIZE 256// assert WORKGROUP_SIZE >= RADIX_SORT_BINS
 #define RADIX_SORT_BINS 256
 #define SUBGROUP_SIZE 32// 32 NVIDIA; 64 AMD
@@ -42,7 +45,11 @@ layout(std430, binding = 4) buffer histograms {
 	uint g_histograms[];// |g_histograms| = RADIX_SORT_BINS * #WORKGROUPS = RADIX_SORT_BINS * g_num_workgroups
 };
 
+#ifdef SHARED_MEMORY_SCAN
+shared uint[RADIX_SORT_BINS] scan;// inclusive scan of the bin counts
+#else
 shared uint[RADIX_SORT_BINS / SUBGROUP_SIZE] sums;// subgroup reductions
+#endif
 shared uint[RADIX_SORT_BINS] global_offsets;// global exclusive scan (prefix sum)
 
 struct BinFlags {
@@ -54,8 +61,6 @@ void main() {
 	uint gID = gl_GlobalInvocationID.x;
 	uint lID = gl_LocalInvocationID.x;
 	uint wID = gl_WorkGroupID.x;
-	uint sID = gl_SubgroupID;
-	uint lsID = gl_SubgroupInvocationID;
 
 	uint local_histogram = 0;
 	uint prefix_sum = 0;
@@ -69,20 +74,40 @@ void main() {
 			count += t;
 		}
 		histogram_count = count;
+#ifdef SHARED_MEMORY_SCAN
+		scan[lID] = count;
+#else
 		const uint sum = subgroupAdd(histogram_count);
 		prefix_sum = subgroupExclusiveAdd(histogram_count);
 		if (subgroupElect()) {
 			// one thread inside the warp/subgroup enters this section
-			sums[sID] = sum;
+			sums[gl_SubgroupID] = sum;
 		}
+#endif
 	}
 	barrier();
 
+#ifdef SHARED_MEMORY_SCAN
+	// Hillis-Steele scan, log2(RADIX_SORT_BINS) steps
+	for (uint offset = 1; offset < RADIX_SORT_BINS; offset <<= 1) {
+		uint value = (lID < RADIX_SORT_BINS && lID >= offset) ? scan[lID - offset] : 0U;
+		barrier();
+		if (lID < RADIX_SORT_BINS) {
+			scan[lID] += value;
+		}
+		barrier();
+	}
+
+	if (lID < RADIX_SORT_BINS) {
+		global_offsets[lID] = scan[lID] - histogram_count + local_histogram;
+	}
+#else
 	if (lID < RADIX_SORT_BINS) {
-		const uint sums_prefix_sum = subgroupBroadcast(subgroupExclusiveAdd(sums[lsID]), sID);
+		const uint sums_prefix_sum = subgroupBroadcast(subgroupExclusiveAdd(sums[gl_SubgroupInvocationID]), gl_SubgroupID);
 		const uint global_histogram = sums_prefix_sum + prefix_sum;
 		global_offsets[lID] = global_histogram + local_histogram;
 	}
+#endif
 
 	//     ==== scatter keys according to global offsets =====
 	const uint flags_bin = lID / BITS;
@@ -0,0 +1,239 @@
+#include "batch_renderer.h"
+#include "camera.h"
+#include "../render_objs/gs_ply_obj.h"
+#include "../utils/gpu_memory.h"
+
+#include <filesystem>
+#include <chrono>
+#include <cstring>
+#include <cfloat>
+#include <format>
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "stb/stb_image_write.h"
+
+BatchRenderer::BatchRenderer(size_t writerCount)
+{
+	m_writers = std::make_unique<ThreadPool>(writerCount);
+	for (auto& readback : m_readbacks) {
+		glGenBuffers(1, &readback.pbo);
+	}
+	m_texParams.minFilter = FilterType::Nearest;
+	m_texParams.magFilter = FilterType::Nearest;
+	m_texParams.sWrap = WrapType::ClampToEdge;
+	m_texParams.tWrap = WrapType::ClampToEdge;
+}
+
+BatchRenderer::~BatchRenderer()
+{
+	WaitWriters(0);
+	for (auto& readback : m_readbacks) {
+		if (readback.fence)
+			glDeleteSync(readback.fence);
+		GpuMemoryTracker::GetInstance()->Release(GpuMemoryTracker::Kind::Buffer, readback.pbo);
+		glDeleteBuffers(1, &readback.pbo);
+	}
+}
+
+void BatchRenderer::OrderViews(std::vector<Parser::CameraConfig>& cameras)
+{
+	if (cameras.size() < 3)
+		return;
+
+	// normalise the translation by the extent of the capture so it weighs like the view angle
+	glm::vec3 minPos(FLT_MAX), maxPos(-FLT_MAX);
+	for (const auto& camera : cameras) {
+		minPos = (glm::min)(minPos, camera.position);
+		maxPos = (glm::max)(maxPos, camera.position);
+	}
+	float sceneScale = (std::max)(glm::length(maxPos - minPos), 1e-6f);
+
+	// greedy nearest neighbour tour starting from the first view
+	std::vector<Parser::CameraConfig> ordered;
+	ordered.reserve(cameras.size());
+	std::vector<bool> visited(cameras.size(), false);
+	size_t current = 0;
+	visited[current] = true;
+	ordered.push_back(cameras[current]);
+	for (size_t step = 1; step < cameras.size(); step++) {
+		size_t best = 0;
+		float bestCost = FLT_MAX;
+		for (size_t i = 0; i < cameras.size(); i++) {
+			if (visited[i])
+				continue;
+			float translation = glm::length(cameras[i].position - cameras[current].position) / sceneScale;
+			float rotation = 1.0f - glm::dot(cameras[i].rotation[2], cameras[current].rotation[2]);
+			float cost = translation + rotation;
+			if (cost < bestCost) {
+				bestCost = cost;
+				best = i;
+			}
+		}
+		visited[best] = true;
+		current = best;
+		ordered.push_back(cameras[current]);
+	}
+	cameras.swap(ordered);
+}
+
+size_t BatchRenderer::Run(std::vector<Parser::CameraConfig> cameras, const std::string& outputDir, const std::function<void()>& drawScene, const float* clearColor)
+{
+	auto camera = Camera::GetInstance();
+	auto gsCamera = Renderable::Base3DGSCamera::GetInstance();
+	Camera::CameraState savedState = camera->GetState();
+	glm::vec4 savedIntrinsics(gsCamera->GetFx(), gsCamera->GetFy(), gsCamera->GetWidth(), gsCamera->GetHeight());
+
+	std::filesystem::create_directories(outputDir);
+	OrderViews(cameras);
+	auto start = std::chrono::high_resolution_clock::now();
+
+	size_t written = Render(cameras.size(), [this, &cameras, &outputDir](size_t i) {
+		const auto& view = cameras[i];
+		ApplyCamera(view);
+		return ViewTarget{ view.width, view.height, (std::filesystem::path(outputDir) / (view.imageName + ".png")).string() };
+		}, drawScene, clearColor);
+
+	camera->SetState(savedState);
+	gsCamera->SetIntrinsics(savedIntrinsics.x, savedIntrinsics.y, savedIntrinsics.z, savedIntrinsics.w);
+	glViewport(0, 0, savedState.screenWidth, savedState.screenHeight);
+
+	float seconds = std::chrono::duration<float>(std::chrono::high_resolution_clock::now() - start).count();
+	std::cout << std::format("Batch rendered {} / {} views to {} in {:.2f} s ({:.1f} views/s)",
+		written, cameras.size(), outputDir, seconds, cameras.size() / (std::max)(seconds, 1e-6f)) << std::endl;
+	return written;
+}
+
+size_t BatchRenderer::RunFrames(size_t frameCount, int width, int height, const std::string& outputDir,
+	const std::function<void(size_t)>& prepareFrame, const std::function<void()>& drawScene, const float* clearColor)
+{
+	std::filesystem::create_directories(outputDir);
+	auto start = std::chrono::high_resolution_clock::now();
+
+	size_t written = Render(frameCount, [&](size_t i) {
+		prepareFrame(i);
+		return ViewTarget{ width, height, (std::filesystem::path(outputDir) / std::format("frame_{:05d}.png", i)).string() };
+		}, drawScene, clearColor);
+
+	float seconds = std::chrono::duration<float>(std::chrono::high_resolution_clock::now() - start).count();
+	std::cout << std::format("Rendered {} / {} frames to {} in {:.2f} s ({:.1f} frames/s)",
+		written, frameCount, outputDir, seconds, frameCount / (std::max)(seconds, 1e-6f)) << std::endl;
+	return written;
+}
+
+size_t BatchRenderer::Render(size_t viewCount, const std::function<ViewTarget(size_t)>& prepareView, const std::function<void()>& drawScene, const float* clearColor)
+{
+	m_written = 0;
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	for (size_t i = 0; i < viewCount; i++) {
+		Readback& readback = m_readbacks[i % READBACK_COUNT];
+		if (readback.fence)
+			Collect(readback);
+
+		ViewTarget view = prepareView(i);
+		SetUpTarget(view.width, view.height);
+		m_fbo->Bind();
+		glViewport(0, 0, view.width, view.height);
+		glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+		drawScene();
+
+		// queue the copy into a pixel pack buffer and collect it READBACK_COUNT views later
+		size_t size = static_cast<size_t>(view.width) * view.height * 3;
+		m_fbo->Bind();
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.pbo);
+		if (readback.capacity < size) {
+			GpuMemoryTracker::GetInstance()->Allocate(GpuMemoryTracker::Kind::Buffer, readback.pbo, size, "readback buffer");
+			glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+			readback.capacity = size;
+		}
+		glReadPixels(0, 0, view.width, view.height, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		readback.width = view.width;
+		readback.height = view.height;
+		readback.path = std::move(view.path);
+	}
+
+	for (size_t i = 0; i < READBACK_COUNT; i++) {
+		Readback& readback = m_readbacks[(viewCount + i) % READBACK_COUNT];
+		if (readback.fence)
+			Collect(readback);
+	}
+	WaitWriters(0);
+	if (m_fbo)
+		m_fbo->Unbind();
+	return m_written;
+}
+
+void BatchRenderer::ApplyCamera(const Parser::CameraConfig& view)
+{
+	// COLMAP cameras look down +z with y pointing down, the viewer looks down -z with y up
+	glm::vec3 front = view.rotation[2];
+	glm::vec3 up = -view.rotation[1];
+	float fov = glm::degrees(2.0f * std::atan(0.5f * view.height / view.fy));
+	Camera::GetInstance()->SetState({ view.position, front, up, fov, view.width, view.height });
+	Renderable::Base3DGSCamera::GetInstance()->SetIntrinsics(view.fx, view.fy, static_cast<float>(view.width), static_cast<float>(view.height));
+}
+
+void BatchRenderer::SetUpTarget(int width, int height)
+{
+	if (m_fbo == nullptr) {
+		m_fbo = std::make_shared<FrameBuffer>();
+		m_colorTexture = std::make_shared<Texture>(1);
+		m_depthTexture = std::make_shared<Texture>(1);
+		m_colorTexture->GenerateTexture(width, height, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, m_texParams, nullptr);
+		m_depthTexture->GenerateTexture(width, height, GL_DEPTH_COMPONENT24, GL_DEPTH_COMPONENT, GL_FLOAT, m_texParams, nullptr);
+	}
+	else if (width != m_width || height != m_height) {
+		m_colorTexture->UpdateTexture(0, width, height, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, m_texParams, nullptr);
+		m_depthTexture->UpdateTexture(0, width, height, GL_DEPTH_COMPONENT24, GL_DEPTH_COMPONENT, GL_FLOAT, m_texParams, nullptr);
+	}
+	else {
+		return;
+	}
+	m_fbo->AttachColor(m_colorTexture);
+	m_fbo->AttachDepth(m_depthTexture);
+	m_width = width;
+	m_height = height;
+}
+
+void BatchRenderer::Collect(Readback& readback)
+{
+	while (glClientWaitSync(readback.fence, GL_SYNC_FLUSH_COMMANDS_BIT, UINT64_MAX) == GL_TIMEOUT_EXPIRED) {}
+	glDeleteSync(readback.fence);
+	readback.fence = nullptr;
+
+	// flip while copying out of the mapped buffer, GL rows start at the bottom
+	const size_t rowSize = static_cast<size_t>(readback.width) * 3;
+	auto pixels = std::make_shared<std::vector<uint8_t>>(rowSize * readback.height);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.pbo);
+	auto* mapped = static_cast<const uint8_t*>(glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, pixels->size(), GL_MAP_READ_BIT));
+	if (mapped) {
+		for (int row = 0; row < readback.height; row++) {
+			std::memcpy(pixels->data() + row * rowSize, mapped + (readback.height - 1 - row) * rowSize, rowSize);
+		}
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	if (!mapped) {
+		std::cerr << std::format("Failed to read back {}", readback.path) << std::endl;
+		return;
+	}
+
+	// bound the number of decoded frames waiting for the encoder
+	WaitWriters(m_writers->GetThreadCount() * 2);
+	m_pendingWrites.push_back(m_writers->Enqueue([pixels, width = readback.width, height = readback.height, path = readback.path]() {
+		bool success = stbi_write_png(path.c_str(), width, height, 3, pixels->data(), width * 3) != 0;
+		if (!success)
+			std::cerr << std::format("Failed to write {}", path) << std::endl;
+		return success;
+		}));
+}
+
+void BatchRenderer::WaitWriters(size_t maxInFlight)
+{
+	while (m_pendingWrites.size() > maxInFlight) {
+		if (m_pendingWrites.front().get())
+			m_written++;
+		m_pendingWrites.pop_front();
+	}
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <deque>
+#include <future>
+#include <functional>
+#include <memory>
+#include <glad/glad.h>
+#include "framebuffer.h"
+#include "texture.h"
+#include "../parser/config_parser.h"
+#include "../threadpool/threadpool.h"
+
+// Renders every view of a camera set, or a number of frames in headless mode, into png files in one pass.
+// The scene stays resident, views are visited in nearest neighbour order so consecutive sorts
+// see similar depth orders, pixels come back through a ring of pixel pack buffers and the png
+// encoding runs on worker threads while the GPU renders the next views.
+class BatchRenderer
+{
+public:
+	explicit BatchRenderer(size_t writerCount = (std::max)(std::thread::hardware_concurrency() / 2, 1u));
+	~BatchRenderer();
+	// returns the number of images written
+	size_t Run(std::vector<Parser::CameraConfig> cameras, const std::string& outputDir, const std::function<void()>& drawScene, const float* clearColor);
+	// frameCount frames of width x height into outputDir/frame_00000.png ..., prepareFrame sets up the camera of each frame
+	size_t RunFrames(size_t frameCount, int width, int height, const std::string& outputDir,
+		const std::function<void(size_t)>& prepareFrame, const std::function<void()>& drawScene, const float* clearColor);
+	static void OrderViews(std::vector<Parser::CameraConfig>& cameras);
+
+private:
+	struct ViewTarget {
+		int width = 0;
+		int height = 0;
+		std::string path = "";
+	};
+
+	struct Readback {
+		GLuint pbo = 0;
+		GLsync fence = nullptr;
+		size_t capacity = 0;
+		int width = 0;
+		int height = 0;
+		std::string path = "";
+	};
+
+	size_t Render(size_t viewCount, const std::function<ViewTarget(size_t)>& prepareView, const std::function<void()>& drawScene, const float* clearColor);
+	void ApplyCamera(const Parser::CameraConfig& camera);
+	void SetUpTarget(int width, int height);
+	void Collect(Readback& readback);
+	void WaitWriters(size_t maxInFlight);
+
+private:
+	static constexpr size_t READBACK_COUNT = 3;
+	std::unique_ptr<ThreadPool> m_writers = nullptr;
+	std::deque<std::future<bool>> m_pendingWrites{};
+	Readback m_readbacks[READBACK_COUNT];
+	std::shared_ptr<FrameBuffer> m_fbo = nullptr;
+	std::shared_ptr<Texture> m_colorTexture = nullptr;
+	std::shared_ptr<Texture> m_depthTexture = nullptr;
+	Texture::Params m_texParams;
+	int m_width = 0;
+	int m_height = 0;
+	size_t m_written = 0;
+};
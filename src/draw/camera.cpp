@@ -292,6 +292,37 @@ void Camera::UpdatePerspectiveProjectionMatrix()
 	m_prospProjMat = glm::perspective(glm::radians(m_fov), m_screenAspectRate, m_near, m_far);
 }
 
+Camera::CameraState Camera::GetState() const
+{
+	return { m_position, m_frontVec, m_up_vec, m_fov, m_screenWidth, m_screenHeight };
+}
+
+void Camera::SetState(const CameraState& state)
+{
+	m_position = state.position;
+	m_frontVec = state.front;
+	m_up_vec = state.up;
+	m_fov = state.fov;
+	// the drag keeps orbiting the origin when the recorded camera faced it
+	glm::vec3 front = glm::normalize(state.front);
+	m_sphericalSurfaceRotation = glm::length(m_position) > 0.0f && glm::dot(front, -glm::normalize(m_position)) > 0.9999f;
+	// the euler angles of the restored orientation, so the sliders and the next drag continue from it
+	m_yaw = glm::degrees(std::atan2(front.z, front.x));
+	m_pitch = glm::degrees(std::asin(glm::clamp(front.y, -1.0f, 1.0f)));
+	glm::vec3 right = glm::cross(front, glm::vec3(0.0f, 1.0f, 0.0f));
+	if (glm::length(right) > 1e-6f) {
+		glm::vec3 levelUp = glm::cross(glm::normalize(right), front);
+		m_roll = glm::degrees(std::atan2(glm::dot(glm::cross(levelUp, state.up), front), glm::dot(levelUp, state.up)));
+	}
+	else
+		m_roll = 0.0f;
+	UpdateViewMatrix();
+	if (state.screenWidth != m_screenWidth || state.screenHeight != m_screenHeight)
+		ProcessFramebufferSizeCallback(state.screenWidth, state.screenHeight);
+	else
+		UpdatePerspectiveProjectionMatrix();
+}
+
 void Camera::ProcessFramebufferSizeCallback(int width, int height)
 {
 	m_screenHeight = height;
@@ -49,6 +49,16 @@ public:
 		ORTHOGONAL
 	};
 
+	// everything needed to reproduce a rendered frame, used by camera path recording and replay
+	struct CameraState {
+		glm::vec3 position;
+		glm::vec3 front;
+		glm::vec3 up;
+		float fov;
+		int screenWidth;
+		int screenHeight;
+	};
+
 	static std::shared_ptr<Camera> GetInstance();
 	Camera() : Camera(m_position, m_up_vec) {}
 	// constructor with vectors
@@ -73,6 +83,8 @@ public:
 	int GetScreenWidth()const { return m_screenWidth; }
 	int GetScreenHeight()const { return m_screenHeight; }
 	CameraProjMethod GetCameraProj() const { return m_cameraProjMethod; }
+	CameraState GetState() const;
+	void SetState(const CameraState& state);
 	void UpdateViewMatrix();
 	void UpdateOrthogonalProjectionMatrix();
 	void UpdatePerspectiveProjectionMatrix();
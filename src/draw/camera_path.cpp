@@ -0,0 +1,223 @@
+#include "camera_path.h"
+
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <format>
+#include <algorithm>
+#include <numeric>
+#include <cstdio>
+#include <imgui/imgui.h>
+#include <rapidjson/document.h>
+#include <rapidjson/prettywriter.h>
+#include <rapidjson/stringbuffer.h>
+
+namespace {
+void WriteVec3(rapidjson::PrettyWriter<rapidjson::StringBuffer>& writer, const char* key, const glm::vec3& value)
+{
+	writer.Key(key);
+	writer.StartArray();
+	writer.Double(value.x);
+	writer.Double(value.y);
+	writer.Double(value.z);
+	writer.EndArray();
+}
+
+bool ReadVec3(const rapidjson::Value& json, const char* key, glm::vec3& value)
+{
+	if (!json.HasMember(key) || !json[key].IsArray() || json[key].Size() != 3)
+		return false;
+	const auto& arr = json[key];
+	for (rapidjson::SizeType i = 0; i < 3; i++) {
+		if (!arr[i].IsNumber())
+			return false;
+		value[i] = arr[i].GetFloat();
+	}
+	return true;
+}
+}
+
+void CameraPath::SetPath(const std::string& path)
+{
+	m_path = path;
+	std::snprintf(m_pathBuffer, sizeof(m_pathBuffer), "%s", path.c_str());
+}
+
+void CameraPath::StartRecording()
+{
+	m_frames.clear();
+	m_mode = RECORDING;
+}
+
+void CameraPath::StopRecording()
+{
+	if (m_mode == RECORDING)
+		m_mode = IDLE;
+}
+
+void CameraPath::Record(const Camera::CameraState& state)
+{
+	if (m_mode == RECORDING)
+		m_frames.push_back(state);
+}
+
+bool CameraPath::Save() const
+{
+	rapidjson::StringBuffer buffer;
+	rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(buffer);
+	writer.StartObject();
+	writer.Key("timestep");
+	writer.Double(m_timestep);
+	writer.Key("frames");
+	writer.StartArray();
+	for (const auto& frame : m_frames) {
+		writer.StartObject();
+		WriteVec3(writer, "position", frame.position);
+		WriteVec3(writer, "front", frame.front);
+		WriteVec3(writer, "up", frame.up);
+		writer.Key("fov");
+		writer.Double(frame.fov);
+		writer.Key("width");
+		writer.Int(frame.screenWidth);
+		writer.Key("height");
+		writer.Int(frame.screenHeight);
+		writer.EndObject();
+	}
+	writer.EndArray();
+	writer.EndObject();
+
+	std::ofstream ofs(m_path);
+	if (!ofs.is_open()) {
+		std::cerr << std::format("Error occured while opening {}", m_path) << std::endl;
+		return false;
+	}
+	ofs << buffer.GetString();
+	std::cout << std::format("Saved {} camera frames to {}", m_frames.size(), m_path) << std::endl;
+	return true;
+}
+
+bool CameraPath::Load()
+{
+	std::ifstream ifs(m_path);
+	if (!ifs.is_open()) {
+		std::cerr << std::format("Error occured while opening {}", m_path) << std::endl;
+		return false;
+	}
+	std::stringstream buffer;
+	buffer << ifs.rdbuf();
+	rapidjson::Document document;
+	document.Parse(buffer.str().c_str());
+	if (document.HasParseError() || !document.IsObject() || !document.HasMember("frames") || !document["frames"].IsArray()) {
+		std::cerr << std::format("{} is not a camera path file", m_path) << std::endl;
+		return false;
+	}
+
+	std::vector<Camera::CameraState> frames;
+	for (const auto& frame : document["frames"].GetArray()) {
+		Camera::CameraState state{};
+		if (!frame.IsObject() || !ReadVec3(frame, "position", state.position) || !ReadVec3(frame, "front", state.front) || !ReadVec3(frame, "up", state.up) ||
+			!frame.HasMember("fov") || !frame["fov"].IsNumber() || !frame.HasMember("width") || !frame["width"].IsInt() ||
+			!frame.HasMember("height") || !frame["height"].IsInt() || frame["width"].GetInt() <= 0 || frame["height"].GetInt() <= 0) {
+			std::cerr << std::format("Malformed frame {} in {}", frames.size(), m_path) << std::endl;
+			return false;
+		}
+		state.fov = frame["fov"].GetFloat();
+		state.screenWidth = frame["width"].GetInt();
+		state.screenHeight = frame["height"].GetInt();
+		frames.push_back(state);
+	}
+	if (document.HasMember("timestep") && document["timestep"].IsNumber())
+		m_timestep = document["timestep"].GetFloat();
+	m_frames = std::move(frames);
+	m_mode = IDLE;
+	return true;
+}
+
+bool CameraPath::StartReplay()
+{
+	if (m_frames.empty())
+		return false;
+	m_replayFrame = 0;
+	m_frameTimes.clear();
+	m_frameTimes.reserve(m_frames.size());
+	m_mode = REPLAYING;
+	return true;
+}
+
+bool CameraPath::NextFrame(Camera::CameraState& state)
+{
+	if (m_mode != REPLAYING)
+		return false;
+	if (m_replayFrame >= m_frames.size()) {
+		m_mode = IDLE;
+		return false;
+	}
+	state = m_frames[m_replayFrame++];
+	return true;
+}
+
+void CameraPath::RecordFrameTime(float milliseconds)
+{
+	m_frameTimes.push_back(milliseconds);
+}
+
+float CameraPath::GetPercentile(std::vector<float> frameTimes, float percentile) const
+{
+	size_t nth = static_cast<size_t>(percentile * (frameTimes.size() - 1));
+	std::nth_element(frameTimes.begin(), frameTimes.begin() + nth, frameTimes.end());
+	return frameTimes[nth];
+}
+
+bool CameraPath::SaveTimings() const
+{
+	if (m_frameTimes.empty())
+		return false;
+
+	std::string path = m_path + ".timings.csv";
+	std::ofstream ofs(path);
+	if (!ofs.is_open()) {
+		std::cerr << std::format("Error occured while opening {}", path) << std::endl;
+		return false;
+	}
+	ofs << "frame,ms\n";
+	for (size_t i = 0; i < m_frameTimes.size(); i++) {
+		ofs << std::format("{},{:.4f}\n", i, m_frameTimes[i]);
+	}
+
+	float mean = std::accumulate(m_frameTimes.begin(), m_frameTimes.end(), 0.0f) / m_frameTimes.size();
+	std::cout << std::format("Replayed {} frames: mean {:.3f} ms, p50 {:.3f} ms, p95 {:.3f} ms, p99 {:.3f} ms -> {}",
+		m_frameTimes.size(), mean, GetPercentile(m_frameTimes, 0.5f), GetPercentile(m_frameTimes, 0.95f), GetPercentile(m_frameTimes, 0.99f), path) << std::endl;
+	return true;
+}
+
+void CameraPath::ImGuiCallback()
+{
+	static bool isFolded = true;
+	if (ImGui::CollapsingHeader("Camera Path", &isFolded, ImGuiTreeNodeFlags_DefaultOpen))  // default open
+	{
+		if (ImGui::InputText("Path File", m_pathBuffer, sizeof(m_pathBuffer)))
+			m_path = m_pathBuffer;
+
+		if (m_mode == RECORDING) {
+			if (ImGui::Button("Stop Recording"))
+				StopRecording();
+		}
+		else if (m_mode == IDLE && ImGui::Button("Record")) {
+			StartRecording();
+		}
+		ImGui::SameLine();
+		if (ImGui::Button("Save") && m_mode == IDLE)
+			Save();
+		ImGui::SameLine();
+		if (ImGui::Button("Load") && m_mode == IDLE)
+			Load();
+		ImGui::SameLine();
+		if (ImGui::Button("Replay") && m_mode == IDLE)
+			StartReplay();
+
+		if (m_mode == REPLAYING)
+			ImGui::Text("Replaying frame %zu / %zu", m_replayFrame, m_frames.size());
+		else
+			ImGui::Text("%zu frames, timestep %.4f s", m_frames.size(), m_timestep);
+	}
+}
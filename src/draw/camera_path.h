@@ -0,0 +1,48 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <memory>
+#include "camera.h"
+
+// Records the camera state of every frame and replays it with a fixed timestep, so frame time
+// comparisons between sorters or quality settings run over exactly the same views.
+class CameraPath
+{
+public:
+	enum MODE : uint32_t {
+		IDLE,
+		RECORDING,
+		REPLAYING
+	};
+
+	MODE GetMode() const { return m_mode; }
+	float GetTimestep() const { return m_timestep; }
+	size_t GetFrameCount() const { return m_frames.size(); }
+	const std::string& GetPath() const { return m_path; }
+	void SetPath(const std::string& path);
+
+	void StartRecording();
+	void StopRecording();
+	void Record(const Camera::CameraState& state);
+	bool Save() const;
+	bool Load();
+	bool StartReplay();
+	// returns false and leaves replay mode once every recorded frame has been consumed
+	bool NextFrame(Camera::CameraState& state);
+	void RecordFrameTime(float milliseconds);
+	// per-frame timings of the last replay as csv, followed by a summary on stdout
+	bool SaveTimings() const;
+	void ImGuiCallback();
+
+private:
+	float GetPercentile(std::vector<float> frameTimes, float percentile) const;
+
+private:
+	MODE m_mode = IDLE;
+	float m_timestep = 1.0f / 60.0f;
+	size_t m_replayFrame = 0;
+	std::string m_path = "./camera_path.json";
+	char m_pathBuffer[256] = "./camera_path.json";
+	std::vector<Camera::CameraState> m_frames{};
+	std::vector<float> m_frameTimes{};
+};
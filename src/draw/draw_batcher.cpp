@@ -0,0 +1,254 @@
+#include "draw_batcher.h"
+#include "gl_state_cache.h"
+#include "../utils/gpu_memory.h"
+
+#include <cstring>
+#include <format>
+#include <algorithm>
+#include <iostream>
+#include <imgui/imgui.h>
+
+std::shared_ptr<DrawBatcher> DrawBatcher::GetInstance()
+{
+	static std::mutex mutex;
+	std::lock_guard<std::mutex> lock(mutex);
+	if (m_instance == nullptr) {
+		m_instance = std::make_shared<DrawBatcher>();
+	}
+	return m_instance;
+}
+
+DrawBatcher::~DrawBatcher()
+{
+	for (auto& batch : m_batches) {
+		if (batch.vao == 0)
+			continue;
+		GLStateCache::GetInstance()->OnDeleteVertexArray(batch.vao);
+		glDeleteVertexArrays(1, &batch.vao);
+		GLuint buffers[] = { batch.vertexBuffer.id, batch.indexBuffer.id, batch.commandBuffer.id, batch.transformBuffer.id };
+		for (GLuint buffer : buffers) {
+			GpuMemoryTracker::GetInstance()->Release(GpuMemoryTracker::Kind::Buffer, buffer);
+		}
+		glDeleteBuffers(4, buffers);
+	}
+}
+
+bool DrawBatcher::IsSupported()
+{
+	if (m_supported < 0) {
+		GLint major = 0, minor = 0, extensionCount = 0;
+		glGetIntegerv(GL_MAJOR_VERSION, &major);
+		glGetIntegerv(GL_MINOR_VERSION, &minor);
+		glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+		// GL 4.6 made draw parameters core as gl_DrawID, the batch shaders are #version 430 and read gl_DrawIDARB,
+		// which only exists where the extension is advertised
+		bool hasDrawParameters = false;
+		for (GLint i = 0; i < extensionCount && !hasDrawParameters; i++) {
+			const char* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+			hasDrawParameters = extension && std::strcmp(extension, "GL_ARB_shader_draw_parameters") == 0;
+		}
+		bool hasMultiDrawIndirect = (major > 4 || (major == 4 && minor >= 3)) && glMultiDrawElementsIndirect != nullptr && glMultiDrawArraysIndirect != nullptr;
+		m_supported = hasDrawParameters && hasMultiDrawIndirect ? 1 : 0;
+		if (!m_supported)
+			std::cerr << "Draw batching is disabled, it needs GL 4.3 and GL_ARB_shader_draw_parameters" << std::endl;
+	}
+	return m_supported == 1;
+}
+
+uint32_t DrawBatcher::Register(const Key& key, const void* vertices, uint32_t vertexCount, const std::vector<uint32_t>& indices)
+{
+	if (!IsSupported() || vertexCount == 0 || vertexCount > MAX_MESH_VERTICES || key.vertexSize == 0)
+		return 0;
+
+	bool indexed = !indices.empty();
+	std::string signature = GetSignature(key, indexed);
+	auto it = m_batchIndex.find(signature);
+	if (it == m_batchIndex.end()) {
+		m_batches.emplace_back();
+		m_batches.back().key = key;
+		m_batches.back().indexed = indexed;
+		CreateBatch(m_batches.back());
+		it = m_batchIndex.emplace(signature, m_batches.size() - 1).first;
+	}
+
+	uint32_t id = m_nextId++;
+	Mesh& mesh = m_meshes[id];
+	mesh.batch = it->second;
+	const uint8_t* bytes = static_cast<const uint8_t*>(vertices);
+	mesh.vertices.assign(bytes, bytes + static_cast<size_t>(vertexCount) * key.vertexSize);
+	mesh.indices = indices;
+	mesh.vertexCount = vertexCount;
+	Batch& batch = m_batches[mesh.batch];
+	batch.meshes.push_back(id);
+	batch.dirty = true;
+	return id;
+}
+
+void DrawBatcher::Unregister(uint32_t id)
+{
+	auto it = m_meshes.find(id);
+	if (it == m_meshes.end())
+		return;
+	Batch& batch = m_batches[it->second.batch];
+	std::erase(batch.meshes, id);
+	batch.dirty = true;
+	m_meshes.erase(it);
+}
+
+void DrawBatcher::Submit(uint32_t id, const glm::mat4& model)
+{
+	auto it = m_meshes.find(id);
+	if (it == m_meshes.end())
+		return;
+	Batch& batch = m_batches[it->second.batch];
+	if (batch.dirty)
+		RebuildBatch(batch);
+	const Mesh& mesh = it->second;
+	if (batch.indexed)
+		batch.commands.push_back({ static_cast<GLuint>(mesh.indices.size()), 1, mesh.firstIndex, mesh.baseVertex, 0 });
+	else
+		batch.arrayCommands.push_back({ mesh.vertexCount, 1, static_cast<GLuint>(mesh.baseVertex), 0 });
+	batch.transforms.push_back(model);
+	m_submitCount++;
+}
+
+void DrawBatcher::Flush()
+{
+	auto glState = GLStateCache::GetInstance();
+	for (auto& batch : m_batches) {
+		if (batch.transforms.empty())
+			continue;
+		if (batch.indexed)
+			Upload(batch.commandBuffer, GL_DRAW_INDIRECT_BUFFER, batch.commands.data(), batch.commands.size() * sizeof(DrawElementsIndirectCommand));
+		else
+			Upload(batch.commandBuffer, GL_DRAW_INDIRECT_BUFFER, batch.arrayCommands.data(), batch.arrayCommands.size() * sizeof(DrawArraysIndirectCommand));
+		Upload(batch.transformBuffer, GL_SHADER_STORAGE_BUFFER, batch.transforms.data(), batch.transforms.size() * sizeof(glm::mat4));
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, BATCH_TRANSFORM_BINDING, batch.transformBuffer.id);
+
+		batch.shader->Use();
+		if (batch.key.lineWidth > 0.0f)
+			glState->LineWidth(batch.key.lineWidth);
+		if (batch.key.pointSize > 0.0f)
+			glState->PointSize(batch.key.pointSize);
+		glState->BindVertexArray(batch.vao);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, batch.commandBuffer.id);
+		GLsizei drawCount = static_cast<GLsizei>(batch.transforms.size());
+		if (batch.indexed)
+			glMultiDrawElementsIndirect(batch.key.primitive, GL_UNSIGNED_INT, nullptr, drawCount, 0);
+		else
+			glMultiDrawArraysIndirect(batch.key.primitive, nullptr, drawCount, 0);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+		glState->BindVertexArray(0);
+		m_drawCallCount++;
+
+		batch.commands.clear();
+		batch.arrayCommands.clear();
+		batch.transforms.clear();
+	}
+}
+
+void DrawBatcher::BeginFrame()
+{
+	m_lastSubmitCount = m_submitCount;
+	m_lastDrawCallCount = m_drawCallCount;
+	m_submitCount = 0;
+	m_drawCallCount = 0;
+}
+
+void DrawBatcher::ImGuiCallback()
+{
+	static bool isFolded = true;
+	if (ImGui::CollapsingHeader("Draw Batching", &isFolded, ImGuiTreeNodeFlags_DefaultOpen))  // default open
+	{
+		if (!IsSupported()) {
+			ImGui::Text("Not supported by this context");
+			return;
+		}
+		ImGui::Text("%zu meshes in %zu batches", m_meshes.size(), m_batches.size());
+		ImGui::Text("%zu draws submitted in %zu draw calls", m_lastSubmitCount, m_lastDrawCallCount);
+	}
+}
+
+std::string DrawBatcher::GetSignature(const Key& key, bool indexed) const
+{
+	std::string signature = std::format("{}|{}|{}|{}|{}|{}|{}", key.vertexShader, key.fragmentShader, key.primitive, key.vertexSize, key.lineWidth, key.pointSize, indexed);
+	for (const auto& attribute : key.attributes) {
+		signature += std::format("|{},{},{},{},{}", attribute.location, attribute.count, attribute.type, attribute.normalized, attribute.offset);
+	}
+	return signature;
+}
+
+void DrawBatcher::CreateBatch(Batch& batch)
+{
+	batch.shader = std::make_unique<Shader>(batch.key.vertexShader.c_str(), batch.key.fragmentShader.c_str());
+	glGenVertexArrays(1, &batch.vao);
+	GLuint buffers[4];
+	glGenBuffers(4, buffers);
+	batch.vertexBuffer.id = buffers[0];
+	batch.indexBuffer.id = buffers[1];
+	batch.commandBuffer.id = buffers[2];
+	batch.transformBuffer.id = buffers[3];
+
+	auto glState = GLStateCache::GetInstance();
+	glState->BindVertexArray(batch.vao);
+	glBindBuffer(GL_ARRAY_BUFFER, batch.vertexBuffer.id);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, batch.indexBuffer.id);
+	for (const auto& attribute : batch.key.attributes) {
+		glVertexAttribPointer(attribute.location, attribute.count, attribute.type, attribute.normalized, batch.key.vertexSize, reinterpret_cast<void*>(static_cast<uintptr_t>(attribute.offset)));
+		glEnableVertexAttribArray(attribute.location);
+	}
+	glState->BindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void DrawBatcher::RebuildBatch(Batch& batch)
+{
+	// meshes change rarely, so the pools are simply repacked in registration order, each mesh is
+	// written straight from its copy
+	size_t vertexBytes = 0, indexCount = 0;
+	for (uint32_t id : batch.meshes) {
+		Mesh& mesh = m_meshes[id];
+		mesh.baseVertex = static_cast<GLint>(vertexBytes / batch.key.vertexSize);
+		mesh.firstIndex = static_cast<GLuint>(indexCount);
+		vertexBytes += mesh.vertices.size();
+		indexCount += mesh.indices.size();
+	}
+	// the element buffer binding is part of the VAO state
+	GLStateCache::GetInstance()->BindVertexArray(batch.vao);
+	Reserve(batch.vertexBuffer, GL_ARRAY_BUFFER, vertexBytes);
+	for (uint32_t id : batch.meshes) {
+		const Mesh& mesh = m_meshes[id];
+		glBufferSubData(GL_ARRAY_BUFFER, static_cast<GLintptr>(mesh.baseVertex) * batch.key.vertexSize, mesh.vertices.size(), mesh.vertices.data());
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	if (batch.indexed) {
+		Reserve(batch.indexBuffer, GL_ELEMENT_ARRAY_BUFFER, indexCount * sizeof(uint32_t));
+		for (uint32_t id : batch.meshes) {
+			const Mesh& mesh = m_meshes[id];
+			glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, mesh.firstIndex * sizeof(uint32_t), mesh.indices.size() * sizeof(uint32_t), mesh.indices.data());
+		}
+	}
+	GLStateCache::GetInstance()->BindVertexArray(0);
+	batch.dirty = false;
+}
+
+void DrawBatcher::Reserve(Buffer& buffer, GLenum target, size_t size)
+{
+	glBindBuffer(target, buffer.id);
+	if (size <= buffer.capacity)
+		return;
+	buffer.capacity = (std::max)(size, buffer.capacity * 2);
+	// shared by all batched objects, not charged to the one that happens to be drawn
+	GpuMemoryOwnerScope owner(nullptr);
+	GpuMemoryTracker::GetInstance()->Allocate(GpuMemoryTracker::Kind::Buffer, buffer.id, buffer.capacity, "batched mesh buffer");
+	glBufferData(target, buffer.capacity, nullptr, GL_DYNAMIC_DRAW);
+}
+
+void DrawBatcher::Upload(Buffer& buffer, GLenum target, const void* data, size_t size)
+{
+	Reserve(buffer, target, size);
+	if (size > 0)
+		glBufferSubData(target, 0, size, data);
+	if (target != GL_ELEMENT_ARRAY_BUFFER)
+		glBindBuffer(target, 0);
+}
@@ -0,0 +1,123 @@
+#pragma once
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include "shader_s.h"
+
+constexpr GLuint BATCH_TRANSFORM_BINDING = 1;
+
+// Draws meshes that share a program and a vertex format with one glMultiDrawElementsIndirect, or one
+// glMultiDrawArraysIndirect for meshes without indices. The meshes of a batch live in one pooled vertex
+// and index buffer, every submitted draw appends an indirect command and its model matrix, which the batch
+// vertex shader reads from the shader storage block at BATCH_TRANSFORM_BINDING with gl_DrawIDARB.
+// Submissions are drawn in Flush, in submit order. Only small meshes are worth it: a batch keeps a copy of
+// its meshes and repacks them whenever one is registered or removed.
+class DrawBatcher
+{
+public:
+	struct Attribute {
+		GLuint location = 0;
+		GLint count = 0;
+		GLenum type = GL_FLOAT;
+		GLboolean normalized = GL_FALSE;
+		uint32_t offset = 0;  // bytes from the start of the vertex
+	};
+
+	// meshes with equal keys end up in the same batch
+	struct Key {
+		std::string vertexShader = "";
+		std::string fragmentShader = "";
+		GLenum primitive = GL_TRIANGLES;
+		uint32_t vertexSize = 0;
+		std::vector<Attribute> attributes{};
+		float lineWidth = 0.0f;
+		float pointSize = 0.0f;
+	};
+
+	static std::shared_ptr<DrawBatcher> GetInstance();
+	DrawBatcher() = default;
+	~DrawBatcher();
+	DrawBatcher(const DrawBatcher&) = delete;
+	DrawBatcher& operator=(const DrawBatcher&) = delete;
+
+	// multi draw indirect and the advertised GL_ARB_shader_draw_parameters are needed, without them Register always fails
+	bool IsSupported();
+	// returns the id of the mesh, 0 if it cannot be batched or has more than MAX_MESH_VERTICES vertices.
+	// Meshes without indices are drawn in vertex order
+	uint32_t Register(const Key& key, const void* vertices, uint32_t vertexCount, const std::vector<uint32_t>& indices);
+	void Unregister(uint32_t id);
+	void Submit(uint32_t id, const glm::mat4& model);
+	void Flush();
+	// rolls the submit and draw call counters over
+	void BeginFrame();
+	void ImGuiCallback();
+
+	// larger meshes such as point clouds save no draw calls worth the copy, they are drawn directly
+	static constexpr uint32_t MAX_MESH_VERTICES = 1u << 16;
+
+private:
+	struct DrawElementsIndirectCommand {
+		GLuint count;
+		GLuint instanceCount;
+		GLuint firstIndex;
+		GLint baseVertex;
+		GLuint baseInstance;
+	};
+
+	struct DrawArraysIndirectCommand {
+		GLuint count;
+		GLuint instanceCount;
+		GLuint first;
+		GLuint baseInstance;
+	};
+
+	struct Mesh {
+		size_t batch = 0;
+		std::vector<uint8_t> vertices{};
+		std::vector<uint32_t> indices{};  // empty in a batch of non-indexed meshes
+		uint32_t vertexCount = 0;
+		GLint baseVertex = 0;
+		GLuint firstIndex = 0;
+	};
+
+	struct Buffer {
+		GLuint id = 0;
+		size_t capacity = 0;
+	};
+
+	struct Batch {
+		Key key{};
+		bool indexed = true;
+		std::unique_ptr<Shader> shader = nullptr;
+		GLuint vao = 0;
+		Buffer vertexBuffer{}, indexBuffer{}, commandBuffer{}, transformBuffer{};
+		std::vector<uint32_t> meshes{};
+		bool dirty = false;
+		std::vector<DrawElementsIndirectCommand> commands{};
+		std::vector<DrawArraysIndirectCommand> arrayCommands{};  // the commands of a non-indexed batch
+		std::vector<glm::mat4> transforms{};
+	};
+
+	std::string GetSignature(const Key& key, bool indexed) const;
+	void CreateBatch(Batch& batch);
+	void RebuildBatch(Batch& batch);
+	// binds the buffer and grows it geometrically to hold size bytes, the contents are lost when it is reallocated
+	void Reserve(Buffer& buffer, GLenum target, size_t size);
+	// uploads data to the start of the buffer, the storage is only reallocated when it does not fit
+	void Upload(Buffer& buffer, GLenum target, const void* data, size_t size);
+
+private:
+	static inline std::shared_ptr<DrawBatcher> m_instance = nullptr;
+	int m_supported = -1;
+	std::vector<Batch> m_batches{};
+	std::unordered_map<std::string, size_t> m_batchIndex{};
+	std::unordered_map<uint32_t, Mesh> m_meshes{};
+	uint32_t m_nextId = 1;
+	size_t m_submitCount = 0, m_drawCallCount = 0;
+	size_t m_lastSubmitCount = 0, m_lastDrawCallCount = 0;
+};
@@ -0,0 +1,32 @@
+#include "frame_context.h"
+
+void BindFrameContextBlock(GLuint program)
+{
+	GLuint blockIndex = glGetUniformBlockIndex(program, FRAME_CONTEXT_BLOCK);
+	if (blockIndex != GL_INVALID_INDEX)
+		glUniformBlockBinding(program, blockIndex, FRAME_CONTEXT_BINDING);
+}
+
+FrameContextBuffer::FrameContextBuffer()
+{
+	glGenBuffers(1, &m_ubo);
+	glBindBuffer(GL_UNIFORM_BUFFER, m_ubo);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameContext), nullptr, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_CONTEXT_BINDING, m_ubo);
+}
+
+FrameContextBuffer::~FrameContextBuffer()
+{
+	if (m_ubo > 0)
+		glDeleteBuffers(1, &m_ubo);
+}
+
+void FrameContextBuffer::Upload(const FrameContext& frame)
+{
+	glBindBuffer(GL_UNIFORM_BUFFER, m_ubo);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameContext), &frame);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	// rebinding is cheap and survives anything else that touched the indexed binding
+	glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_CONTEXT_BINDING, m_ubo);
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+// Per-frame values shared by every program. Filled once per frame by RenderMain and uploaded as
+// the std140 uniform block "FrameContext", the member order has to match shader/include/frame_context.glsl.
+struct FrameContext
+{
+	glm::mat4 projection = glm::mat4(1.0f);
+	glm::mat4 view = glm::mat4(1.0f);
+	glm::mat4 model = glm::mat4(1.0f);
+	glm::vec4 camPos = glm::vec4(0.0f);  // w unused, keeps the std140 alignment explicit
+	glm::vec2 viewport = glm::vec2(0.0f);
+	glm::vec2 focal = glm::vec2(0.0f);
+	glm::vec2 tanFov = glm::vec2(0.0f);
+	glm::vec2 nearFar = glm::vec2(0.0f);
+};
+static_assert(sizeof(FrameContext) == 240, "FrameContext has to match the std140 layout of the shader block");
+
+constexpr const char* FRAME_CONTEXT_BLOCK = "FrameContext";
+constexpr GLuint FRAME_CONTEXT_BINDING = 0;
+
+// Binds the FrameContext block of a linked program to FRAME_CONTEXT_BINDING, programs without the block are left alone.
+void BindFrameContextBlock(GLuint program);
+
+class FrameContextBuffer
+{
+public:
+	FrameContextBuffer();
+	~FrameContextBuffer();
+	FrameContextBuffer(const FrameContextBuffer&) = delete;
+	FrameContextBuffer& operator=(const FrameContextBuffer&) = delete;
+
+	void Upload(const FrameContext& frame);
+
+private:
+	GLuint m_ubo = 0;
+};
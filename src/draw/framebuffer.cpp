@@ -1,5 +1,6 @@
 #include "./framebuffer.h"
 #include "./texture.h"
+#include "../utils/gpu_memory.h"
 #include <glad/glad.h>
 
 
@@ -28,6 +29,7 @@ void FrameBuffer::AttachColor(std::shared_ptr<Texture> colorTex)
 {
 	Bind();
 	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTex->GetTexture(0), 0);
+	GpuMemoryTracker::GetInstance()->SetLabel(GpuMemoryTracker::Kind::Texture, colorTex->GetTexture(0), "framebuffer color");
 	colorAttachment = colorTex;
 	Unbind();
 
@@ -37,6 +39,7 @@ void FrameBuffer::AttachDepth(std::shared_ptr<Texture> depthTex)
 {
 	Bind();
 	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTex->GetTexture(0), 0);
+	GpuMemoryTracker::GetInstance()->SetLabel(GpuMemoryTracker::Kind::Texture, depthTex->GetTexture(0), "framebuffer depth");
 	depthAttachment = depthTex;
 	Unbind();
 }
@@ -45,6 +48,7 @@ void FrameBuffer::AttachStencil(std::shared_ptr<Texture> stencilTex)
 {
 	Bind();
 	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_STENCIL_ATTACHMENT, GL_TEXTURE_2D, stencilTex->GetTexture(0), 0);
+	GpuMemoryTracker::GetInstance()->SetLabel(GpuMemoryTracker::Kind::Texture, stencilTex->GetTexture(0), "framebuffer stencil");
 	stencilAttachment = stencilTex;
 	Unbind();
 }
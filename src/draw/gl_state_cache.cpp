@@ -0,0 +1,191 @@
+#include "gl_state_cache.h"
+#include <imgui/imgui.h>
+
+std::shared_ptr<GLStateCache> GLStateCache::GetInstance()
+{
+	static std::mutex mutex;
+	std::lock_guard<std::mutex> lock(mutex);
+	if (m_instance == nullptr) {
+		m_instance = std::make_shared<GLStateCache>();
+	}
+	return m_instance;
+}
+
+bool GLStateCache::Update(uint32_t& cached, uint32_t value)
+{
+	if (cached == value) {
+		m_elided++;
+		return false;
+	}
+	cached = value;
+	m_issued++;
+	return true;
+}
+
+bool GLStateCache::Update(float& cached, float value)
+{
+	if (cached == value) {
+		m_elided++;
+		return false;
+	}
+	cached = value;
+	m_issued++;
+	return true;
+}
+
+void GLStateCache::Enable(GLenum cap)
+{
+	auto it = m_capabilities.find(cap);
+	if (it != m_capabilities.end() && it->second) {
+		m_elided++;
+		return;
+	}
+	m_capabilities[cap] = true;
+	m_issued++;
+	glEnable(cap);
+}
+
+void GLStateCache::Disable(GLenum cap)
+{
+	auto it = m_capabilities.find(cap);
+	if (it != m_capabilities.end() && !it->second) {
+		m_elided++;
+		return;
+	}
+	m_capabilities[cap] = false;
+	m_issued++;
+	glDisable(cap);
+}
+
+void GLStateCache::BlendFunc(GLenum sfactor, GLenum dfactor)
+{
+	if (m_blendSrc == sfactor && m_blendDst == dfactor) {
+		m_elided++;
+		return;
+	}
+	m_blendSrc = sfactor;
+	m_blendDst = dfactor;
+	m_issued++;
+	glBlendFunc(sfactor, dfactor);
+}
+
+void GLStateCache::BlendEquationSeparate(GLenum modeRGB, GLenum modeAlpha)
+{
+	if (m_blendEquationRGB == modeRGB && m_blendEquationAlpha == modeAlpha) {
+		m_elided++;
+		return;
+	}
+	m_blendEquationRGB = modeRGB;
+	m_blendEquationAlpha = modeAlpha;
+	m_issued++;
+	glBlendEquationSeparate(modeRGB, modeAlpha);
+}
+
+void GLStateCache::CullFace(GLenum mode)
+{
+	if (Update(m_cullFace, mode))
+		glCullFace(mode);
+}
+
+void GLStateCache::PolygonMode(GLenum mode)
+{
+	if (Update(m_polygonMode, mode))
+		glPolygonMode(GL_FRONT_AND_BACK, mode);
+}
+
+void GLStateCache::LineWidth(float width)
+{
+	if (Update(m_lineWidth, width))
+		glLineWidth(width);
+}
+
+void GLStateCache::PointSize(float size)
+{
+	if (Update(m_pointSize, size))
+		glPointSize(size);
+}
+
+void GLStateCache::UseProgram(GLuint program)
+{
+	if (Update(m_program, program))
+		glUseProgram(program);
+}
+
+void GLStateCache::BindVertexArray(GLuint vao)
+{
+	if (Update(m_vao, vao))
+		glBindVertexArray(vao);
+}
+
+void GLStateCache::ActiveTexture(GLenum texture)
+{
+	if (Update(m_activeTexture, texture))
+		glActiveTexture(texture);
+}
+
+void GLStateCache::BindTexture(GLenum target, GLuint texture)
+{
+	// without a known active unit the binding cannot be attributed to one
+	if (m_activeTexture == UNKNOWN) {
+		m_issued++;
+		glBindTexture(target, texture);
+		return;
+	}
+	uint64_t key = (static_cast<uint64_t>(m_activeTexture) << 32) | target;
+	auto it = m_textureBindings.find(key);
+	if (it != m_textureBindings.end() && it->second == texture) {
+		m_elided++;
+		return;
+	}
+	m_textureBindings[key] = texture;
+	m_issued++;
+	glBindTexture(target, texture);
+}
+
+void GLStateCache::OnDeleteVertexArray(GLuint vao)
+{
+	if (m_vao == vao)
+		m_vao = 0;
+}
+
+void GLStateCache::OnDeleteTexture(GLuint texture)
+{
+	for (auto& [key, bound] : m_textureBindings) {
+		if (bound == texture)
+			bound = 0;
+	}
+}
+
+void GLStateCache::Invalidate()
+{
+	m_capabilities.clear();
+	m_textureBindings.clear();
+	m_blendSrc = m_blendDst = UNKNOWN;
+	m_blendEquationRGB = m_blendEquationAlpha = UNKNOWN;
+	m_cullFace = UNKNOWN;
+	m_polygonMode = UNKNOWN;
+	m_program = UNKNOWN;
+	m_vao = UNKNOWN;
+	m_activeTexture = UNKNOWN;
+	m_lineWidth = -1.0f;
+	m_pointSize = -1.0f;
+}
+
+void GLStateCache::BeginFrame()
+{
+	m_lastIssued = m_issued;
+	m_lastElided = m_elided;
+	m_issued = 0;
+	m_elided = 0;
+}
+
+void GLStateCache::ImGuiCallback()
+{
+	static bool isFolded = true;
+	if (ImGui::CollapsingHeader("GL State", &isFolded, ImGuiTreeNodeFlags_DefaultOpen))  // default open
+	{
+		uint64_t total = m_lastIssued + m_lastElided;
+		ImGui::Text("State calls issued %llu, elided %llu (%.1f%%)", static_cast<unsigned long long>(m_lastIssued),
+			static_cast<unsigned long long>(m_lastElided), total > 0 ? 100.0 * m_lastElided / total : 0.0);
+	}
+}
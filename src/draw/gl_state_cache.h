@@ -0,0 +1,67 @@
+#pragma once
+#include <glad/glad.h>
+
+#include <memory>
+#include <mutex>
+#include <cstdint>
+#include <unordered_map>
+
+// Shadow copy of the GL state set by the render objects, calls that would not change it are dropped.
+// The cache assumes it sees every change of the state it tracks: code that bypasses it, like the ImGui
+// backend, has to be followed by Invalidate so the next call of each kind is issued again.
+class GLStateCache
+{
+public:
+	static std::shared_ptr<GLStateCache> GetInstance();
+	GLStateCache() = default;
+	GLStateCache(const GLStateCache&) = delete;
+	GLStateCache& operator=(const GLStateCache&) = delete;
+
+	void Enable(GLenum cap);
+	void Disable(GLenum cap);
+	void BlendFunc(GLenum sfactor, GLenum dfactor);
+	void BlendEquationSeparate(GLenum modeRGB, GLenum modeAlpha);
+	void CullFace(GLenum mode);
+	void PolygonMode(GLenum mode);
+	void LineWidth(float width);
+	void PointSize(float size);
+	void UseProgram(GLuint program);
+	void BindVertexArray(GLuint vao);
+	void ActiveTexture(GLenum texture);
+	// binds to the active texture unit
+	void BindTexture(GLenum target, GLuint texture);
+	// deleting a bound object resets its binding to 0 behind our back
+	void OnDeleteVertexArray(GLuint vao);
+	void OnDeleteTexture(GLuint texture);
+
+	void Invalidate();
+	// rolls the issued and elided counters over, call once at the start of each frame
+	void BeginFrame();
+	uint64_t GetIssuedCount() const { return m_lastIssued; }
+	uint64_t GetElidedCount() const { return m_lastElided; }
+	void ImGuiCallback();
+
+private:
+	static constexpr uint32_t UNKNOWN = 0xFFFFFFFFu;
+
+	// returns true when the call has to be issued
+	bool Update(uint32_t& cached, uint32_t value);
+	bool Update(float& cached, float value);
+
+private:
+	static inline std::shared_ptr<GLStateCache> m_instance = nullptr;
+	std::unordered_map<GLenum, bool> m_capabilities{};
+	std::unordered_map<uint64_t, GLuint> m_textureBindings{};  // (unit << 32 | target) -> texture
+	uint32_t m_blendSrc = UNKNOWN, m_blendDst = UNKNOWN;
+	uint32_t m_blendEquationRGB = UNKNOWN, m_blendEquationAlpha = UNKNOWN;
+	uint32_t m_cullFace = UNKNOWN;
+	uint32_t m_polygonMode = UNKNOWN;
+	uint32_t m_program = UNKNOWN;
+	uint32_t m_vao = UNKNOWN;
+	uint32_t m_activeTexture = UNKNOWN;
+	float m_lineWidth = -1.0f;
+	float m_pointSize = -1.0f;
+
+	uint64_t m_issued = 0, m_elided = 0;
+	uint64_t m_lastIssued = 0, m_lastElided = 0;
+};
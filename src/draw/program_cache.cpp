@@ -0,0 +1,274 @@
+#include "program_cache.h"
+#include "frame_context.h"
+
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <imgui/imgui.h>
+
+// GL_KHR_parallel_shader_compile is not part of the loaded GL headers, the ARB extension shares its values
+#ifndef GL_MAX_SHADER_COMPILER_THREADS_KHR
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#endif
+typedef void (APIENTRYP PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint count);
+
+namespace {
+	constexpr uint64_t FNV_OFFSET = 14695981039346656037ull;
+	constexpr uint64_t FNV_PRIME = 1099511628211ull;
+
+	uint64_t HashBytes(uint64_t hash, const void* data, size_t size)
+	{
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		for (size_t i = 0; i < size; i++) {
+			hash ^= bytes[i];
+			hash *= FNV_PRIME;
+		}
+		return hash;
+	}
+
+
+	const char* GetStageName(GLenum type)
+	{
+		switch (type) {
+		case GL_VERTEX_SHADER: return "VERTEX";
+		case GL_FRAGMENT_SHADER: return "FRAGMENT";
+		case GL_GEOMETRY_SHADER: return "GEOMETRY";
+		case GL_COMPUTE_SHADER: return "COMPUTE";
+		default: return "UNKNOWN";
+		}
+	}
+}
+
+std::shared_ptr<ProgramCache> ProgramCache::GetInstance()
+{
+	static std::mutex mutex;
+	std::lock_guard<std::mutex> lock(mutex);
+	if (m_instance == nullptr) {
+		m_instance = std::make_shared<ProgramCache>();
+	}
+	return m_instance;
+}
+
+ProgramCache::Program ProgramCache::Get(const ProgramStages& stages)
+{
+	InitDriverInfo();
+	std::string key = GetKey(stages);
+	auto it = m_entries.find(key);
+	if (it != m_entries.end() && !it->second.pending)
+		m_reused++;
+	Entry& entry = it != m_entries.end() ? it->second : Start(key, stages);
+	if (entry.pending)
+		Finish(entry);
+	return { entry.program, entry.uniforms };
+}
+
+void ProgramCache::Prefetch(const std::vector<ProgramStages>& programs)
+{
+	InitDriverInfo();
+	for (const auto& stages : programs) {
+		std::string key = GetKey(stages);
+		if (m_entries.find(key) == m_entries.end())
+			Start(key, stages);
+	}
+}
+
+void ProgramCache::InitDriverInfo()
+{
+	if (m_initialized)
+		return;
+	m_initialized = true;
+
+	auto getString = [](GLenum name) {
+		const char* value = reinterpret_cast<const char*>(glGetString(name));
+		return std::string(value ? value : "");
+	};
+	m_driver = std::format("{}|{}|{}", getString(GL_VENDOR), getString(GL_RENDERER), getString(GL_VERSION));
+
+	GLint formatCount = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+	m_binarySupported = formatCount > 0 && glGetProgramBinary != nullptr && glProgramBinary != nullptr;
+
+	GLint extensionCount = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+	for (GLint i = 0; i < extensionCount; i++) {
+		const char* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+		if (!extension)
+			continue;
+		const char* procName = nullptr;
+		if (std::strcmp(extension, "GL_KHR_parallel_shader_compile") == 0)
+			procName = "glMaxShaderCompilerThreadsKHR";
+		else if (std::strcmp(extension, "GL_ARB_parallel_shader_compile") == 0)
+			procName = "glMaxShaderCompilerThreadsARB";
+		// glfwGetProcAddress would fail in the EGL headless mode, GLFW is never initialized there
+		auto maxThreads = procName && m_procLoader ? reinterpret_cast<PFNGLMAXSHADERCOMPILERTHREADSKHRPROC>(m_procLoader(procName)) : nullptr;
+		if (maxThreads) {
+			// let the driver pick the number of threads
+			maxThreads(0xFFFFFFFF);
+			m_parallelCompile = true;
+			break;
+		}
+	}
+}
+
+std::string ProgramCache::GetKey(const ProgramStages& stages) const
+{
+	std::string key;
+	for (const auto& stage : stages) {
+		key += std::format("{}:{}", stage.type, std::filesystem::path(stage.path).lexically_normal().generic_string());
+		for (const auto& define : stage.defines) {
+			key += std::format(":{}", define);
+		}
+		key += ';';
+	}
+	return key;
+}
+
+ProgramCache::Entry& ProgramCache::Start(const std::string& key, const ProgramStages& stages)
+{
+	auto start = std::chrono::steady_clock::now();
+	Entry& entry = m_entries[key];
+	entry.pending = true;
+
+	std::vector<std::string> sources(stages.size());
+	bool sourcesRead = true;
+	uint64_t hash = HashBytes(FNV_OFFSET, m_driver.data(), m_driver.size());
+	for (size_t i = 0; i < stages.size(); i++) {
+		sourcesRead &= LoadShaderSource(stages[i].path, stages[i].defines, sources[i]);
+		hash = HashBytes(hash, &stages[i].type, sizeof(GLenum));
+		hash = HashBytes(hash, sources[i].data(), sources[i].size());
+		entry.name += (i > 0 ? ", " : "") + stages[i].path;
+	}
+	for (const auto& define : stages.empty() ? ShaderDefines{} : stages[0].defines) {
+		entry.name += std::format(" -D{}", define);
+	}
+	entry.hash = hash;
+	entry.program = glCreateProgram();
+	if (sourcesRead && LoadBinary(entry)) {
+		m_buildMs += std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+		return entry;
+	}
+
+	// the status of the shaders and the link is only queried in Finish, so the driver can keep compiling in the background
+	for (size_t i = 0; i < stages.size(); i++) {
+		const char* code = sources[i].c_str();
+		GLuint shader = glCreateShader(stages[i].type);
+		glShaderSource(shader, 1, &code, NULL);
+		glCompileShader(shader);
+		glAttachShader(entry.program, shader);
+		entry.shaders.emplace_back(shader, stages[i].path);
+	}
+	if (m_binarySupported)
+		glProgramParameteri(entry.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	glLinkProgram(entry.program);
+	m_buildMs += std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+	return entry;
+}
+
+void ProgramCache::Finish(Entry& entry)
+{
+	auto start = std::chrono::steady_clock::now();
+	GLint success = 0;
+	GLchar infoLog[1024];
+	GLint type = 0;
+	for (const auto& [shader, path] : entry.shaders) {
+		glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+		if (!success) {
+			glGetShaderiv(shader, GL_SHADER_TYPE, &type);
+			glGetShaderInfoLog(shader, 1024, NULL, infoLog);
+			std::cout << std::format("[{}] ERROR::SHADER_COMPILATION_ERROR of type: {} \n {} \n-- -------------------------------------------------- - -- ", path, GetStageName(type), infoLog) << std::endl;
+		}
+	}
+	glGetProgramiv(entry.program, GL_LINK_STATUS, &success);
+	if (!success) {
+		glGetProgramInfoLog(entry.program, 1024, NULL, infoLog);
+		std::cout << std::format("[{}] ERROR::PROGRAM_LINKING_ERROR of type: PROGRAM \n {} \n-- -------------------------------------------------- - -- ", entry.name, infoLog) << std::endl;
+	}
+	// the shaders are linked into the program now and no longer necessary
+	for (const auto& [shader, path] : entry.shaders) {
+		glDetachShader(entry.program, shader);
+		glDeleteShader(shader);
+	}
+	if (!entry.shaders.empty()) {
+		m_compiled++;
+		if (success)
+			StoreBinary(entry);
+	}
+	entry.shaders.clear();
+
+	BindFrameContextBlock(entry.program);
+	entry.uniforms = std::make_shared<UniformTable>();
+	entry.uniforms->Reflect(entry.program);
+	entry.pending = false;
+	m_buildMs += std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+bool ProgramCache::LoadBinary(Entry& entry)
+{
+	if (!m_binarySupported)
+		return false;
+	std::ifstream file(GetBinaryPath(entry.hash), std::ios::binary | std::ios::ate);
+	if (!file.is_open())
+		return false;
+	std::streamsize size = file.tellg();
+	if (size <= static_cast<std::streamsize>(sizeof(GLenum)))
+		return false;
+	file.seekg(0, std::ios::beg);
+	GLenum format = 0;
+	std::vector<char> binary(static_cast<size_t>(size) - sizeof(GLenum));
+	file.read(reinterpret_cast<char*>(&format), sizeof(GLenum));
+	file.read(binary.data(), binary.size());
+	if (!file)
+		return false;
+
+	// a driver update may reject the binary even though the driver string did not change
+	glProgramBinary(entry.program, format, binary.data(), static_cast<GLsizei>(binary.size()));
+	GLint success = 0;
+	glGetProgramiv(entry.program, GL_LINK_STATUS, &success);
+	if (!success)
+		return false;
+	entry.fromBinary = true;
+	m_binaryHits++;
+	return true;
+}
+
+void ProgramCache::StoreBinary(const Entry& entry)
+{
+	if (!m_binarySupported)
+		return;
+	GLint length = 0;
+	glGetProgramiv(entry.program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0)
+		return;
+	std::vector<char> binary(length);
+	GLenum format = 0;
+	glGetProgramBinary(entry.program, length, nullptr, &format, binary.data());
+
+	std::error_code error;
+	std::filesystem::create_directories(CACHE_DIR, error);
+	std::ofstream file(GetBinaryPath(entry.hash), std::ios::binary | std::ios::trunc);
+	if (!file.is_open()) {
+		std::cerr << std::format("Failed to write the program binary of {}", entry.name) << std::endl;
+		return;
+	}
+	file.write(reinterpret_cast<const char*>(&format), sizeof(GLenum));
+	file.write(binary.data(), binary.size());
+}
+
+std::string ProgramCache::GetBinaryPath(uint64_t hash) const
+{
+	return std::format("{}/{:016x}.bin", CACHE_DIR, hash);
+}
+
+void ProgramCache::ImGuiCallback()
+{
+	static bool isFolded = true;
+	if (ImGui::CollapsingHeader("Shader Programs", &isFolded, ImGuiTreeNodeFlags_DefaultOpen))  // default open
+	{
+		ImGui::Text("%zu programs, %zu compiled, %zu from binary cache, %zu reused", m_entries.size(), m_compiled, m_binaryHits, m_reused);
+		ImGui::Text("Build time %.1f ms, parallel compile %s, binary cache %s", m_buildMs,
+			m_parallelCompile ? "on" : "off", m_binarySupported ? "on" : "off");
+	}
+}
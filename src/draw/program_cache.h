@@ -0,0 +1,83 @@
+#pragma once
+#include <glad/glad.h>
+#include "uniform_table.h"
+#include "shader_source.h"
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+struct ShaderStage
+{
+	GLenum type = GL_VERTEX_SHADER;
+	std::string path = "";
+	ShaderDefines defines{};
+};
+using ProgramStages = std::vector<ShaderStage>;
+
+// Builds every GL program of the renderer once.
+// Programs are shared by the normalized paths and the defines of their stages, so objects and sorters
+// that are created again on a scene switch get the linked program back without touching the driver.
+// Linked programs are also stored on disk with glGetProgramBinary, keyed by a hash of their
+// preprocessed sources and the driver, and
+// reloaded with glProgramBinary on the next start. Programs requested together through Prefetch are
+// compiled concurrently when the driver supports parallel shader compilation.
+// Programs live until exit, the same program id may be held by several Shader objects.
+class ProgramCache
+{
+public:
+	struct Program {
+		GLuint id = 0;
+		// shared by every holder of the program, so the uniform shadow copy matches the program state
+		std::shared_ptr<UniformTable> uniforms = nullptr;
+	};
+
+	static std::shared_ptr<ProgramCache> GetInstance();
+	// the loader glad was initialized with, entry points glad does not load are resolved through it
+	static void SetProcLoader(GLADloadproc loader) { m_procLoader = loader; }
+	ProgramCache() = default;
+	ProgramCache(const ProgramCache&) = delete;
+	ProgramCache& operator=(const ProgramCache&) = delete;
+
+	// returns the linked program, waits for it when it is still compiling
+	Program Get(const ProgramStages& stages);
+	// starts building programs that are about to be used without waiting for them
+	void Prefetch(const std::vector<ProgramStages>& programs);
+	void ImGuiCallback();
+
+private:
+	struct Entry {
+		std::string name = "";
+		uint64_t hash = 0;
+		GLuint program = 0;
+		std::vector<std::pair<GLuint, std::string>> shaders{};  // shader and its path while compiling
+		bool pending = false;
+		bool fromBinary = false;
+		std::shared_ptr<UniformTable> uniforms = nullptr;
+	};
+
+	void InitDriverInfo();
+	std::string GetKey(const ProgramStages& stages) const;
+	Entry& Start(const std::string& key, const ProgramStages& stages);
+	void Finish(Entry& entry);
+	bool LoadBinary(Entry& entry);
+	void StoreBinary(const Entry& entry);
+	std::string GetBinaryPath(uint64_t hash) const;
+
+private:
+	static inline std::shared_ptr<ProgramCache> m_instance = nullptr;
+	static inline GLADloadproc m_procLoader = nullptr;
+	static constexpr const char* CACHE_DIR = "./shader_cache";
+
+	bool m_initialized = false;
+	bool m_parallelCompile = false;
+	bool m_binarySupported = false;
+	std::string m_driver = "";
+	std::unordered_map<std::string, Entry> m_entries{};
+	size_t m_binaryHits = 0;
+	size_t m_compiled = 0;
+	size_t m_reused = 0;
+	float m_buildMs = 0.0f;
+};
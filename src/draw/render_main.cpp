@@ -1,21 +1,37 @@
 #include "render_main.h"
 #include "../manager/callback.h"
 #include "../render_objs/gs_ply_obj.h"
-#include "../register/register_uniform_setter.h"
+#include "batch_renderer.h"
+#include "gl_state_cache.h"
+#include "draw_batcher.h"
+#include "program_cache.h"
+#include "../utils/profiler.h"
+#include "../utils/gpu_memory.h"
 
 std::shared_ptr<RenderMain> RenderMain::m_instance = nullptr;
-std::shared_ptr<RenderMain> RenderMain::GetInstance()
+std::shared_ptr<RenderMain> RenderMain::GetInstance(bool headless)
 {
 	static std::mutex mutex;
 	std::lock_guard<std::mutex> lock(mutex);
 	if (m_instance == nullptr) {
-		m_instance = std::make_shared<RenderMain>();
+		m_instance = std::make_shared<RenderMain>(headless);
 	}
 	return m_instance;
 }
 
-RenderMain::RenderMain()
+RenderMain::RenderMain(bool headless)
 {
+	if (headless) {
+		// no window, no input and no ImGui, everything is drawn into the batch renderer's framebuffer
+		m_headless = HeadlessManager::GetInstance();
+		m_camera = Camera::GetInstance();
+		m_camera->ProcessFramebufferSizeCallback(SCR_WIDTH, SCR_HEIGHT);
+		m_renderObjMgr = RenderObjectManager::GetInstance();
+		m_frameContextBuffer = std::make_unique<FrameContextBuffer>();
+		m_cameraPath = std::make_shared<CameraPath>();
+		return;
+	}
+
 	m_glfwInstance = GLFWManager::GetInstance(SCR_WIDTH, SCR_HEIGHT);
 	m_glfwInstance->SetFrameBufferSizeCallback(FramebufferSizeCallback);
 	m_glfwInstance->SetMouseButtonCallback(MouseButtonCallback);
@@ -28,7 +44,146 @@ RenderMain::RenderMain()
 	m_window = m_glfwInstance->GetWindow();
 	m_renderObjMgr = RenderObjectManager::GetInstance();
 	m_imguiMgr = ImGuiManager::GetInstance(m_window);
-	m_uniformSetter = std::make_unique<Registry::UniformSetter>();
+	m_frameContextBuffer = std::make_unique<FrameContextBuffer>();
+	m_cameraPath = std::make_shared<CameraPath>();
+}
+
+bool RenderMain::StartReplay(const std::string& path, bool exitWhenDone)
+{
+	m_cameraPath->SetPath(path);
+	if (!m_cameraPath->Load() || !m_cameraPath->StartReplay())
+		return false;
+	// frame times are meaningless when capped by the display refresh rate
+	if (m_window)
+		glfwSwapInterval(0);
+	m_exitAfterReplay = exitWhenDone;
+	return true;
+}
+
+bool RenderMain::RenderBatch(const std::string& camerasPath, const std::string& outputDir)
+{
+	std::vector<Parser::CameraConfig> cameras;
+	try {
+		cameras = Parser::LoadCameraConfig(camerasPath);
+	}
+	catch (const std::exception& e) {
+		std::cerr << std::format("Failed to load {}: {}", camerasPath, e.what()) << std::endl;
+		return false;
+	}
+
+	BatchRenderer batchRenderer;
+	size_t written = batchRenderer.Run(cameras, outputDir, [this]() { DrawScene(); }, GetClearColor());
+	return written == cameras.size();
+}
+
+bool RenderMain::RenderHeadless(size_t frameCount, int width, int height, const std::string& outputDir)
+{
+	if (m_headless && !m_headless->IsValid())
+		return false;
+
+	bool isReplay = m_cameraPath->GetMode() == CameraPath::REPLAYING;
+	if (isReplay)
+		frameCount = (std::min)(frameCount, m_cameraPath->GetFrameCount());
+	m_camera->ProcessFramebufferSizeCallback(width, height);
+
+	BatchRenderer batchRenderer;
+	size_t written = batchRenderer.RunFrames(frameCount, width, height, outputDir, [this, isReplay, width, height](size_t /*frame*/) {
+		Camera::CameraState state;
+		if (isReplay && m_cameraPath->NextFrame(state)) {
+			// recorded frames keep their camera but are rendered at the requested size
+			state.screenWidth = width;
+			state.screenHeight = height;
+			m_camera->SetState(state);
+		}
+		}, [this]() { DrawScene(); }, GetClearColor());
+	return written == frameCount;
+}
+
+bool RenderMain::RenderCpuReference(const std::string& configPath, int width, int height, const std::string& outputPath)
+{
+	std::vector<std::shared_ptr<Parser::RenderObjConfigBase>> configs;
+	try {
+		Parser::ConfigParser parser(configs);
+		parser.Parse(configPath);
+	}
+	catch (const std::exception& e) {
+		std::cerr << std::format("Failed to load {}: {}", configPath, e.what()) << std::endl;
+		return false;
+	}
+
+	// the gaussian objects only go through LoadData, as on the loader threads, the other objects need GL and are skipped
+	std::vector<Renderable::GSCpuRasterizer::Splat> splats;
+	int shDegree = 0;
+	for (size_t i = 0; i < configs.size(); i++) {
+		std::shared_ptr<Renderable::Base3DGSObj> obj = nullptr;
+		if (configs[i]->objType == "gs_ply")
+			obj = std::make_shared<Renderable::GSPlyObj>(configs[i]);
+		else if (configs[i]->objType == "gs_splat")
+			obj = std::make_shared<Renderable::GSSplatObj>(configs[i]);
+		else
+			continue;
+		try {
+			obj->LoadData();
+		}
+		catch (const std::exception& e) {
+			std::cerr << std::format("Error occur while loading object {} of {}: {}", i, configPath, e.what()) << std::endl;
+			continue;
+		}
+		std::vector<Renderable::GSCpuRasterizer::Splat> objSplats;
+		obj->ExportSplats(objSplats);
+		splats.insert(splats.end(), objSplats.begin(), objSplats.end());
+		shDegree = (std::max)(shDegree, obj->GetShDegree());
+	}
+	if (splats.empty()) {
+		std::cerr << std::format("{} has no gaussian object to render", configPath) << std::endl;
+		return false;
+	}
+
+	auto camera = Camera::GetInstance();
+	camera->ProcessFramebufferSizeCallback(width, height);
+	FrameContext frame;
+	FillFrameContext(*camera, frame);
+	Renderable::GSCpuRasterizer rasterizer;
+	Renderable::GSCpuRasterizer::Image image;
+	rasterizer.Render(splats, shDegree, frame, glm::ivec2(width, height), image);
+	if (!image.WritePng(outputPath)) {
+		std::cerr << std::format("Failed to write {}", outputPath) << std::endl;
+		return false;
+	}
+	std::cout << std::format("Rendered {} splats to {} in {:.1f} ms", splats.size(), outputPath, rasterizer.GetLastRenderMs()) << std::endl;
+	return true;
+}
+
+const float* RenderMain::GetClearColor() const
+{
+	static const float HEADLESS_CLEAR_COLOR[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+	return m_imguiMgr ? m_imguiMgr->GetClearColor() : HEADLESS_CLEAR_COLOR;
+}
+
+void RenderMain::DrawScene()
+{
+	UpdateFrameContext();
+	DrawRenderObjs();
+}
+
+void RenderMain::DrawRenderObjs()
+{
+	auto batcher = DrawBatcher::GetInstance();
+	for (auto& renderObj : m_renderObjs) {
+		if (!renderObj->IsBatched())
+			batcher->Flush();
+		// buffers that grow and targets that follow the window size are charged to the object
+		GpuMemoryOwnerScope owner(renderObj.get());
+		renderObj->DrawObj(m_frameContext);
+	}
+	batcher->Flush();
+}
+
+void RenderMain::FinishReplay()
+{
+	m_cameraPath->SaveTimings();
+	if (m_exitAfterReplay)
+		glfwSetWindowShouldClose(m_window, GLFW_TRUE);
 }
 
 void RenderMain::SetupRenderObjs(std::vector<std::string>& configPaths)
@@ -36,66 +191,126 @@ void RenderMain::SetupRenderObjs(std::vector<std::string>& configPaths)
 	m_renderObjMgr->InitRenderObjs(configPaths);
 	m_renderObjs = m_renderObjMgr->GetRenderObjs();
 	m_renderObjConfigs = m_renderObjMgr->GetObjConfigs();
-	GatherConfigUniform();
+}
+
+void RenderMain::RequestRenderObjs(const std::vector<std::string>& configPaths)
+{
+	m_renderObjMgr->RequestScene(configPaths);
 }
 
 void RenderMain::PrepareDraw()
 {
+	Profiler::GetInstance()->BeginFrame();
+	GLStateCache::GetInstance()->BeginFrame();
+	DrawBatcher::GetInstance()->BeginFrame();
+	PROFILE_CPU_SCOPE("PrepareDraw");
+	if (!m_pendingBatchPath.empty()) {
+		RenderBatch(m_pendingBatchPath, "./batch_output");
+		m_pendingBatchPath.clear();
+	}
+	if (m_renderObjMgr->PollScene()) {
+		m_renderObjs = m_renderObjMgr->GetRenderObjs();
+		m_renderObjConfigs = m_renderObjMgr->GetObjConfigs();
+	}
+
 	float* clearColor = m_imguiMgr->GetClearColor();
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 	glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
 
-	float currentFrame = static_cast<float>(glfwGetTime());
+	m_frameStart = glfwGetTime();
+	float currentFrame = static_cast<float>(m_frameStart);
 	m_delta_time = currentFrame - m_lastFrame;
 	m_lastFrame = currentFrame;
-	ProcessInput(m_window, m_delta_time);
-	SetUpDrawUniform();
+
+	// a replayed frame takes its camera from the path file and advances by a fixed timestep
+	m_isReplayFrame = false;
+	if (m_cameraPath->GetMode() == CameraPath::REPLAYING) {
+		Camera::CameraState state;
+		if (m_cameraPath->NextFrame(state)) {
+			if (state.screenWidth != m_camera->GetScreenWidth() || state.screenHeight != m_camera->GetScreenHeight())
+				glfwSetWindowSize(m_window, state.screenWidth, state.screenHeight);
+			m_camera->SetState(state);
+			m_delta_time = m_cameraPath->GetTimestep();
+			m_isReplayFrame = true;
+		}
+		else {
+			FinishReplay();
+		}
+	}
+	if (!m_isReplayFrame) {
+		ProcessInput(m_window, m_delta_time);
+		m_cameraPath->Record(m_camera->GetState());
+	}
+	UpdateFrameContext();
 	// mvp transform
 	//processViewWorld(m_window);
 	//processViewCamera(m_window, SCR_WIDTH, SCR_HEIGHT);
 	//processModelMatrix(m_window, model);
 }
 
-void RenderMain::SetUpDrawUniform()
+void RenderMain::FillFrameContext(const Camera& camera, FrameContext& frame)
 {
-	for (const auto& uniform : m_renderObjUniforms) {
-		if (m_uniformSetter->Contain(uniform)) {
-			m_uniformSetter->GetFunc(uniform)(m_drawUniforms);
-		}
-	}
+	auto gsCamera = Renderable::Base3DGSCamera::GetInstance();
+	frame.projection = camera.GetProjMat();
+	frame.view = camera.GetViewMat();
+	frame.model = glm::mat4(1.0f);
+	frame.camPos = glm::vec4(camera.GetPosition(), 1.0f);
+	frame.viewport = glm::vec2(camera.GetScreenWidth(), camera.GetScreenHeight());
+	frame.focal = gsCamera->GetFocal();
+	frame.tanFov = gsCamera->GetTanFov();
+	frame.nearFar = gsCamera->GetNearFar();
 }
 
-void RenderMain::GatherConfigUniform()
+void RenderMain::UpdateFrameContext()
 {
-	m_renderObjUniforms.clear();
-	for (const auto& ConfigPtr : m_renderObjConfigs)
-	{
-		auto& configUniform = ConfigPtr->GetUniform();
-		m_renderObjUniforms.insert(configUniform.begin(), configUniform.end());
-	}
+	FillFrameContext(*m_camera, m_frameContext);
+	m_frameContextBuffer->Upload(m_frameContext);
 }
 
 void RenderMain::Draw()
 {
+	PROFILE_CPU_SCOPE("Draw");
 	glm::mat4 model = glm::mat4(1.0f);
 
+	DrawRenderObjs();
 	std::vector<std::function<void()>> functions;
 	for (size_t i = 0; i < m_renderObjs.size(); i++) {
 		auto& renderObj = m_renderObjs[i];
 		auto& config = m_renderObjConfigs[i];
-		renderObj->DrawObj(m_drawUniforms);
 		// ImGUI Callback
 		auto callback = [&renderObj]() {
+			GpuMemoryOwnerScope owner(renderObj.get());
 			renderObj->ImGuiCallback();
 			};
 		functions.emplace_back(callback);
 	}
-	m_imguiMgr->Render(functions);
+	functions.emplace_back([this]() {
+		m_cameraPath->ImGuiCallback();
+		m_renderObjMgr->ImGuiCallback();
+		Profiler::GetInstance()->ImGuiCallback();
+		GpuMemoryTracker::GetInstance()->ImGuiCallback();
+		GLStateCache::GetInstance()->ImGuiCallback();
+		DrawBatcher::GetInstance()->ImGuiCallback();
+		ProgramCache::GetInstance()->ImGuiCallback();
+		// the batch itself runs at the start of the next frame, outside of the ImGui frame
+		if (ImGui::Button("Batch Render cameras.json"))
+			Parser::SelectCameraConfigPath(m_pendingBatchPath);
+		});
+	{
+		PROFILE_SCOPE("ImGui");
+		m_imguiMgr->Render(functions);
+	}
+	// the ImGui backend sets its own program, textures and blend state
+	GLStateCache::GetInstance()->Invalidate();
 }
 
 void RenderMain::FinishDraw()
 {
+	Profiler::GetInstance()->BeginPresent();
 	glfwSwapBuffers(m_window);
+	Profiler::GetInstance()->EndFrame();
+	if (m_isReplayFrame)
+		m_cameraPath->RecordFrameTime(static_cast<float>((glfwGetTime() - m_frameStart) * 1000.0));
 	glfwPollEvents();
 }
 
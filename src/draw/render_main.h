@@ -6,38 +6,64 @@
 #include "../manager/glfw_mgr.h"
 #include "../manager/callback.h"
 #include "../manager/imgui_mgr.h"
+#include "../manager/headless_mgr.h"
 #include "../manager/render_obj_mgr.h"
 #include "../parser/config.h"
 #include "../draw/camera.h"
-#include "../register/register_uniform_setter.h"
+#include "../draw/camera_path.h"
+#include "../draw/frame_context.h"
 
 class RenderMain : public std::enable_shared_from_this<RenderMain> {
 public:
-	static std::shared_ptr<RenderMain> GetInstance();
-	RenderMain();
+	// headless only takes effect on the first call, it creates an offscreen context instead of the window
+	static std::shared_ptr<RenderMain> GetInstance(bool headless = false);
+	explicit RenderMain(bool headless = false);
 	~RenderMain() {};
 	GLFWwindow* GetWindow() { return m_window; }
 	void SetupRenderObjs(std::vector<std::string>& configPaths);
+	// switches scenes without stalling, the current scene keeps drawing until the new one is loaded
+	void RequestRenderObjs(const std::vector<std::string>& configPaths);
 	void PrepareDraw();
 	void Draw();
 	void FinishDraw();
-	void SetUpDrawUniform();
+	void UpdateFrameContext();
+	const FrameContext& GetFrameContext() const { return m_frameContext; }
+	std::shared_ptr<CameraPath> GetCameraPath() { return m_cameraPath; }
+	bool StartReplay(const std::string& path, bool exitWhenDone);
+	// render every view of a cameras.json into outputDir without touching the window
+	bool RenderBatch(const std::string& camerasPath, const std::string& outputDir);
+	// render frameCount frames offscreen into outputDir, following the replayed camera path if one is loaded
+	bool RenderHeadless(size_t frameCount, int width, int height, const std::string& outputDir);
+	// render the gaussian objects of a scene config with the software rasterizer into a png, needs no GL context
+	// and no RenderMain instance, so it runs where neither a display nor EGL is available
+	static bool RenderCpuReference(const std::string& configPath, int width, int height, const std::string& outputPath);
+	bool IsHeadless() const { return m_headless != nullptr; }
+	void DrawScene();
 
 private:
-	void GatherConfigUniform();
+	static void FillFrameContext(const Camera& camera, FrameContext& frame);
+	void FinishReplay();
+	const float* GetClearColor() const;
+	// draws every object in order, queued batches are flushed before each object that draws directly
+	void DrawRenderObjs();
 
 private:
 	std::shared_ptr<GLFWManager> m_glfwInstance = nullptr;
 	std::shared_ptr<Camera> m_camera = nullptr;
 	std::shared_ptr<RenderObjectManager> m_renderObjMgr = nullptr;
 	std::shared_ptr<ImGuiManager> m_imguiMgr = nullptr;
-	std::unique_ptr<Registry::UniformSetter> m_uniformSetter = nullptr;
+	std::shared_ptr<HeadlessManager> m_headless = nullptr;
+	std::shared_ptr<CameraPath> m_cameraPath = nullptr;
+	std::unique_ptr<FrameContextBuffer> m_frameContextBuffer = nullptr;
 	GLFWwindow* m_window = nullptr;
 	std::vector<std::shared_ptr<Renderable::RenderObjectBase>> m_renderObjs{};
 	std::vector<std::shared_ptr<Parser::RenderObjConfigBase>> m_renderObjConfigs{};
-	std::unordered_set<std::string> m_renderObjUniforms{};
-	std::unordered_map<std::string, std::any> m_drawUniforms{};
+	FrameContext m_frameContext{};
 	static std::shared_ptr<RenderMain> m_instance;
 	float m_lastFrame = 0.0;
 	float m_delta_time = 0.0;
+	double m_frameStart = 0.0;
+	bool m_isReplayFrame = false;
+	bool m_exitAfterReplay = false;
+	std::string m_pendingBatchPath = "";
 };
\ No newline at end of file
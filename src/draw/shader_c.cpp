@@ -1,139 +1,157 @@
 #include "shader_c.h"
+#include "program_cache.h"
+#include "gl_state_cache.h"
 #include <format>
 #include <glm/gtc/type_ptr.hpp>
 
-ComputeShader::ComputeShader(const char* computePath)
-{
-	// 1. retrieve the vertex/fragment source code from filePath
-	std::string computeCode;
-	std::ifstream cShaderFile;
-	// ensure ifstream objects can throw exceptions:
-	cShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-	try
-	{
-		// open files
-		cShaderFile.open(computePath);
-
-		std::stringstream cShaderStream;
-		// read file's buffer contents into streams
-		cShaderStream << cShaderFile.rdbuf();
-		// close file handlers
-		cShaderFile.close();
-		// convert stream into string
-		computeCode = cShaderStream.str();
-	}
-	catch (std::ifstream::failure& e)
-	{
-		std::cout << std::format("ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: {}", e.what()) << std::endl;
-	}
-	const char* cShaderCode = computeCode.c_str();
-	// 2. compile shaders
-	unsigned int compute;
-	// compute shader
-	compute = glCreateShader(GL_COMPUTE_SHADER);
-	glShaderSource(compute, 1, &cShaderCode, NULL);
-	glCompileShader(compute);
-	CheckCompileErrors(compute, "COMPUTE");
-
-	// shader Program
-	ID = glCreateProgram();
-	glAttachShader(ID, compute);
-	glLinkProgram(ID);
-	CheckCompileErrors(ID, "PROGRAM");
-	// delete the shaders as they're linked into our program now and no longer necessary
-	glDeleteShader(compute);
+ComputeShader::ComputeShader(const char* computePath, const ShaderDefines& defines)
+{
+	auto program = ProgramCache::GetInstance()->Get({ { GL_COMPUTE_SHADER, computePath, defines } });
+	ID = program.id;
+	m_uniforms = program.uniforms;
 }
 
 void ComputeShader::Use()
 {
-	glUseProgram(ID);
+	GLStateCache::GetInstance()->UseProgram(ID);
 }
 
 void ComputeShader::SetBool(const std::string& name, bool value) const
 {
-	glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+	SetBool(m_uniforms->Find(name), value);
 }
 
 void ComputeShader::SetInt(const std::string& name, int value) const
 {
-	glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+	SetInt(m_uniforms->Find(name), value);
 }
 
 void ComputeShader::SetUInt(const std::string& name, uint32_t value) const
 {
-	glUniform1ui(glGetUniformLocation(ID, name.c_str()), value);
+	SetUInt(m_uniforms->Find(name), value);
 }
 
 void ComputeShader::SetFloat(const std::string& name, float value) const
 {
-	glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+	SetFloat(m_uniforms->Find(name), value);
 }
 
 void ComputeShader::SetVec2(const std::string& name, const glm::vec2& value) const
 {
-	glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, glm::value_ptr(value));
+	SetVec2(m_uniforms->Find(name), value);
 }
 
 void ComputeShader::SetVec2(const std::string& name, float x, float y) const
 {
-	glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y);
+	SetVec2(m_uniforms->Find(name), x, y);
 }
 
 void ComputeShader::SetVec3(const std::string& name, const glm::vec3& value) const
 {
-	glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, glm::value_ptr(value));
+	SetVec3(m_uniforms->Find(name), value);
 }
 
 void ComputeShader::SetVec3(const std::string& name, float x, float y, float z) const
 {
-	glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z);
+	SetVec3(m_uniforms->Find(name), x, y, z);
 }
 
 void ComputeShader::SetVec4(const std::string& name, const glm::vec4& value) const
 {
-	glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, glm::value_ptr(value));
+	SetVec4(m_uniforms->Find(name), value);
 }
 
 void ComputeShader::SetVec4(const std::string& name, float x, float y, float z, float w)
 {
-	glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w);
+	SetVec4(m_uniforms->Find(name), x, y, z, w);
 }
 
 void ComputeShader::SetMat2(const std::string& name, const glm::mat2& mat) const
 {
-	glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, glm::value_ptr(mat));
+	SetMat2(m_uniforms->Find(name), mat);
 }
 
 void ComputeShader::SetMat3(const std::string& name, const glm::mat3& mat) const
 {
-	glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, glm::value_ptr(mat));
+	SetMat3(m_uniforms->Find(name), mat);
 }
 
 void ComputeShader::SetMat4(const std::string& name, const glm::mat4& mat) const
 {
-	glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, glm::value_ptr(mat));
-}
-
-void ComputeShader::CheckCompileErrors(GLuint shader, std::string type)
-{
-	GLint success;
-	GLchar infoLog[1024];
-	if (type != "PROGRAM")
-	{
-		glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
-		if (!success)
-		{
-			glGetShaderInfoLog(shader, 1024, NULL, infoLog);
-			std::cout << std::format("ERROR::SHADER_COMPILATION_ERROR of type: {} \n {} \n-- -------------------------------------------------- - -- ", type, infoLog) << std::endl;
-		}
-	}
-	else
-	{
-		glGetProgramiv(shader, GL_LINK_STATUS, &success);
-		if (!success)
-		{
-			glGetProgramInfoLog(shader, 1024, NULL, infoLog);
-			std::cout << std::format("ERROR::PROGRAM_LINKING_ERROR of type: {} \n {} \n-- -------------------------------------------------- - -- ", type, infoLog) << std::endl;
-		}
-	}
+	SetMat4(m_uniforms->Find(name), mat);
+}
+
+void ComputeShader::SetBool(UniformHandle handle, bool value) const
+{
+	if (m_uniforms->Update(handle, static_cast<int>(value)))
+		glUniform1i(m_uniforms->GetLocation(handle), static_cast<int>(value));
+}
+
+void ComputeShader::SetInt(UniformHandle handle, int value) const
+{
+	if (m_uniforms->Update(handle, value))
+		glUniform1i(m_uniforms->GetLocation(handle), value);
+}
+
+void ComputeShader::SetUInt(UniformHandle handle, uint32_t value) const
+{
+	if (m_uniforms->Update(handle, value))
+		glUniform1ui(m_uniforms->GetLocation(handle), value);
+}
+
+void ComputeShader::SetFloat(UniformHandle handle, float value) const
+{
+	if (m_uniforms->Update(handle, value))
+		glUniform1f(m_uniforms->GetLocation(handle), value);
+}
+
+void ComputeShader::SetVec2(UniformHandle handle, const glm::vec2& value) const
+{
+	if (m_uniforms->Update(handle, value))
+		glUniform2fv(m_uniforms->GetLocation(handle), 1, glm::value_ptr(value));
+}
+
+void ComputeShader::SetVec2(UniformHandle handle, float x, float y) const
+{
+	SetVec2(handle, glm::vec2(x, y));
+}
+
+void ComputeShader::SetVec3(UniformHandle handle, const glm::vec3& value) const
+{
+	if (m_uniforms->Update(handle, value))
+		glUniform3fv(m_uniforms->GetLocation(handle), 1, glm::value_ptr(value));
+}
+
+void ComputeShader::SetVec3(UniformHandle handle, float x, float y, float z) const
+{
+	SetVec3(handle, glm::vec3(x, y, z));
+}
+
+void ComputeShader::SetVec4(UniformHandle handle, const glm::vec4& value) const
+{
+	if (m_uniforms->Update(handle, value))
+		glUniform4fv(m_uniforms->GetLocation(handle), 1, glm::value_ptr(value));
+}
+
+void ComputeShader::SetVec4(UniformHandle handle, float x, float y, float z, float w)
+{
+	SetVec4(handle, glm::vec4(x, y, z, w));
+}
+
+void ComputeShader::SetMat2(UniformHandle handle, const glm::mat2& mat) const
+{
+	if (m_uniforms->Update(handle, mat))
+		glUniformMatrix2fv(m_uniforms->GetLocation(handle), 1, GL_FALSE, glm::value_ptr(mat));
+}
+
+void ComputeShader::SetMat3(UniformHandle handle, const glm::mat3& mat) const
+{
+	if (m_uniforms->Update(handle, mat))
+		glUniformMatrix3fv(m_uniforms->GetLocation(handle), 1, GL_FALSE, glm::value_ptr(mat));
+}
+
+void ComputeShader::SetMat4(UniformHandle handle, const glm::mat4& mat) const
+{
+	if (m_uniforms->Update(handle, mat))
+		glUniformMatrix4fv(m_uniforms->GetLocation(handle), 1, GL_FALSE, glm::value_ptr(mat));
 }
@@ -1,8 +1,11 @@
 #pragma once
 #include <glad/glad.h>
 #include <glm/glm.hpp>
+#include "uniform_table.h"
+#include "shader_source.h"
 
 #include <string>
+#include <memory>
 #include <fstream>
 #include <sstream>
 #include <iostream>
@@ -11,7 +14,7 @@ class ComputeShader
 {
 public:
 	unsigned int ID;
-	ComputeShader(const char* computePath); // constructor generates the shader on the fly
+	ComputeShader(const char* computePath, const ShaderDefines& defines = {}); // constructor generates the shader on the fly
 	void Use();  // activate the shader
 
 	// utility uniform functions
@@ -30,6 +33,23 @@ public:
 	void SetMat3(const std::string& name, const glm::mat3& mat) const;
 	void SetMat4(const std::string& name, const glm::mat4& mat) const;
 
+	// handle based setters skip the name lookup, resolve the handle once with GetUniformHandle
+	void SetBool(UniformHandle handle, bool value) const;
+	void SetInt(UniformHandle handle, int value) const;
+	void SetUInt(UniformHandle handle, uint32_t value) const;
+	void SetFloat(UniformHandle handle, float value) const;
+	void SetVec2(UniformHandle handle, const glm::vec2& value) const;
+	void SetVec2(UniformHandle handle, float x, float y) const;
+	void SetVec3(UniformHandle handle, const glm::vec3& value) const;
+	void SetVec3(UniformHandle handle, float x, float y, float z) const;
+	void SetVec4(UniformHandle handle, const glm::vec4& value) const;
+	void SetVec4(UniformHandle handle, float x, float y, float z, float w);
+	void SetMat2(UniformHandle handle, const glm::mat2& mat) const;
+	void SetMat3(UniformHandle handle, const glm::mat3& mat) const;
+	void SetMat4(UniformHandle handle, const glm::mat4& mat) const;
+	UniformHandle GetUniformHandle(const std::string& name) const { return m_uniforms->Find(name); }
+
 private:
-	void CheckCompileErrors(GLuint shader, std::string type); // utility function for checking shader compilation/linking errors.
+	// shared with every Shader of the same program, see ProgramCache
+	std::shared_ptr<UniformTable> m_uniforms = nullptr;
 };
@@ -1,145 +1,163 @@
 #include "shader_s.h"
+#include "program_cache.h"
+#include "gl_state_cache.h"
 #include <format>
 #include <glm/gtc/type_ptr.hpp>
 Shader::Shader(const char* vertexPath, const char* fragmentPath, const char* geometryPath)
 {
-	// 1. retrieve the vertex/fragment source code from filePath
-	std::string vertexCode;
-	std::string fragmentCode;
-	std::string geometryCode;
-	std::ifstream vShaderFile;
-	std::ifstream fShaderFile;
-	std::ifstream gShaderFile;
-	// ensure ifstream objects can throw exceptions:
-	vShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-	fShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-	gShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-	try
-	{
-		// open files
-		vShaderFile.open(vertexPath);
-		fShaderFile.open(fragmentPath);
-		std::stringstream vShaderStream, fShaderStream;
-		// read file's buffer contents into streams
-		vShaderStream << vShaderFile.rdbuf();
-		fShaderStream << fShaderFile.rdbuf();
-		// close file handlers
-		vShaderFile.close();
-		fShaderFile.close();
-		// convert stream into string
-		vertexCode = vShaderStream.str();
-		fragmentCode = fShaderStream.str();
-		// if geometry shader path is present, also load a geometry shader
-		if (geometryPath != nullptr)
-		{
-			gShaderFile.open(geometryPath);
-			std::stringstream gShaderStream;
-			gShaderStream << gShaderFile.rdbuf();
-			gShaderFile.close();
-			geometryCode = gShaderStream.str();
-		}
-	}
-	catch (std::ifstream::failure& e)
-	{
-		std::cout << std::format("ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: {}", e.what()) << std::endl;
-	}
-	const char* vShaderCode = vertexCode.c_str();
-	const char* fShaderCode = fragmentCode.c_str();
-	// 2. compile shaders
-	unsigned int vertex, fragment;
-	// vertex shader
-	vertex = glCreateShader(GL_VERTEX_SHADER);
-	glShaderSource(vertex, 1, &vShaderCode, NULL);
-	glCompileShader(vertex);
-	CheckCompileErrors(vertexPath, vertex, "VERTEX");
-	// fragment Shader
-	fragment = glCreateShader(GL_FRAGMENT_SHADER);
-	glShaderSource(fragment, 1, &fShaderCode, NULL);
-	glCompileShader(fragment);
-	CheckCompileErrors(fragmentPath, fragment, "FRAGMENT");
-	// if geometry shader is given, compile geometry shader
-	unsigned int geometry;
+	ProgramStages stages{ { GL_VERTEX_SHADER, vertexPath }, { GL_FRAGMENT_SHADER, fragmentPath } };
 	if (geometryPath != nullptr)
-	{
-		const char* gShaderCode = geometryCode.c_str();
-		geometry = glCreateShader(GL_GEOMETRY_SHADER);
-		glShaderSource(geometry, 1, &gShaderCode, NULL);
-		glCompileShader(geometry);
-		CheckCompileErrors(geometryPath, geometry, "GEOMETRY");
-	}
-	// shader Program
-	ID = glCreateProgram();
-	glAttachShader(ID, vertex);
-	glAttachShader(ID, fragment);
-	if (geometryPath != nullptr)
-		glAttachShader(ID, geometry);
-	glLinkProgram(ID);
-	CheckCompileErrors("program", ID, "PROGRAM");
-	// delete the shaders as they're linked into our program now and no longer necessary
-	glDeleteShader(vertex);
-	glDeleteShader(fragment);
-	if (geometryPath != nullptr)
-		glDeleteShader(geometry);
+		stages.push_back({ GL_GEOMETRY_SHADER, geometryPath });
+	auto program = ProgramCache::GetInstance()->Get(stages);
+	ID = program.id;
+	m_uniforms = program.uniforms;
+}
+
+Shader::Shader(const char* vertexPath, const char* fragmentPath, const ShaderDefines& defines)
+{
+	auto program = ProgramCache::GetInstance()->Get({ { GL_VERTEX_SHADER, vertexPath, defines }, { GL_FRAGMENT_SHADER, fragmentPath, defines } });
+	ID = program.id;
+	m_uniforms = program.uniforms;
 }
 
 void Shader::SetBool(const std::string& name, bool value) const
 {
-	glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+	SetBool(m_uniforms->Find(name), value);
 }
 
 void Shader::SetInt(const std::string& name, int value) const
 {
-	glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+	SetInt(m_uniforms->Find(name), value);
+}
+
+void Shader::SetUInt(const std::string& name, uint32_t value) const
+{
+	SetUInt(m_uniforms->Find(name), value);
 }
 
 void Shader::SetFloat(const std::string& name, float value) const
 {
-	glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+	SetFloat(m_uniforms->Find(name), value);
 }
 
 void Shader::SetVec2(const std::string& name, const glm::vec2& value) const
 {
-	glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, glm::value_ptr(value));
+	SetVec2(m_uniforms->Find(name), value);
 }
 
 void Shader::SetVec2(const std::string& name, float x, float y) const
 {
-	glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y);
+	SetVec2(m_uniforms->Find(name), x, y);
 }
 
 void Shader::SetVec3(const std::string& name, const glm::vec3& value) const
 {
-	glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, glm::value_ptr(value));
+	SetVec3(m_uniforms->Find(name), value);
 }
 
 void Shader::SetVec3(const std::string& name, float x, float y, float z) const
 {
-	glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z);
+	SetVec3(m_uniforms->Find(name), x, y, z);
 }
 
 void Shader::SetVec4(const std::string& name, const glm::vec4& value) const
 {
-	glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, glm::value_ptr(value));
+	SetVec4(m_uniforms->Find(name), value);
 }
 
 void Shader::SetVec4(const std::string& name, float x, float y, float z, float w)
 {
-	glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w);
+	SetVec4(m_uniforms->Find(name), x, y, z, w);
 }
 
 void Shader::SetMat2(const std::string& name, const glm::mat2& mat) const
 {
-	glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, glm::value_ptr(mat));
+	SetMat2(m_uniforms->Find(name), mat);
 }
 
 void Shader::SetMat3(const std::string& name, const glm::mat3& mat) const
 {
-	glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, glm::value_ptr(mat));
+	SetMat3(m_uniforms->Find(name), mat);
 }
 
 void Shader::SetMat4(const std::string& name, const glm::mat4& mat) const
 {
-	glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, glm::value_ptr(mat));
+	SetMat4(m_uniforms->Find(name), mat);
+}
+
+void Shader::SetBool(UniformHandle handle, bool value) const
+{
+	if (m_uniforms->Update(handle, static_cast<int>(value)))
+		glUniform1i(m_uniforms->GetLocation(handle), static_cast<int>(value));
+}
+
+void Shader::SetInt(UniformHandle handle, int value) const
+{
+	if (m_uniforms->Update(handle, value))
+		glUniform1i(m_uniforms->GetLocation(handle), value);
+}
+
+void Shader::SetUInt(UniformHandle handle, uint32_t value) const
+{
+	if (m_uniforms->Update(handle, value))
+		glUniform1ui(m_uniforms->GetLocation(handle), value);
+}
+
+void Shader::SetFloat(UniformHandle handle, float value) const
+{
+	if (m_uniforms->Update(handle, value))
+		glUniform1f(m_uniforms->GetLocation(handle), value);
+}
+
+void Shader::SetVec2(UniformHandle handle, const glm::vec2& value) const
+{
+	if (m_uniforms->Update(handle, value))
+		glUniform2fv(m_uniforms->GetLocation(handle), 1, glm::value_ptr(value));
+}
+
+void Shader::SetVec2(UniformHandle handle, float x, float y) const
+{
+	SetVec2(handle, glm::vec2(x, y));
+}
+
+void Shader::SetVec3(UniformHandle handle, const glm::vec3& value) const
+{
+	if (m_uniforms->Update(handle, value))
+		glUniform3fv(m_uniforms->GetLocation(handle), 1, glm::value_ptr(value));
+}
+
+void Shader::SetVec3(UniformHandle handle, float x, float y, float z) const
+{
+	SetVec3(handle, glm::vec3(x, y, z));
+}
+
+void Shader::SetVec4(UniformHandle handle, const glm::vec4& value) const
+{
+	if (m_uniforms->Update(handle, value))
+		glUniform4fv(m_uniforms->GetLocation(handle), 1, glm::value_ptr(value));
+}
+
+void Shader::SetVec4(UniformHandle handle, float x, float y, float z, float w)
+{
+	SetVec4(handle, glm::vec4(x, y, z, w));
+}
+
+void Shader::SetMat2(UniformHandle handle, const glm::mat2& mat) const
+{
+	if (m_uniforms->Update(handle, mat))
+		glUniformMatrix2fv(m_uniforms->GetLocation(handle), 1, GL_FALSE, glm::value_ptr(mat));
+}
+
+void Shader::SetMat3(UniformHandle handle, const glm::mat3& mat) const
+{
+	if (m_uniforms->Update(handle, mat))
+		glUniformMatrix3fv(m_uniforms->GetLocation(handle), 1, GL_FALSE, glm::value_ptr(mat));
+}
+
+void Shader::SetMat4(UniformHandle handle, const glm::mat4& mat) const
+{
+	if (m_uniforms->Update(handle, mat))
+		glUniformMatrix4fv(m_uniforms->GetLocation(handle), 1, GL_FALSE, glm::value_ptr(mat));
 }
 
 GLuint Shader::GetAttribLocation(const std::string& name) const
@@ -149,29 +167,5 @@ GLuint Shader::GetAttribLocation(const std::string& name) const
 
 void Shader::Use() // activate the shader
 {
-	glUseProgram(ID);
-}
-
-void Shader::CheckCompileErrors(const char* path, GLuint shader, std::string type)
-{
-	GLint success;
-	GLchar infoLog[1024];
-	if (type != "PROGRAM")
-	{
-		glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
-		if (!success)
-		{
-			glGetShaderInfoLog(shader, 1024, NULL, infoLog);
-			std::cout << std::format("[{}] ERROR::SHADER_COMPILATION_ERROR of type: {} \n {} \n-- -------------------------------------------------- - -- ", path, type, infoLog) << std::endl;
-		}
-	}
-	else
-	{
-		glGetProgramiv(shader, GL_LINK_STATUS, &success);
-		if (!success)
-		{
-			glGetProgramInfoLog(shader, 1024, NULL, infoLog);
-			std::cout << std::format("[{}] ERROR::PROGRAM_LINKING_ERROR of type: {} \n {} \n-- -------------------------------------------------- - -- ", path, type, infoLog) << std::endl;
-		}
-	}
-}
\ No newline at end of file
+	GLStateCache::GetInstance()->UseProgram(ID);
+}
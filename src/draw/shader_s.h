@@ -1,8 +1,11 @@
 #pragma once
 #include <glad/glad.h>
 #include <glm/glm.hpp>
+#include "uniform_table.h"
+#include "shader_source.h"
 
 #include <string>
+#include <memory>
 #include <fstream>
 #include <sstream>
 #include <iostream>
@@ -13,11 +16,14 @@ public:
 	unsigned int ID;
 	// constructor generates the shader on the fly
 	Shader(const char* vertexPath, const char* fragmentPath, const char* geometryPath = nullptr);
+	// a variant of the program, the defines are applied to every stage
+	Shader(const char* vertexPath, const char* fragmentPath, const ShaderDefines& defines);
 	void Use(); // activate the shader
 
 	// utility uniform functions
 	void SetBool(const std::string& name, bool value) const;
 	void SetInt(const std::string& name, int value) const;
+	void SetUInt(const std::string& name, uint32_t value) const;
 	void SetFloat(const std::string& name, float value) const;
 	void SetVec2(const std::string& name, const glm::vec2& value) const;
 	void SetVec2(const std::string& name, float x, float y) const;
@@ -28,8 +34,24 @@ public:
 	void SetMat2(const std::string& name, const glm::mat2& mat) const;
 	void SetMat3(const std::string& name, const glm::mat3& mat) const;
 	void SetMat4(const std::string& name, const glm::mat4& mat) const;
+
+	// handle based setters skip the name lookup, resolve the handle once with GetUniformHandle
+	void SetBool(UniformHandle handle, bool value) const;
+	void SetInt(UniformHandle handle, int value) const;
+	void SetUInt(UniformHandle handle, uint32_t value) const;
+	void SetFloat(UniformHandle handle, float value) const;
+	void SetVec2(UniformHandle handle, const glm::vec2& value) const;
+	void SetVec2(UniformHandle handle, float x, float y) const;
+	void SetVec3(UniformHandle handle, const glm::vec3& value) const;
+	void SetVec3(UniformHandle handle, float x, float y, float z) const;
+	void SetVec4(UniformHandle handle, const glm::vec4& value) const;
+	void SetVec4(UniformHandle handle, float x, float y, float z, float w);
+	void SetMat2(UniformHandle handle, const glm::mat2& mat) const;
+	void SetMat3(UniformHandle handle, const glm::mat3& mat) const;
+	void SetMat4(UniformHandle handle, const glm::mat4& mat) const;
+	UniformHandle GetUniformHandle(const std::string& name) const { return m_uniforms->Find(name); }
 	GLuint GetAttribLocation(const std::string& name) const;
 private:
-	// utility function for checking shader compilation/linking errors.
-	void CheckCompileErrors(const char* path, GLuint shader, std::string type);
+	// shared with every Shader of the same program, see ProgramCache
+	std::shared_ptr<UniformTable> m_uniforms = nullptr;
 };
@@ -0,0 +1,92 @@
+#include "shader_source.h"
+
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <unordered_set>
+
+namespace {
+	struct IncludeState {
+		std::unordered_set<std::string> included{};
+		int nextStringNumber = 1;
+	};
+
+	bool ReadFile(const std::filesystem::path& path, std::string& content)
+	{
+		std::ifstream file(path, std::ios::binary);
+		if (!file.is_open()) {
+			std::cout << std::format("ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: {}", path.generic_string()) << std::endl;
+			return false;
+		}
+		std::stringstream stream;
+		stream << file.rdbuf();
+		content = stream.str();
+		return true;
+	}
+
+	// returns the quoted file name of an #include line, empty for any other line
+	std::string GetIncludeName(const std::string& line)
+	{
+		size_t start = line.find_first_not_of(" \t");
+		if (start == std::string::npos || line.compare(start, 8, "#include") != 0)
+			return "";
+		size_t open = line.find('"', start + 8);
+		size_t close = open == std::string::npos ? std::string::npos : line.find('"', open + 1);
+		if (close == std::string::npos)
+			return "";
+		return line.substr(open + 1, close - open - 1);
+	}
+
+	bool Expand(const std::filesystem::path& path, int stringNumber, const ShaderDefines* defines, IncludeState& state, std::string& output)
+	{
+		std::string content;
+		if (!ReadFile(path, content))
+			return false;
+
+		std::istringstream stream(content);
+		std::string line;
+		int lineNumber = 0;
+		while (std::getline(stream, line)) {
+			lineNumber++;
+			if (!line.empty() && line.back() == '\r')
+				line.pop_back();
+
+			std::string includeName = GetIncludeName(line);
+			if (!includeName.empty()) {
+				std::filesystem::path includePath = (path.parent_path() / includeName).lexically_normal();
+				if (state.included.insert(includePath.generic_string()).second) {
+					int includeNumber = state.nextStringNumber++;
+					output += std::format("#line 1 {}\n", includeNumber);
+					if (!Expand(includePath, includeNumber, nullptr, state, output))
+						return false;
+				}
+				output += std::format("#line {} {}\n", lineNumber + 1, stringNumber);
+				continue;
+			}
+
+			output += line;
+			output += '\n';
+			if (defines && line.rfind("#version", 0) == 0) {
+				for (const auto& define : *defines) {
+					output += std::format("#define {}\n", define);
+				}
+				if (!defines->empty())
+					output += std::format("#line {} {}\n", lineNumber + 1, stringNumber);
+				// the main file's defines go in once
+				defines = nullptr;
+			}
+		}
+		return true;
+	}
+}
+
+bool LoadShaderSource(const std::string& path, const ShaderDefines& defines, std::string& source)
+{
+	IncludeState state;
+	std::filesystem::path mainPath = std::filesystem::path(path).lexically_normal();
+	state.included.insert(mainPath.generic_string());
+	source.clear();
+	return Expand(mainPath, 0, &defines, state, source);
+}
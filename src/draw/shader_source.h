@@ -0,0 +1,14 @@
+#pragma once
+#include <string>
+#include <vector>
+
+// preprocessor symbols of a program variant, "NAME" or "NAME VALUE"
+using ShaderDefines = std::vector<std::string>;
+
+// Reads a GLSL file into source and prepares it for glShaderSource.
+// The defines are inserted as #define lines right after the #version line. A line #include "file"
+// is replaced by that file, resolved relative to the including file and included once per source.
+// #line directives keep the compiler messages pointing at the original lines, the string number
+// of an included file is its position in the include order, the main file is 0.
+// Returns false when a file cannot be read.
+bool LoadShaderSource(const std::string& path, const ShaderDefines& defines, std::string& source);
@@ -1,15 +1,29 @@
 #include "texture.h"
+#include "gl_state_cache.h"
+#include "../utils/gpu_memory.h"
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb/stb_image.h"
+#include <memory>
 
 Texture::Texture(size_t tex_num) {
 	m_textures.resize(tex_num);
 	std::fill(m_textures.begin(), m_textures.end(), 0);
 }
 
+Texture::~Texture() {
+	auto tracker = GpuMemoryTracker::GetInstance();
+	for (uint32_t texture : m_textures) {
+		if (texture == 0)
+			continue;
+		tracker->Release(GpuMemoryTracker::Kind::Texture, texture);
+		GLStateCache::GetInstance()->OnDeleteTexture(texture);
+		glDeleteTextures(1, &texture);
+	}
+}
+
 int Texture::GenerateTexture(const std::string& path) {
 	glGenTextures(1, &m_textures[m_idx]);
-	glBindTexture(GL_TEXTURE_2D, m_textures[m_idx]);
+	GLStateCache::GetInstance()->BindTexture(GL_TEXTURE_2D, m_textures[m_idx]);
 	// set the texture wrapping parameters
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
@@ -19,9 +33,13 @@ int Texture::GenerateTexture(const std::string& path) {
 	// load image, create texture and generate mipmaps
 	int width, height, nrChannels;
 	stbi_set_flip_vertically_on_load(true); // tell stb_image.h to flip loaded texture's on the y-axis.
-	unsigned char* data = stbi_load(path.c_str(), &width, &height, &nrChannels, 0);
+	// owned, so the image is freed when Allocate throws GpuBudgetExceeded
+	std::unique_ptr<unsigned char, decltype(&stbi_image_free)> image(stbi_load(path.c_str(), &width, &height, &nrChannels, 0), &stbi_image_free);
+	unsigned char* data = image.get();
 	if (data)
 	{
+		// the rgb storage is padded to 4 bytes a texel
+		GpuMemoryTracker::GetInstance()->Allocate(GpuMemoryTracker::Kind::Texture, m_textures[m_idx], GpuMemoryTracker::GetTextureBytes(width, height, GL_RGB, true), "image texture");
 		if (nrChannels == 3) {
 			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
 		}
@@ -34,29 +52,30 @@ int Texture::GenerateTexture(const std::string& path) {
 	{
 		std::cout << "Failed to load texture" << std::endl;
 	}
-	stbi_image_free(data);
 	return m_idx++;
 }
 
 int Texture::GenerateTexture(int width, int height, uint32_t internal_format, uint32_t data_format, uint32_t data_type, Params& params, void* data)
 {
 	glGenTextures(1, &m_textures[m_idx]);
-	glBindTexture(GL_TEXTURE_2D, m_textures[m_idx]);
+	GLStateCache::GetInstance()->BindTexture(GL_TEXTURE_2D, m_textures[m_idx]);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filterTypeToGL[static_cast<int>(params.minFilter)]);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filterTypeToGL[static_cast<int>(params.magFilter)]);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrapTypeToGL[static_cast<int>(params.sWrap)]);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrapTypeToGL[static_cast<int>(params.tWrap)]);
+	GpuMemoryTracker::GetInstance()->Allocate(GpuMemoryTracker::Kind::Texture, m_textures[m_idx], GpuMemoryTracker::GetTextureBytes(width, height, internal_format), "texture");
 	glTexImage2D(GL_TEXTURE_2D, 0, internal_format, width, height, 0, data_format, data_type, data);
 	return m_idx++;
 }
 
 void Texture::UpdateTexture(size_t idx, int width, int height, uint32_t internal_format, uint32_t data_format, uint32_t data_type, Params& params, void* data)
 {
-	glBindTexture(GL_TEXTURE_2D, m_textures[idx]);
+	GLStateCache::GetInstance()->BindTexture(GL_TEXTURE_2D, m_textures[idx]);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filterTypeToGL[static_cast<int>(params.minFilter)]);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filterTypeToGL[static_cast<int>(params.magFilter)]);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrapTypeToGL[static_cast<int>(params.sWrap)]);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrapTypeToGL[static_cast<int>(params.tWrap)]);
+	GpuMemoryTracker::GetInstance()->Allocate(GpuMemoryTracker::Kind::Texture, m_textures[idx], GpuMemoryTracker::GetTextureBytes(width, height, internal_format), "texture");
 	glTexImage2D(GL_TEXTURE_2D, 0, internal_format, width, height, 0, data_format, data_type, data);
 }
 
@@ -65,6 +84,6 @@ uint32_t Texture::GetTexture(size_t idx) {
 }
 
 void Texture::BindTexture(size_t idx) {
-	glActiveTexture(GL_TEXTURE0 + static_cast<GLenum>(idx));
-	glBindTexture(GL_TEXTURE_2D, m_textures[idx]);
+	GLStateCache::GetInstance()->ActiveTexture(GL_TEXTURE0 + static_cast<GLenum>(idx));
+	GLStateCache::GetInstance()->BindTexture(GL_TEXTURE_2D, m_textures[idx]);
 }
\ No newline at end of file
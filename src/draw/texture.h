@@ -49,6 +49,9 @@ public:
 
 	std::vector<uint32_t> m_textures;
 	Texture(size_t tex_num);
+	~Texture();
+	Texture(const Texture&) = delete;
+	Texture& operator=(const Texture&) = delete;
 	int GenerateTexture(const std::string& path);
 	int GenerateTexture(int width, int height, uint32_t internal_format, uint32_t data_format, uint32_t data_type, Params& params, void* data);
 	void UpdateTexture(size_t idx, int width, int height, uint32_t internal_format, uint32_t data_format, uint32_t data_type, Params& params, void* data);
@@ -0,0 +1,49 @@
+#include "uniform_table.h"
+#include <algorithm>
+
+void UniformTable::Reflect(GLuint program)
+{
+	m_program = program;
+	m_entries.clear();
+	m_indices.clear();
+
+	GLint uniformCount = 0, maxNameLength = 0;
+	glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &uniformCount);
+	glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+	std::vector<GLchar> nameBuffer((std::max)(maxNameLength, 1));
+	for (GLint i = 0; i < uniformCount; i++) {
+		GLsizei length = 0;
+		GLint size = 0;
+		GLenum type = 0;
+		glGetActiveUniform(program, static_cast<GLuint>(i), static_cast<GLsizei>(nameBuffer.size()), &length, &size, &type, nameBuffer.data());
+		std::string name(nameBuffer.data(), length);
+		// members of uniform blocks have no location
+		GLint location = glGetUniformLocation(program, name.c_str());
+		if (location < 0)
+			continue;
+
+		int32_t index = static_cast<int32_t>(m_entries.size());
+		m_entries.push_back({ location });
+		m_indices[name] = index;
+		// arrays are reported as "name[0]", make the plain name resolve to the first element too
+		if (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0)
+			m_indices[name.substr(0, name.size() - 3)] = index;
+	}
+}
+
+UniformHandle UniformTable::Find(const std::string& name)
+{
+	auto it = m_indices.find(name);
+	if (it != m_indices.end())
+		return { it->second };
+
+	// other array elements are not reported by the reflection, resolve them once on first use
+	GLint location = glGetUniformLocation(m_program, name.c_str());
+	int32_t index = -1;
+	if (location >= 0) {
+		index = static_cast<int32_t>(m_entries.size());
+		m_entries.push_back({ location });
+	}
+	m_indices[name] = index;
+	return { index };
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <glad/glad.h>
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstring>
+#include <cstdint>
+
+// Index of a uniform in the UniformTable of one program, invalid when the program has no such uniform.
+struct UniformHandle
+{
+	int32_t index = -1;
+	bool IsValid() const { return index >= 0; }
+};
+
+// Locations of the active uniforms of a linked program, reflected once after link, together with
+// the last value uploaded through each of them so setting an unchanged value costs no GL call.
+class UniformTable
+{
+public:
+	void Reflect(GLuint program);
+	UniformHandle Find(const std::string& name);
+	GLint GetLocation(UniformHandle handle) const { return m_entries[handle.index].location; }
+	size_t GetSkippedCount() const { return m_skippedCount; }
+
+	// returns true when value differs from the last upload through handle, the caller then issues the glUniform call
+	template <typename T>
+	bool Update(UniformHandle handle, const T& value);
+
+private:
+	struct Entry {
+		GLint location = -1;
+		bool isSet = false;
+		uint8_t value[64] = {};  // large enough for a mat4
+	};
+
+	GLuint m_program = 0;
+	std::vector<Entry> m_entries{};
+	std::unordered_map<std::string, int32_t> m_indices{};
+	size_t m_skippedCount = 0;
+};
+
+template <typename T>
+inline bool UniformTable::Update(UniformHandle handle, const T& value)
+{
+	static_assert(sizeof(T) <= sizeof(Entry::value), "uniform value does not fit into the shadow copy");
+	if (!handle.IsValid())
+		return false;
+
+	Entry& entry = m_entries[handle.index];
+	if (entry.isSet && std::memcmp(entry.value, &value, sizeof(T)) == 0) {
+		m_skippedCount++;
+		return false;
+	}
+	std::memcpy(entry.value, &value, sizeof(T));
+	entry.isSet = true;
+	return true;
+}
@@ -4,6 +4,8 @@
 */
 
 #include "vertexbuffer.h"
+#include "gl_state_cache.h"
+#include "../utils/gpu_memory.h"
 
 #include <cassert>
 #include <string.h>
@@ -11,83 +13,34 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
-VertexBufferObject::VertexBufferObject(int targetIn, const std::vector<float>& data, unsigned int flags)
-{
-	target = targetIn;
-	glGenBuffers(1, &obj);
-	Bind();
-	if (targetIn == GL_ARRAY_BUFFER)
-		glBufferData(target, sizeof(float) * data.size(), (void*)data.data(), flags);
-	else
-		glBufferStorage(target, sizeof(float) * data.size(), (void*)data.data(), flags);
-	Unbind();
-	elementSize = 1;
-	type = GL_FLOAT;
-	numElements = (int)data.size();
-}
-
-VertexBufferObject::VertexBufferObject(int targetIn, const std::vector<glm::vec2>& data, unsigned int flags)
-{
-	target = targetIn;
-	glGenBuffers(1, &obj);
-	Bind();
-	if (targetIn == GL_ARRAY_BUFFER)
-		glBufferData(target, sizeof(glm::vec2) * data.size(), (void*)data.data(), flags);
-	else
-		glBufferStorage(target, sizeof(glm::vec2) * data.size(), (void*)data.data(), flags);
-	Unbind();
-	elementSize = 2;
-	type = GL_FLOAT;
-	numElements = (int)data.size();
-}
-
-VertexBufferObject::VertexBufferObject(int targetIn, const std::vector<glm::vec3>& data, unsigned int flags)
-{
-	target = targetIn;
-	glGenBuffers(1, &obj);
-	Bind();
-	if (targetIn == GL_ARRAY_BUFFER)
-		glBufferData(target, sizeof(glm::vec3) * data.size(), (void*)data.data(), flags);
-	else
-		glBufferStorage(target, sizeof(glm::vec3) * data.size(), (void*)data.data(), flags);
-	Unbind();
-	elementSize = 3;
-	type = GL_FLOAT;
-	numElements = (int)data.size();
-}
-
-VertexBufferObject::VertexBufferObject(int targetIn, const std::vector<glm::vec4>& data, unsigned int flags)
-{
-	target = targetIn;
-	glGenBuffers(1, &obj);
-	Bind();
-	if (targetIn == GL_ARRAY_BUFFER)
-		glBufferData(target, sizeof(glm::vec4) * data.size(), (void*)data.data(), flags);
-	else
-		glBufferStorage(target, sizeof(glm::vec4) * data.size(), (void*)data.data(), flags);
-	Unbind();
-	elementSize = 4;
-	type = GL_FLOAT;
-	numElements = (int)data.size();
-}
-
-VertexBufferObject::VertexBufferObject(int targetIn, const std::vector<uint32_t>& data, unsigned int flags)
+void VertexBufferObject::Create(int targetIn, const void* data, size_t size, unsigned int flags)
 {
 	target = targetIn;
+	byteSize = size;
+	immutable = targetIn != GL_ARRAY_BUFFER;
 	glGenBuffers(1, &obj);
+	try {
+		GpuMemoryTracker::GetInstance()->Allocate(GpuMemoryTracker::Kind::Buffer, obj, size, GpuMemoryTracker::GetBufferLabel(target));
+	}
+	catch (const GpuBudgetExceeded&) {
+		// the destructor does not run for a constructor that throws
+		glDeleteBuffers(1, &obj);
+		throw;
+	}
 	Bind();
-	if (targetIn == GL_ARRAY_BUFFER)
-		glBufferData(target, sizeof(uint32_t) * data.size(), (void*)data.data(), flags);
-	else
-		glBufferStorage(target, sizeof(uint32_t) * data.size(), (void*)data.data(), flags);
+	if (immutable) {
+		glBufferStorage(target, size, data, flags);
+	}
+	else {
+		usage = flags != 0 ? flags : GL_STATIC_DRAW;
+		glBufferData(target, size, data, usage);
+	}
 	Unbind();
-	elementSize = 1;
-	type = GL_INT;
-	numElements = (int)data.size();
 }
 
 VertexBufferObject::~VertexBufferObject()
 {
+	GpuMemoryTracker::GetInstance()->Release(GpuMemoryTracker::Kind::Buffer, obj);
 	glDeleteBuffers(1, &obj);
 }
 
@@ -101,51 +54,63 @@ void VertexBufferObject::Unbind() const
 	glBindBuffer(target, 0);
 }
 
-void VertexBufferObject::Update(const std::vector<float>& data)
+void VertexBufferObject::Respecify(const void* data, size_t size)
 {
+	GpuMemoryTracker::GetInstance()->Allocate(GpuMemoryTracker::Kind::Buffer, obj, size, GpuMemoryTracker::GetBufferLabel(target));
 	Bind();
-	glBufferSubData(target, 0, sizeof(float) * data.size(), (void*)data.data());
+	glBufferData(target, size, data, usage);
 	Unbind();
+	byteSize = size;
 }
 
-void VertexBufferObject::Update(const std::vector<glm::vec2>& data)
+void VertexBufferObject::Upload(size_t byteOffset, const void* data, size_t size, bool orphan)
 {
+	assert(byteOffset + size <= byteSize);
+	if (orphan)
+		Orphan();
+	if (size == 0)
+		return;
 	Bind();
-	glBufferSubData(target, 0, sizeof(glm::vec2) * data.size(), (void*)data.data());
+	glBufferSubData(target, byteOffset, size, data);
 	Unbind();
 }
 
-void VertexBufferObject::Update(const std::vector<glm::vec3>& data)
+void VertexBufferObject::Orphan()
 {
+	if (immutable) {
+		glInvalidateBufferData(obj);
+		return;
+	}
+	// respecifying with the same size lets the driver hand out fresh memory while draws finish with the old one
 	Bind();
-	glBufferSubData(target, 0, sizeof(glm::vec3) * data.size(), (void*)data.data());
+	glBufferData(target, byteSize, nullptr, usage);
 	Unbind();
 }
 
-void VertexBufferObject::Update(const std::vector<glm::vec4>& data)
+void* VertexBufferObject::Map(size_t byteOffset, size_t size, GLbitfield access)
 {
+	assert(byteOffset + size <= byteSize);
 	Bind();
-	glBufferSubData(target, 0, sizeof(glm::vec4) * data.size(), (void*)data.data());
+	void* mapped = glMapBufferRange(target, byteOffset, size, access);
 	Unbind();
+	return mapped;
 }
 
-void VertexBufferObject::Update(const std::vector<uint32_t>& data)
+void VertexBufferObject::Unmap()
 {
 	Bind();
-	glBufferSubData(target, 0, sizeof(uint32_t) * data.size(), (void*)data.data());
+	glUnmapBuffer(target);
 	Unbind();
 }
 
-void VertexBufferObject::Read(std::vector<uint32_t>& data)
+void VertexBufferObject::ReadBytes(void* data, size_t size)
 {
 	Bind();
-	size_t bufferSize = sizeof(uint32_t) * data.size();
-	assert(bufferSize == (elementSize * sizeof(uint32_t) * numElements));
-	//void* rawBuffer = glMapBuffer(target, GL_READ_ONLY);
-	void* rawBuffer = glMapBufferRange(target, 0, bufferSize, GL_MAP_READ_BIT);
+	assert(size <= byteSize);
+	void* rawBuffer = glMapBufferRange(target, 0, size, GL_MAP_READ_BIT);
 	if (rawBuffer)
 	{
-		memcpy((void*)data.data(), rawBuffer, bufferSize);
+		memcpy(data, rawBuffer, size);
 	}
 	glUnmapBuffer(target);
 	Unbind();
@@ -158,22 +123,23 @@ VertexArrayObject::VertexArrayObject()
 
 VertexArrayObject::~VertexArrayObject()
 {
+	GLStateCache::GetInstance()->OnDeleteVertexArray(obj);
 	glDeleteVertexArrays(1, &obj);
 }
 
 void VertexArrayObject::Bind() const
 {
-	glBindVertexArray(obj);
+	GLStateCache::GetInstance()->BindVertexArray(obj);
 }
 
 void VertexArrayObject::Unbind() const
 {
-	glBindVertexArray(0);
+	GLStateCache::GetInstance()->BindVertexArray(0);
 }
 
 void VertexArrayObject::SetAttribBuffer(int loc, std::shared_ptr<VertexBufferObject> attribBuffer)
 {
-	assert(attribBuffer->target == GL_ARRAY_BUFFER);
+	assert(attribBuffer->target == GL_ARRAY_BUFFER && attribBuffer->elementSize > 0);
 	Bind();
 	attribBuffer->Bind();
 	glVertexAttribPointer(loc, attribBuffer->elementSize, attribBuffer->type, attribBuffer->normalized,
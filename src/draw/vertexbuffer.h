@@ -8,7 +8,19 @@
 #include <memory>
 #include <stdint.h>
 #include <vector>
+#include <span>
+#include <cassert>
+#include <type_traits>
 #include <glad/glad.h>
+
+// attribute layout of a buffer element, SIZE 0 marks types that are only used as storage
+template <typename T> struct VertexElement { static constexpr int SIZE = 0; static constexpr GLenum TYPE = GL_FLOAT; };
+template <> struct VertexElement<float> { static constexpr int SIZE = 1; static constexpr GLenum TYPE = GL_FLOAT; };
+template <> struct VertexElement<glm::vec2> { static constexpr int SIZE = 2; static constexpr GLenum TYPE = GL_FLOAT; };
+template <> struct VertexElement<glm::vec3> { static constexpr int SIZE = 3; static constexpr GLenum TYPE = GL_FLOAT; };
+template <> struct VertexElement<glm::vec4> { static constexpr int SIZE = 4; static constexpr GLenum TYPE = GL_FLOAT; };
+template <> struct VertexElement<uint32_t> { static constexpr int SIZE = 1; static constexpr GLenum TYPE = GL_INT; };
+
 class VertexArrayObject;
 class VertexBufferObject
 {
@@ -23,26 +35,74 @@ public:
 	// flags can one of the following bitfields.
 	//     GL_DYNAMIC_STORAGE_BIT, GL_MAP_READ_BIT, GL_MAP_WRITE_BIT, GL_MAP_PERSISTENT_BIT
 	//     GL_MAP_COHERENT_BIT, GL_CLIENT_STORAGE_BIT
-	VertexBufferObject(int targetIn, const std::vector<float>& data, unsigned int flags = 0);
-	VertexBufferObject(int targetIn, const std::vector<glm::vec2>& data, unsigned int flags = 0);
-	VertexBufferObject(int targetIn, const std::vector<glm::vec3>& data, unsigned int flags = 0);
-	VertexBufferObject(int targetIn, const std::vector<glm::vec4>& data, unsigned int flags = 0);
-	VertexBufferObject(int targetIn, const std::vector<uint32_t>& data, unsigned int flags = 0);
+	// GL_ARRAY_BUFFER keeps mutable storage and takes a usage hint such as GL_DYNAMIC_DRAW as flags instead,
+	// every other target gets immutable storage, which needs GL_DYNAMIC_STORAGE_BIT to be updated.
+	template <typename T>
+	VertexBufferObject(int targetIn, std::span<const T> data, unsigned int flags = 0)
+	{
+		static_assert(std::is_trivially_copyable_v<T>, "buffer elements are copied bytewise");
+		elementSize = VertexElement<T>::SIZE;
+		type = VertexElement<T>::TYPE;
+		numElements = (int)data.size();
+		Create(targetIn, data.data(), data.size_bytes(), flags);
+	}
+	template <typename T>
+	VertexBufferObject(int targetIn, const std::vector<T>& data, unsigned int flags = 0) :
+		VertexBufferObject(targetIn, std::span<const T>(data), flags) {}
 	VertexBufferObject(const VertexBufferObject& orig) = delete;
 	~VertexBufferObject();
 
 	void Bind() const;
 	void Unbind() const;
 
-	void Update(const std::vector<float>& data);
-	void Update(const std::vector<glm::vec2>& data);
-	void Update(const std::vector<glm::vec3>& data);
-	void Update(const std::vector<glm::vec4>& data);
-	void Update(const std::vector<uint32_t>& data);
-	void Read(std::vector<uint32_t>& data);
+	// uploads the whole vector from the start of the buffer, mutable storage grows to fit it
+	template <typename T>
+	void Update(const std::vector<T>& data)
+	{
+		if (data.size() * sizeof(T) > byteSize) {
+			assert(!immutable && "immutable storage cannot grow");
+			numElements = (int)data.size();
+			Respecify(data.data(), data.size() * sizeof(T));
+			return;
+		}
+		Upload(0, data.data(), data.size() * sizeof(T), false);
+	}
+	// uploads data[offset, offset + count) to the same elements of the buffer. With orphan the storage is
+	// invalidated first (invalidate-and-respecify), so a draw still reading the old contents does not stall
+	// the upload; only use it when the elements outside the range are not read again before they are rewritten
+	template <typename T>
+	void UpdateRange(const std::vector<T>& data, size_t offset, size_t count, bool orphan = false)
+	{
+		assert(offset + count <= data.size());
+		Upload(offset * sizeof(T), data.data() + offset, count * sizeof(T), orphan);
+	}
+	// drops the contents of the whole buffer without changing its size
+	void Orphan();
+
+	// maps count elements from offset for writing, the previous contents of the range are discarded.
+	// Immutable storage needs GL_MAP_WRITE_BIT, write the range and Unmap before the buffer is used again
+	template <typename T>
+	T* MapRange(size_t offset, size_t count, GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT)
+	{
+		return static_cast<T*>(Map(offset * sizeof(T), count * sizeof(T), access));
+	}
+	void Unmap();
+
+	template <typename T>
+	void Read(std::vector<T>& data)
+	{
+		ReadBytes(data.data(), data.size() * sizeof(T));
+	}
 	uint32_t GetObj() const { return obj; }
+	size_t GetSize() const { return byteSize; }
 	void SetOffset(int _offset) { offset = _offset; }
 protected:
+	void Create(int targetIn, const void* data, size_t size, unsigned int flags);
+	void Respecify(const void* data, size_t size);
+	void Upload(size_t byteOffset, const void* data, size_t size, bool orphan);
+	void* Map(size_t byteOffset, size_t size, GLbitfield access);
+	void ReadBytes(void* data, size_t size);
+
 	int target;
 	uint32_t obj = 0;
 	GLenum type = GL_FLOAT;
@@ -51,6 +111,9 @@ protected:
 	int offset = 0;
 	int elementSize;  // vec2 = 2, vec3 = 3 etc.
 	int numElements;  // number of vec2, vec3 in buffer
+	size_t byteSize = 0;
+	bool immutable = false;  // glBufferStorage, the size is fixed
+	unsigned int usage = GL_STATIC_DRAW;  // of mutable storage
 };
 
 class VertexArrayObject
@@ -5,6 +5,9 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <functional>
+#include <charconv>
+#include <cstring>
+#include <cstdint>
 
 // common
 #include "manager/glfw_mgr.h"
@@ -18,15 +21,116 @@
 // custom
 #include "draw/camera.h"
 #include "draw/render_main.h"
+#include "utils/gpu_memory.h"
 
-int main() {
-	auto render_main = RenderMain::GetInstance();
+static void PrintUsage(const char* program)
+{
+	std::cerr << "Usage: " << program << " [--headless <frames> <output dir>] [--size <width> <height>] [--gpu-budget <MB>]\n"
+		<< "       [--record <path>] [--replay <path>] [--batch <cameras.json> <output dir>] [--cpu-render <config> <out.png>]" << std::endl;
+}
+
+// the whole argument has to be a number greater than zero
+template<typename T>
+static bool ParsePositive(const char* text, T& value)
+{
+	const char* end = text + std::strlen(text);
+	T parsed{};
+	auto [ptr, ec] = std::from_chars(text, end, parsed);
+	if (ec != std::errc() || ptr != end || parsed <= 0)
+		return false;
+	value = parsed;
+	return true;
+}
+
+int main(int argc, char** argv) {
+	// --headless <frames> <output dir>: render offscreen without a window, write png files and exit
+	// --cpu-render <config> <out.png>: render the gaussians of a config with the software rasterizer, no GL context needed
+	// --size <width> <height>: image size of the headless frames and of the cpu render
+	// --gpu-budget <MB>: objects of a scene that would take the gpu memory in use past it are not loaded
+	bool headless = false;
+	size_t headlessFrames = 0;
+	std::string headlessDir = "";
+	int headlessWidth = SCR_WIDTH, headlessHeight = SCR_HEIGHT;
+	std::string cpuRenderConfig = "", cpuRenderPath = "";
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if (arg == "--headless") {
+			if (i + 2 >= argc || !ParsePositive(argv[i + 1], headlessFrames)) {
+				std::cerr << "--headless expects a positive frame count and an output directory" << std::endl;
+				PrintUsage(argv[0]);
+				return -1;
+			}
+			headless = true;
+			headlessDir = argv[i + 2];
+			i += 2;
+		}
+		else if (arg == "--cpu-render") {
+			if (i + 2 >= argc) {
+				std::cerr << "--cpu-render expects a config and an output png" << std::endl;
+				PrintUsage(argv[0]);
+				return -1;
+			}
+			cpuRenderConfig = argv[i + 1];
+			cpuRenderPath = argv[i + 2];
+			i += 2;
+		}
+		else if (arg == "--size") {
+			if (i + 2 >= argc || !ParsePositive(argv[i + 1], headlessWidth) || !ParsePositive(argv[i + 2], headlessHeight)) {
+				std::cerr << "--size expects a positive width and height" << std::endl;
+				PrintUsage(argv[0]);
+				return -1;
+			}
+			i += 2;
+		}
+		else if (arg == "--gpu-budget") {
+			size_t budgetMB = 0;
+			if (i + 1 >= argc || !ParsePositive(argv[i + 1], budgetMB) || budgetMB > (SIZE_MAX >> 20)) {
+				std::cerr << "--gpu-budget expects a positive size in MB" << std::endl;
+				PrintUsage(argv[0]);
+				return -1;
+			}
+			GpuMemoryTracker::GetInstance()->SetBudget(budgetMB << 20);
+			i += 1;
+		}
+	}
+	if (!cpuRenderConfig.empty())
+		return RenderMain::RenderCpuReference(cpuRenderConfig, headlessWidth, headlessHeight, cpuRenderPath) ? 0 : -1;
+
+	auto render_main = RenderMain::GetInstance(headless);
 	std::vector<std::string> configs = Registry::RegisterConfigPath::GetConfigPath(Registry::Operator::CURRENT);
 	render_main->SetupRenderObjs(configs);
+
+	// --record <path>: record the camera of every frame until the window closes
+	// --replay <path>: replay a recorded path, write <path>.timings.csv and exit
+	// --batch <cameras.json> <output dir>: render every training view to png and exit
+	auto cameraPath = render_main->GetCameraPath();
+	for (int i = 1; i + 1 < argc; i++) {
+		std::string arg = argv[i];
+		if (arg == "--batch" && i + 2 < argc) {
+			return render_main->RenderBatch(argv[i + 1], argv[i + 2]) ? 0 : -1;
+		}
+		else if (arg == "--record" && !headless) {
+			cameraPath->SetPath(argv[++i]);
+			cameraPath->StartRecording();
+		}
+		else if (arg == "--replay") {
+			if (!render_main->StartReplay(argv[++i], true))
+				return -1;
+		}
+	}
+
+	if (headless)
+		return render_main->RenderHeadless(headlessFrames, headlessWidth, headlessHeight, headlessDir) ? 0 : -1;
+
 	while (!glfwWindowShouldClose(render_main->GetWindow())) {
 		render_main->PrepareDraw();
 		render_main->Draw();
 		render_main->FinishDraw();
 	}
+
+	if (cameraPath->GetMode() == CameraPath::RECORDING) {
+		cameraPath->StopRecording();
+		cameraPath->Save();
+	}
 	return 0;
 }
\ No newline at end of file
@@ -61,12 +61,12 @@ void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods
 			if (key == GLFW_KEY_LEFT)
 			{
 				std::vector<std::string> path = Registry::RegisterConfigPath::GetConfigPath(Registry::Operator::PREVIOUS);
-				instance->SetupRenderObjs(path);
+				instance->RequestRenderObjs(path);
 			}
 			if (key == GLFW_KEY_RIGHT)
 			{
 				std::vector<std::string> path = Registry::RegisterConfigPath::GetConfigPath(Registry::Operator::NEXT);
-				instance->SetupRenderObjs(path);
+				instance->RequestRenderObjs(path);
 			}
 		}
 	}
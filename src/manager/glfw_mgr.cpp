@@ -1,4 +1,5 @@
 #include "glfw_mgr.h"
+#include "../draw/program_cache.h"
 
 void DefaultFramebufferSizeCallback(GLFWwindow* window, int width, int height)
 {
@@ -39,8 +40,8 @@ std::shared_ptr<GLFWManager> GLFWManager::GetInstance(int screen_width = 0, int
 	std::lock_guard<std::mutex> lock(mutex);
 
 	if (m_instance == nullptr) {
-		assert(screen_width, "screen width should not be zero when first init!");
-		assert(screen_height, "screen height should not be zero when first init!");
+		assert(screen_width && "screen width should not be zero when first init!");
+		assert(screen_height && "screen height should not be zero when first init!");
 		m_instance = std::make_shared<GLFWManager>(screen_width, screen_height);
 	}
 	return m_instance;
@@ -120,6 +121,7 @@ GLFWManager::GLFWManager(int screen_width, int screen_height)
 		std::cout << "Failed to initialize GLAD" << std::endl;
 		return;
 	}
+	ProgramCache::SetProcLoader((GLADloadproc)glfwGetProcAddress);
 
 	// query limitations
 // -----------------
@@ -0,0 +1,142 @@
+#include "headless_mgr.h"
+#include "../draw/program_cache.h"
+#include <cstring>
+
+#ifdef TINYRENDERER_EGL
+#ifndef EGL_PLATFORM_SURFACELESS_MESA
+#define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+#endif
+#endif
+
+std::shared_ptr<HeadlessManager> HeadlessManager::m_instance = nullptr;
+
+std::shared_ptr<HeadlessManager> HeadlessManager::GetInstance()
+{
+	static std::mutex mutex;
+	std::lock_guard<std::mutex> lock(mutex);
+
+	if (m_instance == nullptr) {
+		m_instance = std::make_shared<HeadlessManager>();
+	}
+	return m_instance;
+}
+
+HeadlessManager::HeadlessManager()
+{
+	m_isValid = CreateContext();
+	if (!m_isValid)
+		return;
+
+#ifdef TINYRENDERER_EGL
+	GLADloadproc loader = reinterpret_cast<GLADloadproc>(eglGetProcAddress);
+#else
+	GLADloadproc loader = reinterpret_cast<GLADloadproc>(glfwGetProcAddress);
+#endif
+	if (!gladLoadGLLoader(loader)) {
+		std::cout << "Failed to initialize GLAD" << std::endl;
+		m_isValid = false;
+		return;
+	}
+	ProgramCache::SetProcLoader(loader);
+	std::cout << std::format("Headless OpenGL context: {} ({})",
+		reinterpret_cast<const char*>(glGetString(GL_VERSION)), reinterpret_cast<const char*>(glGetString(GL_RENDERER))) << std::endl;
+}
+
+#ifdef TINYRENDERER_EGL
+bool HeadlessManager::CreateContext()
+{
+	auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+	if (getPlatformDisplay)
+		m_display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+	if (m_display == EGL_NO_DISPLAY)
+		m_display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+	EGLint major = 0, minor = 0;
+	if (m_display == EGL_NO_DISPLAY || !eglInitialize(m_display, &major, &minor)) {
+		std::cout << "Failed to initialize EGL" << std::endl;
+		return false;
+	}
+
+	const EGLint configAttributes[] = {
+		EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_RED_SIZE, 8,
+		EGL_GREEN_SIZE, 8,
+		EGL_BLUE_SIZE, 8,
+		EGL_ALPHA_SIZE, 8,
+		EGL_DEPTH_SIZE, 24,
+		EGL_NONE
+	};
+	EGLConfig config = nullptr;
+	EGLint configCount = 0;
+	if (!eglChooseConfig(m_display, configAttributes, &config, 1, &configCount) || configCount == 0) {
+		std::cout << "Failed to choose an EGL config" << std::endl;
+		return false;
+	}
+
+	eglBindAPI(EGL_OPENGL_API);
+	const EGLint contextAttributes[] = {
+		EGL_CONTEXT_MAJOR_VERSION, 4,
+		EGL_CONTEXT_MINOR_VERSION, 4,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+		EGL_NONE
+	};
+	m_context = eglCreateContext(m_display, config, EGL_NO_CONTEXT, contextAttributes);
+	if (m_context == EGL_NO_CONTEXT) {
+		std::cout << "Failed to create an OpenGL 4.4 core EGL context" << std::endl;
+		return false;
+	}
+
+	// everything is drawn into framebuffer objects, the default framebuffer is never used
+	const char* extensions = eglQueryString(m_display, EGL_EXTENSIONS);
+	if (extensions == nullptr || std::strstr(extensions, "EGL_KHR_surfaceless_context") == nullptr) {
+		const EGLint pbufferAttributes[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+		m_surface = eglCreatePbufferSurface(m_display, config, pbufferAttributes);
+	}
+	if (!eglMakeCurrent(m_display, m_surface, m_surface, m_context)) {
+		std::cout << "Failed to make the EGL context current" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+HeadlessManager::~HeadlessManager()
+{
+	if (m_display == EGL_NO_DISPLAY)
+		return;
+	eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	if (m_surface != EGL_NO_SURFACE)
+		eglDestroySurface(m_display, m_surface);
+	if (m_context != EGL_NO_CONTEXT)
+		eglDestroyContext(m_display, m_context);
+	eglTerminate(m_display);
+}
+#else
+bool HeadlessManager::CreateContext()
+{
+	glfwInit();
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 4);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+#ifdef __APPLE__
+	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+	m_window = glfwCreateWindow(1, 1, "TinyRenderer Headless", NULL, NULL);
+	if (m_window == NULL) {
+		std::cout << "Failed to create hidden GLFW window" << std::endl;
+		glfwTerminate();
+		return false;
+	}
+	glfwMakeContextCurrent(m_window);
+	return true;
+}
+
+HeadlessManager::~HeadlessManager()
+{
+	if (m_window)
+		glfwDestroyWindow(m_window);
+	glfwTerminate();
+	m_window = nullptr;
+}
+#endif
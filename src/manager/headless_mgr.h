@@ -0,0 +1,41 @@
+#pragma once
+#include <glad/glad.h>
+#include <mutex>
+#include <memory>
+#include <iostream>
+#include <format>
+
+#ifdef TINYRENDERER_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#else
+#include <GLFW/glfw3.h>
+#endif
+
+// OpenGL context without a visible window, used by the headless mode.
+// Built with TINYRENDERER_EGL it asks EGL for a surfaceless context (Mesa llvmpipe works on machines
+// without a display), falling back to a 1x1 pbuffer when surfaceless contexts are not supported.
+// Without EGL it creates a hidden GLFW window, which still needs a display but no input handling.
+class HeadlessManager {
+public:
+	HeadlessManager(const HeadlessManager&) = delete;
+	HeadlessManager& operator=(const HeadlessManager&) = delete;
+	static std::shared_ptr<HeadlessManager> GetInstance();
+	bool IsValid() const { return m_isValid; }
+	explicit HeadlessManager();
+	~HeadlessManager();
+
+private:
+	bool CreateContext();
+
+private:
+	static std::shared_ptr<HeadlessManager> m_instance;
+	bool m_isValid = false;
+#ifdef TINYRENDERER_EGL
+	EGLDisplay m_display = EGL_NO_DISPLAY;
+	EGLContext m_context = EGL_NO_CONTEXT;
+	EGLSurface m_surface = EGL_NO_SURFACE;
+#else
+	GLFWwindow* m_window = nullptr;
+#endif
+};
@@ -8,7 +8,7 @@ std::shared_ptr<ImGuiManager> ImGuiManager::GetInstance(GLFWwindow* window)
 	std::lock_guard<std::mutex> lock(mutex);
 
 	if (instance == nullptr) {
-		assert(window, "Window should not be nullptr when first init!");
+		assert(window && "Window should not be nullptr when first init!");
 		instance = std::make_shared<ImGuiManager>(window);
 	}
 	return instance;
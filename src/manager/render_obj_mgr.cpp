@@ -1,11 +1,15 @@
 #include <mutex>
+#include <algorithm>
+#include <imgui/imgui.h>
 #include "render_obj_mgr.h"
 #include "../parser/config_parser.h"
+#include "../utils/gpu_memory.h"
 
 std::shared_ptr<RenderObjectManager> RenderObjectManager::m_instance = nullptr;
 RenderObjectManager::RenderObjectManager()
 {
 	m_register_render_obj = Registry::RenderObjectFactory::GetRegisterRenderObj();
+	m_loader = std::make_unique<ThreadPool>();
 }
 
 std::vector<std::shared_ptr<Parser::RenderObjConfigBase>>& RenderObjectManager::GetObjConfigs()
@@ -35,27 +39,257 @@ std::shared_ptr<RenderObjectManager> RenderObjectManager::GetInstance()
 
 void RenderObjectManager::InitRenderObjs(std::vector<std::string>& config_paths)
 {
-	ResetRenderObjs();
-	auto parser = Parser::ConfigParser(m_obj_configs);
-	for (auto path : config_paths) {
-		parser.Parse(path);
+	std::string key = GetSceneKey(config_paths);
+	m_requestedKey = key;
+	auto scene = FindCachedScene(key);
+	if (scene == nullptr) {
+		auto pending = std::find_if(m_pending.begin(), m_pending.end(), [&key](const auto& s) { return s->key == key; });
+		if (pending != m_pending.end()) {
+			scene = *pending;
+			m_pending.erase(pending);
+		}
+		else {
+			scene = StartLoad(config_paths);
+		}
+		FinishLoad(*scene);
+		m_cache.push_front(scene);
 	}
+	ActivateScene(scene);
+	TrimCache();
+}
 
-	for (size_t i = 0; i < m_obj_configs.size(); i++) {
-		auto& obj_config = m_obj_configs[i];
-		std::string& obj_type = obj_config->objType;
-		if (m_register_render_obj.count(obj_type)) {
-			m_render_objs.emplace_back(m_register_render_obj[obj_type](obj_config));
+void RenderObjectManager::RequestScene(const std::vector<std::string>& config_paths)
+{
+	std::string key = GetSceneKey(config_paths);
+	m_requestedKey = key;
+	if (FindCachedScene(key) != nullptr)
+		return;  // swapped in by the next PollScene
+	bool isPending = std::any_of(m_pending.begin(), m_pending.end(), [&key](const auto& s) { return s->key == key; });
+	if (!isPending)
+		m_pending.push_back(StartLoad(config_paths));
+}
+
+bool RenderObjectManager::PollScene()
+{
+	// parsed scenes get their objects here, scenes whose cpu phase finished get their gl resources and join
+	// the cache, also those that were superseded by a later request while loading
+	for (auto it = m_pending.begin(); it != m_pending.end();) {
+		Scene& scene = **it;
+		if (scene.parse.valid()) {
+			if (scene.parse.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+				++it;
+				continue;
+			}
+			ConstructObjs(scene);
 		}
-		else {
-			std::cerr << std::format("Error occur: the object: {} is not regisered yet.", obj_type) << std::endl;
+		if (!IsLoaded(scene)) {
+			++it;
+			continue;
+		}
+		FinishLoad(scene);
+		m_cache.push_back(*it);
+		it = m_pending.erase(it);
+	}
+
+	bool changed = false;
+	if (!m_requestedKey.empty() && (m_current == nullptr || m_current->key != m_requestedKey)) {
+		auto scene = FindCachedScene(m_requestedKey);
+		if (scene != nullptr) {
+			ActivateScene(scene);
+			changed = true;
+		}
+	}
+	TrimCache();
+	return changed;
+}
+
+void RenderObjectManager::SetCacheBudget(size_t bytes)
+{
+	m_cacheBudget = bytes;
+	TrimCache();
+}
+
+void RenderObjectManager::ImGuiCallback()
+{
+	static bool isFolded = true;
+	if (ImGui::CollapsingHeader("Scene Cache", &isFolded, ImGuiTreeNodeFlags_DefaultOpen))  // default open
+	{
+		size_t totalUsage = 0;
+		for (const auto& scene : m_cache) {
+			totalUsage += scene->memoryUsage;
+		}
+		int budgetMB = static_cast<int>(m_cacheBudget >> 20);
+		if (ImGui::InputInt("Budget (MB)", &budgetMB, 256, 1024))
+			SetCacheBudget(static_cast<size_t>((std::max)(budgetMB, 0)) << 20);
+		ImGui::Text("%zu scenes, %.1f MB resident", m_cache.size(), totalUsage / (1024.0 * 1024.0));
+		for (const auto& scene : m_cache) {
+			ImGui::BulletText("%s%s (%.1f MB)", scene->key.c_str(), scene == m_current ? " [current]" : "", scene->memoryUsage / (1024.0 * 1024.0));
+		}
+		for (const auto& scene : m_pending) {
+			ImGui::BulletText("%s (loading)", scene->key.c_str());
 		}
 	}
 }
 
 void RenderObjectManager::ResetRenderObjs()
 {
+	for (auto& scene : m_pending) {
+		if (scene->parse.valid())
+			scene->parse.wait();
+		for (auto& load : scene->loads) {
+			if (load.valid())
+				load.wait();
+		}
+	}
+	m_pending.clear();
+	m_cache.clear();
+	m_current = nullptr;
+	m_requestedKey.clear();
 	m_render_objs.clear();
 	m_obj_configs.clear();
 }
 
+std::string RenderObjectManager::GetSceneKey(const std::vector<std::string>& config_paths) const
+{
+	std::string key = "";
+	for (const auto& path : config_paths) {
+		key += key.empty() ? path : ";" + path;
+	}
+	return key;
+}
+
+std::shared_ptr<RenderObjectManager::Scene> RenderObjectManager::FindCachedScene(const std::string& key)
+{
+	auto it = std::find_if(m_cache.begin(), m_cache.end(), [&key](const auto& scene) { return scene->key == key; });
+	if (it == m_cache.end())
+		return nullptr;
+	// move to the front, it is the most recently used one now
+	m_cache.splice(m_cache.begin(), m_cache, it);
+	return m_cache.front();
+}
+
+std::shared_ptr<RenderObjectManager::Scene> RenderObjectManager::StartLoad(const std::vector<std::string>& config_paths)
+{
+	auto scene = std::make_shared<Scene>();
+	scene->key = GetSceneKey(config_paths);
+	scene->start = std::chrono::steady_clock::now();
+	// the objects are constructed once the configs are parsed, their constructors already create gl resources
+	scene->parse = m_loader->Enqueue([config_paths, key = scene->key]() {
+		std::vector<std::shared_ptr<Parser::RenderObjConfigBase>> configs;
+		for (const auto& path : config_paths) {
+			// a broken config file only loses its own objects
+			std::vector<std::shared_ptr<Parser::RenderObjConfigBase>> parsed;
+			try {
+				Parser::ConfigParser(parsed).Parse(path);
+			}
+			catch (const std::exception& e) {
+				std::cerr << std::format("Error occur while parsing {} of {}: {}", path, key, e.what()) << std::endl;
+				continue;
+			}
+			configs.insert(configs.end(), parsed.begin(), parsed.end());
+		}
+		return configs;
+		});
+	return scene;
+}
+
+void RenderObjectManager::ConstructObjs(Scene& scene)
+{
+	auto tracker = GpuMemoryTracker::GetInstance();
+	auto configs = scene.parse.get();
+	for (size_t i = 0; i < configs.size(); i++) {
+		auto& obj_config = configs[i];
+		std::string& obj_type = obj_config->objType;
+		if (!m_register_render_obj.count(obj_type)) {
+			std::cerr << std::format("Error occur: the object: {} is not regisered yet.", obj_type) << std::endl;
+			continue;
+		}
+		std::shared_ptr<Renderable::RenderObjectBase> obj = nullptr;
+		try {
+			// charged to the config until the object exists, and refused like the gl phase when over the budget
+			GpuMemoryOwnerScope owner(obj_config.get(), true);
+			obj = m_register_render_obj[obj_type](obj_config);
+		}
+		catch (const std::exception& e) {
+			tracker->RemoveOwner(obj_config.get());
+			std::cerr << std::format("Error occur while creating object {} of {}: {}", i, scene.key, e.what()) << std::endl;
+			continue;
+		}
+		tracker->TransferOwner(obj_config.get(), obj.get());
+		tracker->SetOwnerName(obj.get(), std::format("{} {} of {}", obj_type, i, scene.key));
+		scene.configs.push_back(obj_config);
+		scene.objs.push_back(obj);
+		// parse and pack the assets of every object on the loader threads, the gl phase follows in FinishLoad
+		scene.loads.push_back(m_loader->Enqueue([obj]() { obj->LoadData(); }));
+	}
+}
+
+bool RenderObjectManager::IsLoaded(const Scene& scene) const
+{
+	return std::all_of(scene.loads.begin(), scene.loads.end(), [](const auto& load) {
+		return load.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+		});
+}
+
+void RenderObjectManager::FinishLoad(Scene& scene)
+{
+	if (scene.parse.valid())
+		ConstructObjs(scene);
+	// create the gl resources on this thread in config order, waiting for each object in turn. The configs
+	// of dropped objects are dropped with them, they are looked up by the index of the object
+	std::vector<std::shared_ptr<Parser::RenderObjConfigBase>> configs;
+	std::vector<std::shared_ptr<Renderable::RenderObjectBase>> objs;
+	for (size_t i = 0; i < scene.objs.size(); i++) {
+		try {
+			scene.loads[i].get();
+		}
+		catch (const std::exception& e) {
+			std::cerr << std::format("Error occur while loading object {} of {}: {}", i, scene.key, e.what()) << std::endl;
+			continue;
+		}
+		try {
+			GpuMemoryOwnerScope owner(scene.objs[i].get(), true);
+			scene.objs[i]->SetUpGL();
+		}
+		catch (const std::exception& e) {
+			// dropping the object frees what it allocated before the refusal
+			std::cerr << std::format("Error occur while loading object {} of {}: {}", i, scene.key, e.what()) << std::endl;
+			continue;
+		}
+		scene.memoryUsage += scene.objs[i]->GetMemoryUsage();
+		configs.push_back(scene.configs[i]);
+		objs.push_back(scene.objs[i]);
+	}
+	scene.loads.clear();
+
+	float seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - scene.start).count();
+	std::cout << std::format("Loaded {} / {} objects of {} in {:.2f} s ({:.1f} MB)",
+		objs.size(), scene.objs.size(), scene.key, seconds, scene.memoryUsage / (1024.0 * 1024.0)) << std::endl;
+	scene.configs = std::move(configs);
+	scene.objs = std::move(objs);
+}
+
+void RenderObjectManager::ActivateScene(const std::shared_ptr<Scene>& scene)
+{
+	m_current = scene;
+	m_render_objs = scene->objs;
+	m_obj_configs = scene->configs;
+}
+
+void RenderObjectManager::TrimCache()
+{
+	size_t totalUsage = 0;
+	for (const auto& scene : m_cache) {
+		totalUsage += scene->memoryUsage;
+	}
+	// evict from the least recently used end, the current scene always stays resident
+	auto it = m_cache.end();
+	while (totalUsage > m_cacheBudget && it != m_cache.begin()) {
+		--it;
+		if (*it == m_current)
+			continue;
+		std::cout << std::format("Evicted {} from the scene cache ({:.1f} MB)", (*it)->key, (*it)->memoryUsage / (1024.0 * 1024.0)) << std::endl;
+		totalUsage -= (*it)->memoryUsage;
+		it = m_cache.erase(it);
+	}
+}
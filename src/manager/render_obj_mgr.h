@@ -2,8 +2,12 @@
 #include <memory>
 
 #include <format>
+#include <list>
+#include <chrono>
+#include <future>
 #include <unordered_set>
 #include "../register/register_render_obj.h"
+#include "../threadpool/threadpool.h"
 class RenderObjectManager {
 public:
 
@@ -14,14 +18,51 @@ public:
 	std::shared_ptr<Parser::RenderObjConfigBase>& GetObjConfig(size_t idx);
 	std::vector<std::shared_ptr<Renderable::RenderObjectBase>>& GetRenderObjs();
 	static std::shared_ptr<RenderObjectManager> GetInstance();
+	// loads the scene and blocks until it is current
 	void InitRenderObjs(std::vector<std::string>& config_paths);
+	// returns at once, the scene is loaded on the worker threads and becomes current in PollScene
+	void RequestScene(const std::vector<std::string>& config_paths);
+	// call once per frame on the context thread, returns true when the current scene changed
+	bool PollScene();
+	bool IsLoading() const { return !m_pending.empty(); }
+	void SetCacheBudget(size_t bytes);
+	void ImGuiCallback();
 	void ResetRenderObjs();
 
+private:
+	struct Scene {
+		std::string key = "";
+		// the configs as parsed on a loader thread, valid until the objects are constructed
+		std::future<std::vector<std::shared_ptr<Parser::RenderObjConfigBase>>> parse{};
+		std::vector<std::shared_ptr<Parser::RenderObjConfigBase>> configs{};  // one for each object, in the same order
+		std::vector<std::shared_ptr<Renderable::RenderObjectBase>> objs{};
+		std::vector<std::future<void>> loads{};
+		size_t memoryUsage = 0;
+		std::chrono::steady_clock::time_point start{};
+	};
+
+	std::string GetSceneKey(const std::vector<std::string>& config_paths) const;
+	std::shared_ptr<Scene> FindCachedScene(const std::string& key);
+	std::shared_ptr<Scene> StartLoad(const std::vector<std::string>& config_paths);
+	// creates the objects of the parsed configs on the context thread and starts loading their data
+	void ConstructObjs(Scene& scene);
+	bool IsLoaded(const Scene& scene) const;
+	void FinishLoad(Scene& scene);
+	void ActivateScene(const std::shared_ptr<Scene>& scene);
+	void TrimCache();
+
 private:
 	static std::shared_ptr<RenderObjectManager> m_instance;
 
 	std::vector<std::shared_ptr<Parser::RenderObjConfigBase>> m_obj_configs;
 	std::unordered_map<std::string, Registry::CreateRenderObjFuncPtr> m_register_render_obj;
 	std::vector<std::shared_ptr<Renderable::RenderObjectBase>> m_render_objs;
+
+	std::unique_ptr<ThreadPool> m_loader = nullptr;
+	std::shared_ptr<Scene> m_current = nullptr;
+	std::list<std::shared_ptr<Scene>> m_cache{};  // most recently used first, holds the current scene too
+	std::list<std::shared_ptr<Scene>> m_pending{};
+	std::string m_requestedKey = "";
+	size_t m_cacheBudget = size_t(4) << 30;
 };
 
@@ -3,33 +3,11 @@
 #include <rapidjson/stringbuffer.h>
 #include <exception>
 #include <format>
+#include <filesystem>
 #include "config_parser.h"
+#include "../utils/file_dialog.h"
 
 PARSER_BEGIN
-bool GetOFNPath(TCHAR* szFile, bool isSave)
-{
-	OPENFILENAME ofn;
-	ZeroMemory(&ofn, sizeof(ofn));
-
-	ofn.lStructSize = sizeof(ofn);
-	ofn.hwndOwner = NULL;
-	ofn.lpstrFilter = TEXT("Text Files\0*.TXT\0All Files\0*.*\0");
-	ofn.lpstrFile = szFile;
-	ofn.nFilterIndex = 1;
-	ofn.nMaxFile = MAX_PATH;
-	ofn.Flags = OFN_EXPLORER | OFN_PATHMUSTEXIST | OFN_OVERWRITEPROMPT | OFN_HIDEREADONLY;
-	ofn.lpstrDefExt = TEXT("txt\0json");
-	ofn.lpstrFileTitle = NULL;
-	ofn.nMaxFileTitle = 0;
-	ofn.lpstrInitialDir = NULL;
-	if (isSave) {
-		return GetSaveFileName(&ofn);
-	}
-	else {
-		return GetOpenFileName(&ofn);
-	}
-}
-
 class FormatException : public std::exception {
 private:
 	std::string errorMessage;
@@ -40,20 +18,77 @@ public:
 	}
 };
 
-void LoadCameraConfig()
+bool SelectCameraConfigPath(std::string& path)
+{
+	return OpenFileDialog(path);
+}
+
+std::vector<CameraConfig> LoadCameraConfig(const std::string& path)
 {
-	TCHAR szFile[MAX_PATH] = { 0 };
-	if (GetOFNPath(szFile, false)) {
-		std::ifstream file;
-		file.open(szFile, std::ifstream::in);
-		std::wstring ws(szFile);
-		if (file.fail()) {
-			std::wcout << "Unable to open file: " << szFile << std::endl;
-			return;
+	std::ifstream ifs(path);
+	if (!ifs.is_open())
+		throw std::runtime_error(std::format("Error occured while opening {}", path));
+	std::stringstream buffer;
+	buffer << ifs.rdbuf();
+	ifs.close();
+	rapidjson::Document document;
+	document.Parse(buffer.str().c_str());
+	if (document.HasParseError())
+		throw std::runtime_error(std::format("Document parse error: {}", static_cast<int>(document.GetParseError())));
+	if (!document.IsArray())
+		throw FormatException("Camera document is not an array.");
+
+	auto getNumber = [](const rapidjson::Value& json, const char* key) {
+		if (!json.HasMember(key) || !json[key].IsNumber())
+			throw FormatException(std::format("The value of {} is not a number.", key));
+		return json[key].GetDouble();
+		};
+	// a json array of exactly size numbers
+	auto isNumberArray = [](const rapidjson::Value& json, rapidjson::SizeType size) {
+		if (!json.IsArray() || json.Size() != size)
+			return false;
+		for (const auto& value : json.GetArray()) {
+			if (!value.IsNumber())
+				return false;
 		}
+		return true;
+		};
+
+	std::vector<CameraConfig> cameras;
+	for (const auto& elem : document.GetArray()) {
+		if (!elem.IsObject())
+			throw FormatException("Element of camera document is not an object.");
 
-		file.close();
+		CameraConfig camera;
+		camera.id = static_cast<int>(getNumber(elem, "id"));
+		camera.width = static_cast<int>(getNumber(elem, "width"));
+		camera.height = static_cast<int>(getNumber(elem, "height"));
+		camera.fx = static_cast<float>(getNumber(elem, "fx"));
+		camera.fy = static_cast<float>(getNumber(elem, "fy"));
+		if (camera.width <= 0 || camera.height <= 0)
+			throw FormatException(std::format("Camera {} has no valid image size.", camera.id));
+		camera.imageName = elem.HasMember("img_name") && elem["img_name"].IsString() ? elem["img_name"].GetString() : std::format("{:05d}", camera.id);
+
+		if (!elem.HasMember("position") || !isNumberArray(elem["position"], 3))
+			throw FormatException(std::format("Camera {} has no valid position.", camera.id));
+		for (rapidjson::SizeType i = 0; i < 3; i++) {
+			camera.position[i] = elem["position"][i].GetFloat();
+		}
+
+		// rows of the camera to world rotation, glm is column major
+		if (!elem.HasMember("rotation") || !elem["rotation"].IsArray() || elem["rotation"].Size() != 3)
+			throw FormatException(std::format("Camera {} has no valid rotation.", camera.id));
+		for (rapidjson::SizeType row = 0; row < 3; row++) {
+			const auto& rowValue = elem["rotation"][row];
+			if (!isNumberArray(rowValue, 3))
+				throw FormatException(std::format("Camera {} has no valid rotation.", camera.id));
+			for (rapidjson::SizeType col = 0; col < 3; col++) {
+				camera.rotation[col][row] = rowValue[col].GetFloat();
+			}
+		}
+		cameras.push_back(camera);
 	}
+	return cameras;
 }
 
 
@@ -114,12 +149,8 @@ void ConfigParser::ParseSimpleConfig(const rapidjson::Value& objConfig)
 	GetJsonString(objConfig, vertexShaderKey, config.vertexShader);
 	GetJsonString(objConfig, fragmentShaderKey, config.fragmentShader);
 	GetJsonString(objConfig, projectionTypeKey, config.projection);
-	const rapidjson::Value& arr = objConfig[uniformKey];
-	CheckJsonArray(objConfig, uniformKey);
-	for (const auto& elem : arr.GetArray()) {
-		auto uniform = elem.GetString();
-		config.uniforms.insert(uniform);
-	}
+	GetOptionalJsonString(objConfig, batchVertexShaderKey, config.batchVertexShader);
+	GetOptionalJsonString(objConfig, tileDirectoryKey, config.tileDirectory);
 	m_objConfigs.emplace_back(std::make_shared<RenderObjConfigSimple>(config));
 }
 
@@ -136,16 +167,27 @@ void ConfigParser::Parse3DGSConfig(const rapidjson::Value& objConfig)
 	GetJsonString(objConfig, modelPathKey, config.modelPath);
 	GetJsonString(objConfig, fboFragmentShaderKey, config.fboFragmentShader);
 	GetJsonString(objConfig, fboVertexShaderKey, config.fboVertexShader);
-
-	const rapidjson::Value& arr = objConfig[uniformKey];
-	CheckJsonArray(objConfig, uniformKey);
-	for (const auto& elem : arr.GetArray()) {
-		auto uniform = elem.GetString();
-		config.uniforms.insert(uniform);
+	GetOptionalJsonBool(objConfig, lodKey, config.lod);
+	GetOptionalJsonFloat(objConfig, lodPixelErrorKey, config.lodPixelError);
+	if (objConfig.HasMember(qualityKey)) {
+		CheckJsonObject(objConfig, qualityKey);
+		ParseQualityConfig(objConfig[qualityKey], config.quality);
 	}
 	m_objConfigs.emplace_back(std::make_shared<RenderObjConfig3DGS>(config));
 }
 
+void ConfigParser::ParseQualityConfig(const rapidjson::Value& objConfig, QualityConfig& config)
+{
+	GetOptionalJsonBool(objConfig, qualityEnabledKey, config.enabled);
+	GetOptionalJsonFloat(objConfig, targetFrameMsKey, config.targetFrameMs);
+	GetOptionalJsonInt(objConfig, minShDegreeKey, config.minShDegree);
+	GetOptionalJsonFloat(objConfig, minSplatRatioKey, config.minSplatRatio);
+	GetOptionalJsonFloat(objConfig, minResolutionScaleKey, config.minResolutionScale);
+	GetOptionalJsonInt(objConfig, maxSortIntervalKey, config.maxSortInterval);
+	if (config.targetFrameMs <= 0.0f)
+		throw FormatException(std::format("The value of {} must be positive.", targetFrameMsKey));
+}
+
 void ConfigParser::CheckMemberExist(const rapidjson::Value& json, const char* key)
 {
 	if (!json.HasMember(key))
@@ -167,6 +209,42 @@ void ConfigParser::GetJsonString(const rapidjson::Value& json, const char* key,
 	dest = json[key].GetString();
 }
 
+void ConfigParser::GetOptionalJsonString(const rapidjson::Value& json, const char* key, std::string& dest)
+{
+	if (!json.HasMember(key))
+		return;
+	if (!json[key].IsString())
+		throw FormatException(std::format("The value of {} is not a string.", key));
+	dest = json[key].GetString();
+}
+
+void ConfigParser::GetOptionalJsonBool(const rapidjson::Value& json, const char* key, bool& dest)
+{
+	if (!json.HasMember(key))
+		return;
+	if (!json[key].IsBool())
+		throw FormatException(std::format("The value of {} is not a boolean.", key));
+	dest = json[key].GetBool();
+}
+
+void ConfigParser::GetOptionalJsonFloat(const rapidjson::Value& json, const char* key, float& dest)
+{
+	if (!json.HasMember(key))
+		return;
+	if (!json[key].IsNumber())
+		throw FormatException(std::format("The value of {} is not a number.", key));
+	dest = json[key].GetFloat();
+}
+
+void ConfigParser::GetOptionalJsonInt(const rapidjson::Value& json, const char* key, int& dest)
+{
+	if (!json.HasMember(key))
+		return;
+	if (!json[key].IsInt())
+		throw FormatException(std::format("The value of {} is not an integer.", key));
+	dest = json[key].GetInt();
+}
+
 void ConfigParser::CheckJsonArray(const rapidjson::Value& json, const char* key)
 {
 	CheckMemberExist(json, key);
@@ -4,21 +4,18 @@
 #include <fstream>
 #include <string>
 #include <vector>
-#include <windows.h>
-#include <commdlg.h>
 #include <string>
 #include <unordered_set>
 #include <memory>
 #include <rapidjson/document.h>
 #include <rapidjson/writer.h>
 #include <rapidjson/stringbuffer.h>
+#include <glm/glm.hpp>
 #include "./common.h"
 
 PARSER_BEGIN
 struct RenderObjConfigBase {
 	std::string objType;
-	std::unordered_set<std::string> uniforms;
-	std::unordered_set<std::string>& GetUniform() { return uniforms; };
 };
 
 struct RenderObjConfigSimple : public RenderObjConfigBase
@@ -27,6 +24,21 @@ struct RenderObjConfigSimple : public RenderObjConfigBase
 	std::string vertexShader = "";
 	std::string fragmentShader = "";
 	std::string projection = "perspective";
+	// optional, objects with a batch shader are drawn through the DrawBatcher when the context supports it
+	std::string batchVertexShader = "";
+	// optional, root of the z/x/y.png tile pyramid streamed by the map object
+	std::string tileDirectory = "";
+};
+
+// frame time driven quality of a 3dgs object, optional "quality" object of its config
+struct QualityConfig
+{
+	bool enabled = false;
+	float targetFrameMs = 1000.0f / 60.0f;
+	int minShDegree = 1;
+	float minSplatRatio = 0.25f;  // fraction of the splats still drawn at the lowest level
+	float minResolutionScale = 0.5f;
+	int maxSortInterval = 4;  // frames between two sorts at the lowest level
 };
 
 struct RenderObjConfig3DGS : public RenderObjConfigBase
@@ -38,6 +50,9 @@ struct RenderObjConfig3DGS : public RenderObjConfigBase
 	std::string fboVertexShader = "";
 	std::string fboFragmentShader = "";
 	std::string projection = "perspective";
+	bool lod = false;
+	float lodPixelError = 2.0f;
+	QualityConfig quality{};
 };
 
 struct RenderObjConfigAdvanced : public RenderObjConfigBase
@@ -56,16 +71,40 @@ struct RenderObjConfigAdvanced : public RenderObjConfigBase
 
 };
 
+// one view of a trained scene, as exported to cameras.json by the 3DGS training code
+struct CameraConfig
+{
+	int id = 0;
+	std::string imageName = "";
+	int width = 0;
+	int height = 0;
+	glm::vec3 position = glm::vec3(0.0f);
+	glm::mat3 rotation = glm::mat3(1.0f);  // camera to world, columns are the COLMAP camera axes (x right, y down, z forward)
+	float fx = 0.0f;
+	float fy = 0.0f;
+};
+
 static const char* configTypeKey = "configType";
 static const char* objConfigKey = "objectInfo";
 static const char* renderObjTypeKey = "type";
 static const char* vertexShaderKey = "vertexShader";
 static const char* fragmentShaderKey = "fragmentShader";
+static const char* batchVertexShaderKey = "batchVertexShader";
+static const char* tileDirectoryKey = "tileDirectory";
 static const char* fboVertexShaderKey = "fboVertexShader";
 static const char* fboFragmentShaderKey = "fboFragmentShader";
 static const char* projectionTypeKey = "projection";
 static const char* modelPathKey = "model_path";
-static const char* uniformKey = "uniform";
+// the per object "uniform" lists are deprecated and ignored, every object reads the camera from the FrameContext block
+static const char* lodKey = "lod";
+static const char* lodPixelErrorKey = "lodPixelError";
+static const char* qualityKey = "quality";
+static const char* qualityEnabledKey = "enabled";
+static const char* targetFrameMsKey = "targetFrameMs";
+static const char* minShDegreeKey = "minShDegree";
+static const char* minSplatRatioKey = "minSplatRatio";
+static const char* minResolutionScaleKey = "minResolutionScale";
+static const char* maxSortIntervalKey = "maxSortInterval";
 
 class ConfigParser {
 public:
@@ -74,8 +113,13 @@ public:
 private:
 	void ParseSimpleConfig(const rapidjson::Value& objConfig);
 	void Parse3DGSConfig(const rapidjson::Value& objConfig);
+	void ParseQualityConfig(const rapidjson::Value& objConfig, QualityConfig& config);
 	void CheckMemberExist(const rapidjson::Value& json, const char* key);
 	void GetJsonString(const rapidjson::Value& json, const char* key, std::string& dest);
+	void GetOptionalJsonString(const rapidjson::Value& json, const char* key, std::string& dest);
+	void GetOptionalJsonBool(const rapidjson::Value& json, const char* key, bool& dest);
+	void GetOptionalJsonFloat(const rapidjson::Value& json, const char* key, float& dest);
+	void GetOptionalJsonInt(const rapidjson::Value& json, const char* key, int& dest);
 	void CheckJsonObject(const rapidjson::Value& json, const char* key);
 	void CheckJsonArray(const rapidjson::Value& json, const char* key);
 
@@ -83,8 +127,8 @@ private:
 	std::vector<std::shared_ptr<RenderObjConfigBase>>& m_objConfigs;
 };
 
-bool GetOFNPath(TCHAR* szFile, bool isSave);
-void LoadCameraConfig();
+bool SelectCameraConfigPath(std::string& path);
+std::vector<CameraConfig> LoadCameraConfig(const std::string& path);
 PARSER_END
 
 
@@ -2,9 +2,9 @@
 
 REGISTER_BEGIN
 #define DECLEAR_REGISTER_OBJECT(OBJNAME)																									\
-std::shared_ptr<Renderable::RenderObjectBase> RenderObjectFactory::Create##OBJNAME##(std::shared_ptr<Parser::RenderObjConfigBase> config)	\
+std::shared_ptr<Renderable::RenderObjectBase> RenderObjectFactory::Create##OBJNAME(std::shared_ptr<Parser::RenderObjConfigBase> config)	\
 {																																			\
-	return std::make_shared<Renderable::##OBJNAME##Obj>(config);																			\
+	return std::make_shared<Renderable::OBJNAME##Obj>(config);																			\
 }
 
 DECLEAR_REGISTER_OBJECT(Axis);
@@ -5,17 +5,22 @@ AABBObj::AABBObj(std::shared_ptr<AABB> aabb) {
 	m_aabb = aabb;
 	SetUpVertices();
 	SetUpData();
-	AABBObj::AABBObj();
+	SetUpShader();
 }
 
 AABBObj::AABBObj() {
 	SetUpShader();
 }
 
-void AABBObj::SetUpVertices()
+bool AABBObj::SetUpVertices()
 {
 	auto max_corner = m_aabb->getMaxCorner();
 	auto min_corner = m_aabb->getMinCorner();
+	if (GetVAO() != 0 && m_vertices[0] == glm::vec3(max_corner.x, max_corner.y, max_corner.z) &&
+		m_vertices[6] == glm::vec3(min_corner.x, min_corner.y, min_corner.z))
+	{
+		return false;
+	}
 	m_vertices[0] = glm::vec3(max_corner.x, max_corner.y, max_corner.z);
 	m_vertices[1] = glm::vec3(max_corner.x, max_corner.y, min_corner.z);
 	m_vertices[2] = glm::vec3(min_corner.x, max_corner.y, min_corner.z);
@@ -24,21 +29,16 @@ void AABBObj::SetUpVertices()
 	m_vertices[5] = glm::vec3(max_corner.x, min_corner.y, min_corner.z);
 	m_vertices[6] = glm::vec3(min_corner.x, min_corner.y, min_corner.z);
 	m_vertices[7] = glm::vec3(min_corner.x, min_corner.y, max_corner.z);
+	return true;
 }
 
-void AABBObj::DrawObj(const std::unordered_map<std::string, std::any>& uniform)
+void AABBObj::DrawObj(const FrameContext& /*frame*/)
 {
-	SetUpVertices();
-	SetUpData();
-
-	auto projection = std::any_cast<glm::mat4>(uniform.at("projection"));
-	auto view = std::any_cast<glm::mat4>(uniform.at("view"));
-	auto model = std::any_cast<glm::mat4>(uniform.at("model"));
+	// the box is usually static, only upload it when it moved
+	if (SetUpVertices())
+		SetUpData();
 
 	m_shader->Use();
-	m_shader->SetMat4("projection", projection);
-	m_shader->SetMat4("view", view);
-	m_shader->SetMat4("model", model);
 	RenderObjectNaive::Draw();
 }
 
@@ -7,8 +7,9 @@ class AABBObj : public RenderObjectNaive<glm::vec3, uint32_t> {
 public:
 	AABBObj();
 	AABBObj(std::shared_ptr<AABB> aabb);
-	void SetUpVertices();
-	void DrawObj(const std::unordered_map<std::string, std::any>& uniform);
+	// returns true when the corners moved since the last call
+	bool SetUpVertices();
+	void DrawObj(const FrameContext& frame);
 	std::shared_ptr<AABB> GetAABB() {
 		return m_aabb;
 	}
@@ -7,19 +7,15 @@ AxisObj::AxisObj(std::shared_ptr<Parser::RenderObjConfigBase> baseConfigPtr)
 	SetUpData();
 	auto ConfigPtr = std::static_pointer_cast<Parser::RenderObjConfigSimple>(baseConfigPtr);
 	SetUpShader(ConfigPtr->vertexShader, ConfigPtr->fragmentShader);
+	SetUpBatching(*ConfigPtr);
 }
 
-void AxisObj::DrawObj(const std::unordered_map<std::string, std::any>& uniform)
+void AxisObj::DrawObj(const FrameContext& frame)
 {
-	auto projection = std::any_cast<glm::mat4>(uniform.at("perspective_projection"));
-	auto view = std::any_cast<glm::mat4>(uniform.at("view"));
-	auto model = std::any_cast<glm::mat4>(uniform.at("model"));
-
-	m_shader->Use();
-	m_shader->SetMat4("projection", projection);
-	m_shader->SetMat4("view", view);
-	m_shader->SetMat4("model", model);
-	RenderObjectNaive::Draw();
+	if (!SubmitBatched(frame)) {
+		m_shader->Use();
+		RenderObjectNaive::Draw();
+	}
 }
 
 void AxisObj::SetUpData()
@@ -6,7 +6,7 @@ class AxisObj : public RenderObjectNaive<float, uint32_t> {
 public:
 	AxisObj(std::shared_ptr<Parser::RenderObjConfigBase> baseConfigPtr);
 
-	void DrawObj(const std::unordered_map<std::string, std::any>& uniform);
+	void DrawObj(const FrameContext& frame);
 	~AxisObj() = default;
 
 private:
@@ -8,7 +8,7 @@
 //}
 //
 //
-//void BasicLightingObj::DrawObj(const std::unordered_map<std::string, std::any>& uniform)
+//void BasicLightingObj::DrawObj(const FrameContext& frame)
 //{
 //}
 //
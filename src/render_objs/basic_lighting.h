@@ -26,7 +26,7 @@
 //public:
 //	BasicLightingObj(Parser::RenderObjConfigNaive& config);
 //
-//	void DrawObj(const std::unordered_map<std::string, std::any>& uniform);
+//	void DrawObj(const FrameContext& frame);
 //	void ImGuiCallback();
 //	~BasicLightingObj() = default;
 //
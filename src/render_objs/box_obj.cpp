@@ -9,18 +9,11 @@ BoxObj::BoxObj(std::shared_ptr<Parser::RenderObjConfigBase> baseConfigPtr)
 	SetUpTexture(2);
 }
 
-void BoxObj::DrawObj(const std::unordered_map<std::string, std::any>& uniform)
+void BoxObj::DrawObj(const FrameContext& /*frame*/)
 {
 	SetUpGLStatus();
 
-	auto projection = std::any_cast<glm::mat4>(uniform.at("projection"));
-	auto view = std::any_cast<glm::mat4>(uniform.at("view"));
-	auto model = std::any_cast<glm::mat4>(uniform.at("model"));
-
 	m_shader->Use();
-	m_shader->SetMat4("projection", projection);
-	m_shader->SetMat4("view", view);
-	m_shader->SetMat4("model", model);
 	for (auto idx : m_textureIdxes) {
 		m_textures->BindTexture(idx);
 	}
@@ -29,9 +22,10 @@ void BoxObj::DrawObj(const std::unordered_map<std::string, std::any>& uniform)
 
 void BoxObj::SetUpGLStatus()
 {
-	glEnable(GL_DEPTH_TEST);
-	glEnable(GL_CULL_FACE);
-	glCullFace(GL_BACK);
+	auto glState = GLStateCache::GetInstance();
+	glState->Enable(GL_DEPTH_TEST);
+	glState->Enable(GL_CULL_FACE);
+	glState->CullFace(GL_BACK);
 }
 
 void BoxObj::SetUpTexture(int num)
@@ -6,7 +6,7 @@ RENDERABLE_BEGIN
 class BoxObj : public RenderObjectNaive<float, uint32_t> {
 public:
 	BoxObj(std::shared_ptr<Parser::RenderObjConfigBase> baseConfigPtr);
-	void DrawObj(const std::unordered_map<std::string, std::any>& uniform);
+	void DrawObj(const FrameContext& frame);
 
 private:
 	void SetUpGLStatus();
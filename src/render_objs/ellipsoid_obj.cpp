@@ -1,5 +1,6 @@
 #include <eigen3/Eigen/Dense>
 #include "ellipsoid_obj.h"
+#include "../utils/sampling.h"
 
 RENDERABLE_BEGIN
 EllipsoidObj::EllipsoidObj(std::shared_ptr<Parser::RenderObjConfigBase> baseConfigPtr)
@@ -7,6 +8,7 @@ EllipsoidObj::EllipsoidObj(std::shared_ptr<Parser::RenderObjConfigBase> baseConf
 	SetUpData();
 	auto ConfigPtr = std::static_pointer_cast<Parser::RenderObjConfigSimple>(baseConfigPtr);
 	SetUpShader(ConfigPtr->vertexShader, ConfigPtr->fragmentShader);
+	SetUpBatching(*ConfigPtr);
 }
 
 std::shared_ptr<AABB> EllipsoidObj::GetAABB()
@@ -14,36 +16,27 @@ std::shared_ptr<AABB> EllipsoidObj::GetAABB()
 	return m_aabbObj;
 }
 
-void EllipsoidObj::DrawObj(const std::unordered_map<std::string, std::any>& uniform)
+void EllipsoidObj::DrawObj(const FrameContext& frame)
 {
-	m_shader->Use();
-
-	auto projection = std::any_cast<glm::mat4>(uniform.at("projection"));
-	auto view = std::any_cast<glm::mat4>(uniform.at("view"));
-	auto model = std::any_cast<glm::mat4>(uniform.at("model"));
-
-	m_shader->Use();
-	m_shader->SetMat4("projection", projection);
-	m_shader->SetMat4("view", view);
-	m_shader->SetMat4("model", model);
-	RenderObjectNaive::Draw();
+	if (!SubmitBatched(frame)) {
+		m_shader->Use();
+		RenderObjectNaive::Draw();
+	}
 }
 
 void EllipsoidObj::ImGuiCallback()
 {
 	bool changed = false;
-	changed |= ImGui::SliderInt("number", &m_number, 0, 100000);
+	changed |= ImGui::SliderInt("number", &m_number, 0, 20000000, "%d", ImGuiSliderFlags_Logarithmic);
 	changed |= ImGui::SliderFloat3("scale", &m_scale[0], 0, 2);
 	changed |= ImGui::SliderFloat4("rotation", &m_rotation[0], -2, 2);
+	changed |= ImGui::InputInt("seed", &m_seed);
 
 	if (changed) SetUpData();
 }
 
 void EllipsoidObj::SetUpData()
 {
-	std::random_device rd;
-	std::mt19937 gen(rd());
-	std::normal_distribution<> d(0.0, 1.0);
 	m_aabbObj = std::make_shared<AABB>();
 
 	std::vector<float> M{
@@ -91,9 +84,6 @@ void EllipsoidObj::SetUpData()
 		return m_scale[i1] < m_scale[i2];
 		});
 
-	auto lltOfSigma = Sigma.llt();
-	std::vector<glm::vec3>vertices(m_number);
-
 	glm::vec3 value;
 	std::vector<glm::vec3> vector(3);
 	for (size_t i = 0; i < 3; i++) {
@@ -103,17 +93,11 @@ void EllipsoidObj::SetUpData()
 		}
 	}
 
-	Eigen::Vector3f center(0.0f, 0.0f, 0.0f);
-	for (int i = 0; i < m_number; i++) {
-		Eigen::VectorXf z(3);
-		z(0) = static_cast<float>(d(gen));
-		z(1) = static_cast<float>(d(gen));
-		z(2) = static_cast<float>(d(gen));
-		Eigen::VectorXf y = lltOfSigma.matrixL() * z + center;
-		float norm_y = y.norm();
-		glm::vec3 radius = glm::sqrt(value) / norm_y;
-		vertices[i] = glm::vec3(y[0] * radius[0], y[1] * radius[1], y[2] * radius[2]);
-	}
+	// Sigma = M^T * M, so the surface is M^T applied to the unit sphere: the rows of M are the semi axes
+	// and the points end up on the same ellipsoid the aabb below is built from
+	glm::mat3 transform(glm::vec3(M[0], M[1], M[2]), glm::vec3(M[3], M[4], M[5]), glm::vec3(M[6], M[7], M[8]));
+	std::vector<glm::vec3> vertices;
+	PointSampler::GetInstance()->SampleSurface(static_cast<uint64_t>(m_seed), transform, static_cast<size_t>(m_number), vertices);
 
 	m_aabbObj->reset();
 	glm::vec3 center1(0.0f, 0.0f, 0.0f);
@@ -132,7 +116,7 @@ void EllipsoidObj::SetUpData()
 		{"aPos", 0, 3, GL_FLOAT, GL_FALSE, 1, 0},
 	};
 
-	SetMesh(&vertices, &vertexInfo);
+	SetMesh(std::move(vertices), vertexInfo);
 	SetPrimitive(GL_POINTS);
 }
 
@@ -8,7 +8,7 @@ public:
 	EllipsoidObj(std::shared_ptr<Parser::RenderObjConfigBase> baseConfigPtr);
 	std::shared_ptr<AABB> GetAABB();
 
-	void DrawObj(const std::unordered_map<std::string, std::any>& uniform);
+	void DrawObj(const FrameContext& frame);
 	void ImGuiCallback();
 	~EllipsoidObj() = default;
 
@@ -17,6 +17,7 @@ private:
 
 private:
 	int m_number = 10000;
+	int m_seed = 0;
 	glm::vec3 m_scale{ 0.3f, 0.7f, 1.0f };
 	glm::vec4 m_rotation{ 0.0f, 0.0f, 0.0f, 0.0f };
 	std::shared_ptr<AABB> m_aabbObj = nullptr;
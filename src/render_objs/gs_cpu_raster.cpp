@@ -0,0 +1,449 @@
+#include "./gs_cpu_raster.h"
+
+#include <atomic>
+#include <future>
+#include <chrono>
+#include <cmath>
+#include <bit>
+#include <cassert>
+#include "stb/stb_image_write.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define GS_CPU_RASTER_SSE2
+#endif
+
+RENDERABLE_BEGIN
+namespace {
+constexpr float SH_C1 = 0.4886025119029199f;
+constexpr float SH_C2[] = { 1.0925484305920792f, -1.0925484305920792f, 0.31539156525252005f, -1.0925484305920792f, 0.5462742152960396f };
+constexpr float SH_C3[] = { -0.5900435899266435f, 2.890611442640554f, -0.4570457994644658f, 0.3731763325901154f,
+	-0.4570457994644658f, 1.445305721320277f, -0.5900435899266435f };
+
+// cutoffs of gs_tile_raster_comp.glsl
+constexpr float MIN_ALPHA = 1.0f / 256.0f;
+constexpr float MAX_ALPHA = 0.99f;
+constexpr float MIN_TRANSMITTANCE = 0.0001f;
+
+// four lanes of floats, comparisons return all bits set in the lanes where they hold
+#ifdef GS_CPU_RASTER_SSE2
+struct Float4 {
+	__m128 v;
+	Float4() = default;
+	Float4(__m128 value) : v(value) {}
+	explicit Float4(float value) : v(_mm_set1_ps(value)) {}
+	static Float4 Load(const float* p) { return _mm_load_ps(p); }
+	void Store(float* p) const { _mm_store_ps(p, v); }
+	friend Float4 operator+(Float4 a, Float4 b) { return _mm_add_ps(a.v, b.v); }
+	friend Float4 operator-(Float4 a, Float4 b) { return _mm_sub_ps(a.v, b.v); }
+	friend Float4 operator*(Float4 a, Float4 b) { return _mm_mul_ps(a.v, b.v); }
+	friend Float4 Min(Float4 a, Float4 b) { return _mm_min_ps(a.v, b.v); }
+	friend Float4 Max(Float4 a, Float4 b) { return _mm_max_ps(a.v, b.v); }
+	friend Float4 Greater(Float4 a, Float4 b) { return _mm_cmpgt_ps(a.v, b.v); }
+	friend Float4 Less(Float4 a, Float4 b) { return _mm_cmplt_ps(a.v, b.v); }
+	friend Float4 And(Float4 a, Float4 b) { return _mm_and_ps(a.v, b.v); }
+	friend Float4 AndNot(Float4 mask, Float4 b) { return _mm_andnot_ps(mask.v, b.v); }  // ~mask & b
+	friend Float4 Or(Float4 a, Float4 b) { return _mm_or_ps(a.v, b.v); }
+	friend Float4 Select(Float4 mask, Float4 a, Float4 b) { return Or(And(mask, a), AndNot(mask, b)); }
+	friend int MoveMask(Float4 mask) { return _mm_movemask_ps(mask.v); }
+};
+
+// exp for x <= 0, cephes polynomial on the fraction scaled by 2^n built in the exponent bits
+Float4 Exp(Float4 x)
+{
+	x = Max(x, Float4(-87.0f));
+	Float4 fx = x * Float4(1.44269504088896341f) + Float4(0.5f);
+	Float4 n = _mm_cvtepi32_ps(_mm_cvttps_epi32(fx.v));
+	n = n - And(Greater(n, fx), Float4(1.0f));  // floor, truncation rounds the negative values up
+	x = x - n * Float4(0.693359375f) - n * Float4(-2.12194440e-4f);
+	Float4 y(1.9875691500e-4f);
+	y = y * x + Float4(1.3981999507e-3f);
+	y = y * x + Float4(8.3334519073e-3f);
+	y = y * x + Float4(4.1665795894e-2f);
+	y = y * x + Float4(1.6666665459e-1f);
+	y = y * x + Float4(5.0000001201e-1f);
+	y = y * x * x + x + Float4(1.0f);
+	__m128i exponent = _mm_slli_epi32(_mm_add_epi32(_mm_cvttps_epi32(n.v), _mm_set1_epi32(127)), 23);
+	return y * Float4(_mm_castsi128_ps(exponent));
+}
+#else
+struct Float4 {
+	float v[4];
+	Float4() = default;
+	explicit Float4(float value) : v{ value, value, value, value } {}
+	static Float4 Load(const float* p) { return Apply([p](int i) { return p[i]; }); }
+	void Store(float* p) const { std::copy_n(v, 4, p); }
+	template <typename F> static Float4 Apply(F func)
+	{
+		Float4 result;
+		for (int i = 0; i < 4; i++)
+			result.v[i] = func(i);
+		return result;
+	}
+	static float Bits(uint32_t bits) { return std::bit_cast<float>(bits); }
+	static uint32_t Bits(float value) { return std::bit_cast<uint32_t>(value); }
+	friend Float4 operator+(Float4 a, Float4 b) { return Apply([&](int i) { return a.v[i] + b.v[i]; }); }
+	friend Float4 operator-(Float4 a, Float4 b) { return Apply([&](int i) { return a.v[i] - b.v[i]; }); }
+	friend Float4 operator*(Float4 a, Float4 b) { return Apply([&](int i) { return a.v[i] * b.v[i]; }); }
+	friend Float4 Min(Float4 a, Float4 b) { return Apply([&](int i) { return (std::min)(a.v[i], b.v[i]); }); }
+	friend Float4 Max(Float4 a, Float4 b) { return Apply([&](int i) { return (std::max)(a.v[i], b.v[i]); }); }
+	friend Float4 Greater(Float4 a, Float4 b) { return Apply([&](int i) { return Bits(a.v[i] > b.v[i] ? ~0u : 0u); }); }
+	friend Float4 Less(Float4 a, Float4 b) { return Apply([&](int i) { return Bits(a.v[i] < b.v[i] ? ~0u : 0u); }); }
+	friend Float4 And(Float4 a, Float4 b) { return Apply([&](int i) { return Bits(Bits(a.v[i]) & Bits(b.v[i])); }); }
+	friend Float4 AndNot(Float4 mask, Float4 b) { return Apply([&](int i) { return Bits(~Bits(mask.v[i]) & Bits(b.v[i])); }); }
+	friend Float4 Or(Float4 a, Float4 b) { return Apply([&](int i) { return Bits(Bits(a.v[i]) | Bits(b.v[i])); }); }
+	friend Float4 Select(Float4 mask, Float4 a, Float4 b) { return Or(And(mask, a), AndNot(mask, b)); }
+	friend int MoveMask(Float4 mask)
+	{
+		int bits = 0;
+		for (int i = 0; i < 4; i++)
+			bits |= static_cast<int>(Bits(mask.v[i]) >> 31) << i;
+		return bits;
+	}
+};
+
+Float4 Exp(Float4 x)
+{
+	return Float4::Apply([&](int i) { return std::exp(x.v[i]); });
+}
+#endif
+
+glm::vec3 EvaluateSH(const glm::vec3* sh, int shDegree, glm::vec3 dir)
+{
+	glm::vec3 result = sh[0];
+	float x = dir.x, y = dir.y, z = dir.z;
+	if (shDegree > 0) {
+		result += -SH_C1 * y * sh[1] + SH_C1 * z * sh[2] - SH_C1 * x * sh[3];
+	}
+	float xx = x * x, yy = y * y, zz = z * z;
+	float xy = x * y, yz = y * z, xz = x * z;
+	if (shDegree > 1) {
+		result += SH_C2[0] * xy * sh[4] +
+			SH_C2[1] * yz * sh[5] +
+			SH_C2[2] * (2.0f * zz - xx - yy) * sh[6] +
+			SH_C2[3] * xz * sh[7] +
+			SH_C2[4] * (xx - yy) * sh[8];
+	}
+	if (shDegree > 2) {
+		result += SH_C3[0] * y * (3.0f * xx - yy) * sh[9] +
+			SH_C3[1] * xy * z * sh[10] +
+			SH_C3[2] * y * (4.0f * zz - xx - yy) * sh[11] +
+			SH_C3[3] * z * (2.0f * zz - 3.0f * xx - 3.0f * yy) * sh[12] +
+			SH_C3[4] * x * (4.0f * zz - xx - yy) * sh[13] +
+			SH_C3[5] * z * (xx - yy) * sh[14] +
+			SH_C3[6] * x * (xx - 3.0f * yy) * sh[15];
+	}
+	return glm::clamp(result + 0.5f, glm::vec3(0.0f), glm::vec3(1.0f));
+}
+}
+
+std::vector<uint8_t> GSCpuRasterizer::Image::ToRGBA8() const
+{
+	std::vector<uint8_t> result(static_cast<size_t>(width) * height * 4);
+	for (int y = 0; y < height; y++) {
+		const glm::vec4* row = &pixels[static_cast<size_t>(height - 1 - y) * width];
+		uint8_t* target = &result[static_cast<size_t>(y) * width * 4];
+		for (int x = 0; x < width; x++) {
+			glm::vec4 pixel = row[x];
+			glm::vec3 color = pixel.a > 0.0f ? glm::vec3(pixel) / pixel.a : glm::vec3(0.0f);
+			glm::vec4 straight = glm::clamp(glm::vec4(color, pixel.a), 0.0f, 1.0f) * 255.0f + 0.5f;
+			for (int c = 0; c < 4; c++)
+				target[x * 4 + c] = static_cast<uint8_t>(straight[c]);
+		}
+	}
+	return result;
+}
+
+bool GSCpuRasterizer::Image::WritePng(const std::string& path) const
+{
+	std::vector<uint8_t> rgba = ToRGBA8();
+	return stbi_write_png(path.c_str(), width, height, 4, rgba.data(), width * 4) != 0;
+}
+
+float GSCpuRasterizer::Image::MaxDifference(const Image& a, const Image& b)
+{
+	assert(a.width == b.width && a.height == b.height);
+	float difference = 0.0f;
+	for (size_t i = 0; i < a.pixels.size(); i++) {
+		glm::vec4 delta = glm::abs(a.pixels[i] - b.pixels[i]);
+		difference = (std::max)(difference, (std::max)((std::max)(delta.x, delta.y), (std::max)(delta.z, delta.w)));
+	}
+	return difference;
+}
+
+float GSCpuRasterizer::Image::MeanDifference(const Image& a, const Image& b)
+{
+	assert(a.width == b.width && a.height == b.height);
+	double difference = 0.0;
+	for (size_t i = 0; i < a.pixels.size(); i++) {
+		glm::vec4 delta = glm::abs(a.pixels[i] - b.pixels[i]);
+		difference += delta.x + delta.y + delta.z + delta.w;
+	}
+	return a.pixels.empty() ? 0.0f : static_cast<float>(difference / (4.0 * a.pixels.size()));
+}
+
+GSCpuRasterizer::Image GSCpuRasterizer::Image::Resample(int newWidth, int newHeight) const
+{
+	Image image{ newWidth, newHeight };
+	image.pixels.resize(static_cast<size_t>(newWidth) * newHeight);
+	glm::vec2 scale = glm::vec2(width, height) / glm::vec2(newWidth, newHeight);
+	auto at = [&](int x, int y) { return pixels[static_cast<size_t>(std::clamp(y, 0, height - 1)) * width + std::clamp(x, 0, width - 1)]; };
+	for (int y = 0; y < newHeight; y++) {
+		for (int x = 0; x < newWidth; x++) {
+			glm::vec2 position = (glm::vec2(x, y) + 0.5f) * scale - 0.5f;
+			glm::ivec2 base = glm::ivec2(glm::floor(position));
+			glm::vec2 t = position - glm::vec2(base);
+			glm::vec4 bottom = glm::mix(at(base.x, base.y), at(base.x + 1, base.y), t.x);
+			glm::vec4 top = glm::mix(at(base.x, base.y + 1), at(base.x + 1, base.y + 1), t.x);
+			image.pixels[static_cast<size_t>(y) * newWidth + x] = glm::mix(bottom, top, t.y);
+		}
+	}
+	return image;
+}
+
+GSCpuRasterizer::GSCpuRasterizer(size_t threadCount) : m_pool(threadCount)
+{
+}
+
+void GSCpuRasterizer::Render(const std::vector<Splat>& splats, int shDegree, const FrameContext& frame, glm::ivec2 renderSize, Image& image)
+{
+	auto start = std::chrono::steady_clock::now();
+	m_renderSize = glm::vec2(renderSize);
+	m_sampleScale = frame.viewport / m_renderSize;
+	m_tileGrid = (renderSize + TILE_SIZE - 1) / TILE_SIZE;
+	const uint32_t TILE_COUNT = static_cast<uint32_t>(m_tileGrid.x * m_tileGrid.y);
+	const size_t CHUNK_COUNT = m_pool.GetThreadCount();
+	const size_t CHUNK_SIZE = (splats.size() + CHUNK_COUNT - 1) / CHUNK_COUNT;
+
+	// project the splats and count the tiles they overlap, every chunk counts into its own row
+	m_projected.resize(splats.size());
+	std::vector<uint32_t> chunkCounts(CHUNK_COUNT * TILE_COUNT, 0);
+	std::vector<std::future<void>> tasks;
+	for (size_t chunk = 0; chunk < CHUNK_COUNT; chunk++) {
+		tasks.push_back(m_pool.Enqueue([&, chunk]() {
+			uint32_t* counts = &chunkCounts[chunk * TILE_COUNT];
+			size_t end = (std::min)(splats.size(), (chunk + 1) * CHUNK_SIZE);
+			for (size_t i = chunk * CHUNK_SIZE; i < end; i++) {
+				ProjectedSplat& projected = m_projected[i];
+				if (!ProjectSplat(splats[i], shDegree, frame, projected) || projected.depth <= 0.0f) {
+					projected.depth = 0.0f;
+					continue;
+				}
+				ComputeTileRect(projected);
+				const glm::ivec4& rect = projected.tileRect;
+				for (int y = rect.y; y < rect.w; y++)
+					for (int x = rect.x; x < rect.z; x++)
+						counts[y * m_tileGrid.x + x]++;
+			}
+			}));
+	}
+	for (auto& task : tasks)
+		task.get();
+	tasks.clear();
+
+	// turn the counts into the write offset of every chunk within every tile
+	m_tileOffsets.resize(TILE_COUNT + 1);
+	uint32_t offset = 0;
+	for (uint32_t tile = 0; tile < TILE_COUNT; tile++) {
+		m_tileOffsets[tile] = offset;
+		for (size_t chunk = 0; chunk < CHUNK_COUNT; chunk++) {
+			uint32_t count = chunkCounts[chunk * TILE_COUNT + tile];
+			chunkCounts[chunk * TILE_COUNT + tile] = offset;
+			offset += count;
+		}
+	}
+	m_tileOffsets[TILE_COUNT] = offset;
+	m_tileSplats.resize(offset);
+
+	for (size_t chunk = 0; chunk < CHUNK_COUNT; chunk++) {
+		tasks.push_back(m_pool.Enqueue([&, chunk]() {
+			uint32_t* offsets = &chunkCounts[chunk * TILE_COUNT];
+			size_t end = (std::min)(splats.size(), (chunk + 1) * CHUNK_SIZE);
+			for (size_t i = chunk * CHUNK_SIZE; i < end; i++) {
+				const ProjectedSplat& projected = m_projected[i];
+				if (projected.depth <= 0.0f)
+					continue;
+				const glm::ivec4& rect = projected.tileRect;
+				for (int y = rect.y; y < rect.w; y++)
+					for (int x = rect.x; x < rect.z; x++)
+						m_tileSplats[offsets[y * m_tileGrid.x + x]++] = static_cast<uint32_t>(i);
+			}
+			}));
+	}
+	for (auto& task : tasks)
+		task.get();
+	tasks.clear();
+
+	// tiles are handed out one at a time, their cost varies too much for fixed ranges
+	image.width = renderSize.x;
+	image.height = renderSize.y;
+	image.pixels.assign(static_cast<size_t>(renderSize.x) * renderSize.y, glm::vec4(0.0f));
+	std::atomic<uint32_t> nextTile{ 0 };
+	for (size_t thread = 0; thread < m_pool.GetThreadCount(); thread++) {
+		tasks.push_back(m_pool.Enqueue([&]() {
+			for (uint32_t tile = nextTile++; tile < TILE_COUNT; tile = nextTile++)
+				RasterizeTile(tile, image);
+			}));
+	}
+	for (auto& task : tasks)
+		task.get();
+
+	m_lastRenderMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+bool GSCpuRasterizer::ProjectSplat(const Splat& splat, int shDegree, const FrameContext& frame, ProjectedSplat& projected)
+{
+	glm::vec4 cam = frame.view * frame.model * glm::vec4(splat.position, 1.0f);
+	glm::vec4 pos2d = frame.projection * cam;
+	glm::vec3 center = glm::vec3(pos2d) / pos2d.w;
+
+	float limx = 1.3f * frame.tanFov.x;
+	float limy = 1.3f * frame.tanFov.y;
+	float txtz = cam.x / cam.z;
+	float tytz = cam.y / cam.z;
+	cam.x = (std::min)(limx, (std::max)(-limx, txtz)) * cam.z;
+	cam.y = (std::min)(limy, (std::max)(-limy, tytz)) * cam.z;
+
+	// computeCov2D
+	float tzSq = cam.z * cam.z;
+	float jsx = -(frame.projection[0][0] * frame.viewport.x) / (2.0f * cam.z);
+	float jsy = -(frame.projection[1][1] * frame.viewport.y) / (2.0f * cam.z);
+	float jtx = (frame.projection[0][0] * cam.x * frame.viewport.x) / (2.0f * tzSq);
+	float jty = (frame.projection[1][1] * cam.y * frame.viewport.y) / (2.0f * tzSq);
+	float jtz = ((frame.nearFar.y - frame.nearFar.x) * frame.projection[3][2]) / (2.0f * tzSq);
+	glm::mat3 J = glm::mat3(glm::vec3(jsx, 0.0f, jtx), glm::vec3(0.0f, jsy, jty), glm::vec3(0.0f, 0.0f, jtz));
+	const float* c = splat.covariance;
+	glm::mat3 Vrk = glm::mat3(c[0], c[1], c[2], c[1], c[3], c[4], c[2], c[4], c[5]);
+	glm::mat3 T = glm::transpose(glm::mat3(frame.view)) * J;
+	glm::mat2 cov2d = glm::mat2(glm::transpose(T) * Vrk * T);
+	cov2d[0][0] += 0.3f;
+	cov2d[1][1] += 0.3f;
+
+	float det = cov2d[0][0] * cov2d[1][1] - cov2d[0][1] * cov2d[1][0];
+	float mid = (cov2d[0][0] + cov2d[1][1]) * 0.5f;
+	float term = std::sqrt((std::max)(0.1f, mid * mid - det));
+	float lambda1 = mid + term;
+	float lambda2 = mid - term;
+	if (lambda2 < 0.0f || lambda1 < 0.0f)
+		return false;
+	if (det == 0.0f || cov2d[0][0] < 0.0f || cov2d[1][1] < 0.0f)
+		return false;
+	// opacity aware extent, in standard deviations
+	float fade = glm::clamp(pos2d.z / pos2d.w + 1.0f, 0.0f, 1.0f);
+	float opacity = fade * splat.opacity;
+	if (opacity <= MIN_ALPHA)
+		return false;
+	float extent = (std::min)(3.0f, std::sqrt(2.0f * std::log(opacity / MIN_ALPHA)));
+	if (extent * std::sqrt(lambda1) < 0.5f)
+		return false;
+	glm::vec2 eigenVector0 = glm::normalize(glm::vec2(cov2d[0][1], lambda1 - cov2d[0][0]));
+	glm::vec2 eigenVector1 = glm::vec2(eigenVector0.y, -eigenVector0.x);
+	const float MAX_SPLAT_SIZE = 1024.0f;
+	glm::vec2 majorAxis = (std::min)(extent * std::sqrt(lambda1), MAX_SPLAT_SIZE) * eigenVector0;
+	glm::vec2 minorAxis = (std::min)(extent * std::sqrt(lambda2), MAX_SPLAT_SIZE) * eigenVector1;
+
+	glm::vec3 dir = glm::normalize(splat.position - glm::vec3(frame.camPos));
+	glm::vec3 color = EvaluateSH(splat.sh, shDegree, dir);
+
+	projected.center = 0.5f * (frame.viewport + glm::vec2(center) * frame.viewport);
+	projected.conic = glm::vec3(cov2d[1][1], -cov2d[0][1], cov2d[0][0]) / det;
+	projected.color = glm::vec4(fade * color, opacity);
+	projected.depth = pos2d.w;
+	projected.extent = glm::sqrt(majorAxis * majorAxis + minorAxis * minorAxis);
+	return true;
+}
+
+void GSCpuRasterizer::ComputeTileRect(ProjectedSplat& projected) const
+{
+	// getTileRect of gs_tile_common.glsl
+	glm::vec2 center = projected.center / m_sampleScale;
+	glm::vec2 extent = projected.extent / m_sampleScale;
+	glm::vec2 grid = glm::vec2(m_tileGrid);
+	glm::vec2 rectMin = glm::clamp(glm::floor((center - extent) / float(TILE_SIZE)), glm::vec2(0.0f), grid);
+	glm::vec2 rectMax = glm::clamp(glm::ceil((center + extent) / float(TILE_SIZE)), glm::vec2(0.0f), grid);
+	projected.tileRect = glm::ivec4(rectMin, rectMax);
+}
+
+void GSCpuRasterizer::RasterizeTile(uint32_t tile, Image& image)
+{
+	uint32_t first = m_tileOffsets[tile], last = m_tileOffsets[tile + 1];
+	int tileX = static_cast<int>(tile % m_tileGrid.x) * TILE_SIZE;
+	int tileY = static_cast<int>(tile / m_tileGrid.x) * TILE_SIZE;
+	int width = (std::min)(TILE_SIZE, image.width - tileX);
+	int height = (std::min)(TILE_SIZE, image.height - tileY);
+	if (first == last)
+		return;
+
+	// front to back, the record order breaks ties like the stable radix sort of the tile backend
+	std::sort(m_tileSplats.begin() + first, m_tileSplats.begin() + last, [this](uint32_t a, uint32_t b) {
+		float depthA = m_projected[a].depth, depthB = m_projected[b].depth;
+		return depthA < depthB || (depthA == depthB && a < b);
+		});
+
+	// one row of the tile is four groups of four lanes, lanes outside the image start out done
+	constexpr int GROUPS_PER_ROW = TILE_SIZE / 4;
+	alignas(16) float red[TILE_SIZE * TILE_SIZE]{}, green[TILE_SIZE * TILE_SIZE]{}, blue[TILE_SIZE * TILE_SIZE]{};
+	alignas(16) float transmittance[TILE_SIZE * TILE_SIZE];
+	alignas(16) float done[TILE_SIZE * TILE_SIZE];
+	alignas(16) float sampleX[TILE_SIZE];
+	int activeGroups = 0;
+	std::fill_n(transmittance, TILE_SIZE * TILE_SIZE, 1.0f);
+	for (int x = 0; x < TILE_SIZE; x++)
+		sampleX[x] = (static_cast<float>(tileX + x) + 0.5f) * m_sampleScale.x;
+	for (int y = 0; y < TILE_SIZE; y++) {
+		for (int x = 0; x < TILE_SIZE; x++)
+			done[y * TILE_SIZE + x] = std::bit_cast<float>(x < width && y < height ? 0u : ~0u);
+		for (int group = 0; group < GROUPS_PER_ROW; group++)
+			activeGroups += MoveMask(Float4::Load(&done[y * TILE_SIZE + group * 4])) != 0xf;
+	}
+
+	const Float4 MIN_ALPHA4(MIN_ALPHA), MAX_ALPHA4(MAX_ALPHA), MIN_TRANSMITTANCE4(MIN_TRANSMITTANCE);
+	for (uint32_t i = first; i < last && activeGroups > 0; i++) {
+		// every pixel of the tile is evaluated, the falloff is not cut at the box around the ellipse either on the GPU
+		const ProjectedSplat& splat = m_projected[m_tileSplats[i]];
+		const Float4 conicX(splat.conic.x), conicY(splat.conic.y), conicZ(splat.conic.z);
+		const Float4 opacity(splat.color.a), colorR(splat.color.r), colorG(splat.color.g), colorB(splat.color.b);
+		const Float4 centerX(splat.center.x);
+		for (int y = 0; y < height; y++) {
+			float dy = splat.center.y - (static_cast<float>(tileY + y) + 0.5f) * m_sampleScale.y;
+			const Float4 dy4(dy), dyTerm(splat.conic.z * dy * dy);
+			for (int group = 0; group < GROUPS_PER_ROW; group++) {
+				int index = y * TILE_SIZE + group * 4;
+				Float4 laneDone = Float4::Load(&done[index]);
+				if (MoveMask(laneDone) == 0xf)
+					continue;
+				Float4 dx = centerX - Float4::Load(&sampleX[group * 4]);
+				Float4 power = Float4(-0.5f) * (conicX * dx * dx + Float4(2.0f) * conicY * dx * dy4 + dyTerm);
+				Float4 alpha = Min(MAX_ALPHA4, opacity * Exp(power));
+				Float4 blend = AndNot(laneDone, Greater(alpha, MIN_ALPHA4));
+				if (MoveMask(blend) == 0)
+					continue;
+
+				Float4 t = Float4::Load(&transmittance[index]);
+				Float4 nextT = t * (Float4(1.0f) - alpha);
+				// a lane that would drop below the threshold stops without blending, like the compute shader
+				Float4 stop = And(blend, Less(nextT, MIN_TRANSMITTANCE4));
+				blend = AndNot(stop, blend);
+				Float4 weight = And(blend, alpha * t);
+				(Float4::Load(&red[index]) + colorR * weight).Store(&red[index]);
+				(Float4::Load(&green[index]) + colorG * weight).Store(&green[index]);
+				(Float4::Load(&blue[index]) + colorB * weight).Store(&blue[index]);
+				Select(blend, nextT, t).Store(&transmittance[index]);
+				if (MoveMask(stop) != 0) {
+					laneDone = Or(laneDone, stop);
+					laneDone.Store(&done[index]);
+					activeGroups -= MoveMask(laneDone) == 0xf;
+				}
+			}
+		}
+	}
+
+	for (int y = 0; y < height; y++) {
+		glm::vec4* row = &image.pixels[static_cast<size_t>(tileY + y) * image.width + tileX];
+		for (int x = 0; x < width; x++) {
+			int index = y * TILE_SIZE + x;
+			row[x] = glm::vec4(red[index], green[index], blue[index], 1.0f - transmittance[index]);
+		}
+	}
+}
+RENDERABLE_END
@@ -0,0 +1,83 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+#include <string>
+#include <thread>
+#include <algorithm>
+#include "common.h"
+#include "../draw/frame_context.h"
+#include "../threadpool/threadpool.h"
+
+RENDERABLE_BEGIN
+// Software rasterizer for gaussian splats, a reference renderer that needs no GL context.
+// It follows the tile compute backend (GSTileRasterizer) step by step so the two can be compared pixel by
+// pixel: splats are projected like gs_ply_common.glsl, binned into 16 x 16 tiles, sorted by view depth per
+// tile and blended front to back with the same alpha cutoffs and early termination. Projection and binning
+// are split over the splats, the tiles over the threads of a thread pool, and the gaussian falloff is
+// evaluated four pixels at a time with SSE2 when the target has it.
+class GSCpuRasterizer
+{
+public:
+	// one splat as it is stored in the splat texture of GSPlyObj
+	struct Splat {
+		glm::vec3 position{ 0.0f };
+		float opacity = 0.0f;
+		float covariance[6]{};  // xx, xy, xz, yy, yz, zz
+		glm::vec3 sh[16]{};  // sh[0] is the base colour already scaled by SH_C0, the bands are interleaved rgb
+	};
+
+	// premultiplied colour and coverage, rows from the bottom like glReadPixels and the splat framebuffer
+	struct Image {
+		int width = 0;
+		int height = 0;
+		std::vector<glm::vec4> pixels{};
+
+		// straight alpha, top row first
+		std::vector<uint8_t> ToRGBA8() const;
+		bool WritePng(const std::string& path) const;
+		// largest absolute difference of any channel, the images have to be of the same size
+		static float MaxDifference(const Image& a, const Image& b);
+		// average absolute difference over all channels, the images have to be of the same size
+		static float MeanDifference(const Image& a, const Image& b);
+		// bilinear resampling, every pixel is sampled at the position of its centre in this image
+		Image Resample(int newWidth, int newHeight) const;
+	};
+
+	explicit GSCpuRasterizer(size_t threadCount = (std::max)(std::thread::hardware_concurrency(), 1u));
+	GSCpuRasterizer(const GSCpuRasterizer&) = delete;
+	GSCpuRasterizer& operator=(const GSCpuRasterizer&) = delete;
+
+	// renders the splats with shDegree spherical harmonics bands into renderSize pixels, the splats are
+	// projected for the viewport of frame and sampled at the render resolution like the tile backend
+	void Render(const std::vector<Splat>& splats, int shDegree, const FrameContext& frame, glm::ivec2 renderSize, Image& image);
+	float GetLastRenderMs() const { return m_lastRenderMs; }
+	size_t GetLastDuplicateCount() const { return m_tileSplats.size(); }
+
+private:
+	struct ProjectedSplat {
+		glm::vec2 center{ 0.0f };  // screen pixels, lower left origin
+		glm::vec2 extent{ 0.0f };  // half size of the box around the ellipse of the quad, screen pixels
+		glm::vec3 conic{ 0.0f };  // inverse 2D covariance xx, xy, yy
+		glm::vec4 color{ 0.0f };
+		float depth = 0.0f;  // clip w, 0 when the splat is not drawn
+		glm::ivec4 tileRect{ 0 };  // xy inclusive, zw exclusive
+	};
+
+	// mirrors projectSplat of gs_ply_common.glsl, returns false when the splat cannot be drawn
+	static bool ProjectSplat(const Splat& splat, int shDegree, const FrameContext& frame, ProjectedSplat& projected);
+	void ComputeTileRect(ProjectedSplat& projected) const;
+	void RasterizeTile(uint32_t tile, Image& image);
+
+private:
+	static constexpr int TILE_SIZE = 16;
+
+	ThreadPool m_pool;
+	std::vector<ProjectedSplat> m_projected{};
+	std::vector<uint32_t> m_tileOffsets{};  // first entry of every tile in m_tileSplats, one extra for the end
+	std::vector<uint32_t> m_tileSplats{};
+	glm::ivec2 m_tileGrid{ 0 };
+	glm::vec2 m_renderSize{ 0.0f };
+	glm::vec2 m_sampleScale{ 1.0f };  // screen pixels per render pixel
+	float m_lastRenderMs = 0.0f;
+};
+RENDERABLE_END
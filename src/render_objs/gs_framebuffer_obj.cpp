@@ -1,17 +1,24 @@
 #include "./gs_framebuffer_obj.h"
+#include "../utils/profiler.h"
+#include <algorithm>
 
 
 RENDERABLE_BEGIN
 void GSFrameBufferObj::UpdateFBO()
 {
-	auto instance = Camera::GetInstance();
-	int screen_width = instance->GetScreenWidth();
-	int screen_height = instance->GetScreenHeight();
-	if (screen_width != m_fboSize.x || screen_height != m_fboSize.y)
+	if (GetScreenSize() != m_fboSize)
 	{
-		SetFBOSize({ screen_width, screen_height });
 		SetUpFBOColorTex();
 	}
+	// changing the scale only moves the viewport, the texture keeps its size
+	glm::vec2 size = glm::vec2(m_fboSize) * std::clamp(m_resolutionScale, 0.1f, 1.0f);
+	m_renderSize = glm::clamp(glm::ivec2(glm::round(size)), glm::ivec2(1), m_fboSize);
+}
+
+glm::ivec2 GSFrameBufferObj::GetScreenSize() const
+{
+	auto instance = Camera::GetInstance();
+	return (glm::max)(glm::ivec2(instance->GetScreenWidth(), instance->GetScreenHeight()), glm::ivec2(1));
 }
 
 GSFrameBufferObj::GSFrameBufferObj(const std::string& vertexShader, const std::string& fragmentShader)
@@ -23,30 +30,53 @@ GSFrameBufferObj::GSFrameBufferObj(const std::string& vertexShader, const std::s
 	SetUpFBOColorTex();
 }
 
-void GSFrameBufferObj::DrawObj(const std::unordered_map<std::string, std::any>& uniform)
+void GSFrameBufferObj::DrawObj(const FrameContext& /*frame*/)
 {
-	m_fbo->Unbind();
-	UpdateFBO();
+	PROFILE_SCOPE("FBO Composite");
+	BindTarget();
 	SetUpGLStatus();
 	m_shader->Use();
 	m_textures->BindTexture(m_textureIdx);
 	m_shader->SetVec4("color", glm::vec4(1.0f));
 	m_shader->SetInt("colorTexture", m_textureIdx);
+	m_shader->SetVec2("uvScale", glm::vec2(m_renderSize) / glm::vec2(m_fboSize));
+	// at full size there is nothing to reconstruct, sharpening would only alter the image
+	m_shader->SetInt("upscaleFilter", m_renderSize == m_fboSize ? BILINEAR : m_upscaleFilter);
+	m_shader->SetFloat("sharpness", m_sharpness);
 	RenderObjectNaive::Draw();
 }
 
+GLenum GSFrameBufferObj::GetColorFormat() const
+{
+	switch (m_precision) {
+	case PRECISION::FP16: return GL_RGBA16F;
+	case PRECISION::FP32: return GL_RGBA32F;
+	default: return GL_RGBA8;
+	}
+}
+
 void GSFrameBufferObj::SetUpGLStatus()
 {
-	glDisable(GL_DEPTH_TEST);
+	GLStateCache::GetInstance()->Disable(GL_DEPTH_TEST);
 }
 
 void GSFrameBufferObj::PrepareDraw()
 {
+	glGetIntegerv(GL_FRAMEBUFFER_BINDING, &m_targetFramebuffer);
+	glGetIntegerv(GL_VIEWPORT, m_targetViewport);
+	UpdateFBO();
 	m_fbo->Bind();
+	glViewport(0, 0, m_renderSize.x, m_renderSize.y);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 	glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
 }
 
+void GSFrameBufferObj::BindTarget()
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, m_targetFramebuffer);
+	glViewport(m_targetViewport[0], m_targetViewport[1], m_targetViewport[2], m_targetViewport[3]);
+}
+
 void GSFrameBufferObj::ImGuiCallback()
 {
 	static int selected_option = 0;
@@ -62,6 +92,18 @@ void GSFrameBufferObj::ImGuiCallback()
 		m_precision = static_cast<PRECISION>(selected_option);
 		SetUpFBOColorTex();
 	}
+
+	ImGui::SliderFloat("Render Scale", &m_resolutionScale, 0.25f, 1.0f);
+	ImGui::Text("Splat pass %d x %d of %d x %d", m_renderSize.x, m_renderSize.y, m_fboSize.x, m_fboSize.y);
+	int filter = static_cast<int>(m_upscaleFilter);
+	ImGui::Text("Upscale filter");
+	bool isFilterChanged = ImGui::RadioButton("Bilinear", &filter, BILINEAR);
+	ImGui::SameLine();
+	isFilterChanged |= ImGui::RadioButton("Sharpen", &filter, SHARPEN);
+	if (isFilterChanged)
+		m_upscaleFilter = static_cast<UPSCALE_FILTER>(filter);
+	if (m_upscaleFilter == SHARPEN)
+		ImGui::SliderFloat("Sharpness", &m_sharpness, 0.0f, 1.0f);
 }
 
 void GSFrameBufferObj::SetUpData()
@@ -87,9 +129,9 @@ void GSFrameBufferObj::SetUpData()
 
 void GSFrameBufferObj::SetUpFBOColorTex()
 {
-	auto instance = Camera::GetInstance();
-	int screen_width = instance->GetScreenWidth();
-	int screen_height = instance->GetScreenHeight();
+	glm::ivec2 size = GetScreenSize();
+	int screen_width = size.x;
+	int screen_height = size.y;
 	if (m_precision == UINT8)
 	{
 		if (!IsFBOCreated())
@@ -130,8 +172,9 @@ void GSFrameBufferObj::SetUpFBOColorTex()
 void GSFrameBufferObj::SetUpFBOParams()
 {
 	m_fbo = std::make_shared<FrameBuffer>();
-	m_texParams.minFilter = FilterType::Nearest;
-	m_texParams.magFilter = FilterType::Nearest;
+	// bilinear, so a splat pass below screen size is stretched smoothly, at full size it samples texel centres
+	m_texParams.minFilter = FilterType::Linear;
+	m_texParams.magFilter = FilterType::Linear;
 	m_texParams.sWrap = WrapType::ClampToEdge;
 	m_texParams.tWrap = WrapType::ClampToEdge;
 }
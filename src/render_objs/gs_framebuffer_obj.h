@@ -20,6 +20,11 @@ public:
 		FP32
 	};
 
+	enum UPSCALE_FILTER : uint32_t {
+		BILINEAR,
+		SHARPEN
+	};
+
 	GSFrameBufferObj(const std::string& vertexShader, const std::string& fragmentShader);
 
 	GSFrameBufferObj(std::shared_ptr<Parser::RenderObjConfigBase> baseConfigPtr)
@@ -27,9 +32,18 @@ public:
 		auto ConfigPtr = std::static_pointer_cast<Parser::RenderObjConfigSimple>(baseConfigPtr);
 		GSFrameBufferObj(ConfigPtr->vertexShader, ConfigPtr->fragmentShader);
 	}
-	void DrawObj(const std::unordered_map<std::string, std::any>& uniform);
+	void DrawObj(const FrameContext& frame);
 	glm::ivec2& GetFboSize() { return m_fboSize; }
+	glm::ivec2 GetRenderSize() const { return m_renderSize; }
+	// colour texture the splats are rendered into and its internal format, for image stores
+	GLuint GetColorTexture() { return m_textures->GetTexture(m_textureIdx); }
+	GLenum GetColorFormat() const;
+	// the splats are drawn into the lower left scale x screen size of the framebuffer and stretched over the screen
+	void SetResolutionScale(float scale) { m_resolutionScale = scale; }
+	float GetResolutionScale() const { return m_resolutionScale; }
 	void PrepareDraw();
+	// rebinds the framebuffer and viewport that were bound before PrepareDraw
+	void BindTarget();
 	void ImGuiCallback();
 private:
 	void SetUpTexture(int num) override { m_textures = std::make_unique<Texture>(num); }
@@ -38,12 +52,19 @@ private:
 	void SetUpFBOParams();
 	void SetUpGLStatus();
 	void UpdateFBO();
+	glm::ivec2 GetScreenSize() const;
 	bool IsFBOCreated() { return m_fboSize.x != 0 && m_fboSize.y != 0; }
 	void SetFBOSize(glm::ivec2 size) { m_fboSize = size; }
 
 private:
 	std::shared_ptr<FrameBuffer> m_fbo = nullptr;
-	glm::ivec2 m_fboSize = { 0, 0 };
+	int m_targetFramebuffer = 0;  // framebuffer bound before PrepareDraw, receives the composite
+	int m_targetViewport[4] = {};
+	glm::ivec2 m_fboSize = { 0, 0 };  // allocated at screen size, only reallocated when the window is resized
+	glm::ivec2 m_renderSize = { 0, 0 };
+	float m_resolutionScale = 1.0f;
+	UPSCALE_FILTER m_upscaleFilter = UPSCALE_FILTER::BILINEAR;
+	float m_sharpness = 0.5f;
 	int m_textureIdx = -1;
 	Texture::Params m_texParams;
 	PRECISION m_precision = PRECISION::FP16;
@@ -0,0 +1,219 @@
+#include "./gs_lod.h"
+
+#include <map>
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+#include <cfloat>
+RENDERABLE_BEGIN
+namespace {
+glm::mat3 ToMat3(const float* cov)
+{
+	return glm::mat3(
+		cov[0], cov[1], cov[2],
+		cov[1], cov[3], cov[4],
+		cov[2], cov[4], cov[5]);
+}
+
+float ExtentRadius(const float* cov)
+{
+	// the trace bounds the largest eigenvalue, so this always covers the 3 sigma ellipsoid
+	return 3.0f * std::sqrt((std::max)(cov[0] + cov[3] + cov[5], 0.0f));
+}
+
+float Area(const glm::mat3& cov)
+{
+	// det^(1/3) is proportional to the squared footprint of the ellipsoid
+	return std::cbrt((std::max)(glm::determinant(cov), 1e-30f));
+}
+
+uint32_t CountMerged(uint32_t leafCount, std::map<uint32_t, uint32_t>& memo)
+{
+	if (leafCount <= 1)
+		return 0;
+	if (auto it = memo.find(leafCount); it != memo.end())
+		return it->second;
+
+	// mirrors the three rounds of median splits in BuildNode
+	std::vector<uint32_t> sizes{ leafCount };
+	for (uint32_t round = 0; round < 3; round++) {
+		std::vector<uint32_t> next;
+		for (uint32_t size : sizes) {
+			if (size > 1) {
+				next.push_back(size / 2);
+				next.push_back(size - size / 2);
+			}
+			else {
+				next.push_back(size);
+			}
+		}
+		sizes.swap(next);
+	}
+
+	uint32_t count = 1;
+	for (uint32_t size : sizes)
+		count += CountMerged(size, memo);
+	memo[leafCount] = count;
+	return count;
+}
+}
+
+uint32_t GSLodHierarchy::CountMergedNodes(uint32_t leafCount)
+{
+	// the splits only depend on the range size, so the tree shape is known before building
+	// and at most two range sizes occur per depth
+	std::map<uint32_t, uint32_t> memo;
+	return CountMerged(leafCount, memo);
+}
+
+void GSLodHierarchy::Build(std::vector<Gaussian>& gaussians, const MergeCallback& onMerge)
+{
+	m_nodes.clear();
+	m_children.clear();
+	m_depth = 0;
+	m_leafCount = static_cast<uint32_t>(gaussians.size());
+	if (m_leafCount == 0)
+		return;
+
+	m_nodes.reserve(m_leafCount + CountMergedNodes(m_leafCount));
+	m_order.resize(m_leafCount);
+	std::iota(m_order.begin(), m_order.end(), 0);
+	m_root = BuildNode(gaussians, 0, m_leafCount, 0, onMerge);
+	m_order.clear();
+	m_order.shrink_to_fit();
+}
+
+void GSLodHierarchy::SelectCut(const glm::mat4& view, float focalPixel, float pixelError, std::vector<uint32_t>& cut) const
+{
+	cut.clear();
+	if (m_nodes.empty())
+		return;
+
+	m_stack.clear();
+	m_stack.push_back(m_root);
+	while (!m_stack.empty()) {
+		const Node& node = m_nodes[m_stack.back()];
+		m_stack.pop_back();
+
+		float depth = -(view * glm::vec4(node.center, 1.0f)).z;
+		if (depth + node.radius < 0.0f)  // entirely behind the camera
+			continue;
+
+		if (node.childCount == 0 ||
+			(depth > node.radius && node.radius * focalPixel / depth < pixelError)) {
+			cut.push_back(node.slot);
+			continue;
+		}
+		for (uint32_t i = 0; i < node.childCount; i++) {
+			m_stack.push_back(m_children[node.firstChild + i]);
+		}
+	}
+}
+
+uint32_t GSLodHierarchy::BuildNode(std::vector<Gaussian>& gaussians, uint32_t begin, uint32_t end, uint32_t depth, const MergeCallback& onMerge)
+{
+	m_depth = (std::max)(m_depth, depth);
+	if (end - begin == 1) {
+		uint32_t slot = m_order[begin];
+		m_nodes.push_back({ gaussians[slot].position, ExtentRadius(gaussians[slot].covariance), slot, 0, 0 });
+		return static_cast<uint32_t>(m_nodes.size() - 1);
+	}
+
+	// three rounds of median splits give an octree-like fan out of up to eight children
+	std::vector<std::pair<uint32_t, uint32_t>> ranges{ { begin, end } };
+	for (uint32_t round = 0; round < 3; round++) {
+		std::vector<std::pair<uint32_t, uint32_t>> next;
+		for (auto [first, last] : ranges) {
+			if (last - first > 1) {
+				uint32_t mid = SplitRange(gaussians, first, last);
+				next.emplace_back(first, mid);
+				next.emplace_back(mid, last);
+			}
+			else {
+				next.emplace_back(first, last);
+			}
+		}
+		ranges.swap(next);
+	}
+
+	std::vector<uint32_t> childIds;
+	std::vector<uint32_t> childSlots;
+	for (auto [first, last] : ranges) {
+		uint32_t childId = BuildNode(gaussians, first, last, depth + 1, onMerge);
+		childIds.push_back(childId);
+		childSlots.push_back(m_nodes[childId].slot);
+	}
+
+	std::vector<float> weights;
+	Gaussian merged = Merge(gaussians, childSlots, weights);
+	uint32_t slot = static_cast<uint32_t>(gaussians.size());
+	gaussians.push_back(merged);
+	if (onMerge)
+		onMerge(slot, childSlots, weights);
+
+	float radius = 0.0f;
+	for (uint32_t childId : childIds) {
+		const Node& child = m_nodes[childId];
+		radius = (std::max)(radius, glm::length(child.center - merged.position) + child.radius);
+	}
+
+	Node node{ merged.position, radius, slot, static_cast<uint32_t>(m_children.size()), static_cast<uint32_t>(childIds.size()) };
+	m_children.insert(m_children.end(), childIds.begin(), childIds.end());
+	m_nodes.push_back(node);
+	return static_cast<uint32_t>(m_nodes.size() - 1);
+}
+
+uint32_t GSLodHierarchy::SplitRange(const std::vector<Gaussian>& gaussians, uint32_t begin, uint32_t end)
+{
+	glm::vec3 minPos(FLT_MAX), maxPos(-FLT_MAX);
+	for (uint32_t i = begin; i < end; i++) {
+		minPos = (glm::min)(minPos, gaussians[m_order[i]].position);
+		maxPos = (glm::max)(maxPos, gaussians[m_order[i]].position);
+	}
+	glm::vec3 extent = maxPos - minPos;
+	int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+
+	uint32_t mid = begin + (end - begin) / 2;
+	std::nth_element(m_order.begin() + begin, m_order.begin() + mid, m_order.begin() + end,
+		[&gaussians, axis](uint32_t a, uint32_t b) {
+			return gaussians[a].position[axis] < gaussians[b].position[axis];
+		});
+	return mid;
+}
+
+GSLodHierarchy::Gaussian GSLodHierarchy::Merge(const std::vector<Gaussian>& gaussians, const std::vector<uint32_t>& slots, std::vector<float>& weights) const
+{
+	// weight every child by its opacity times footprint so the merged gaussian keeps the
+	// total opacity mass, then match the first and second moments of the mixture
+	weights.resize(slots.size());
+	float totalWeight = 0.0f;
+	glm::vec3 mean(0.0f);
+	for (size_t i = 0; i < slots.size(); i++) {
+		const Gaussian& g = gaussians[slots[i]];
+		weights[i] = g.opacity * Area(ToMat3(g.covariance)) + 1e-12f;
+		totalWeight += weights[i];
+		mean += weights[i] * g.position;
+	}
+	mean /= totalWeight;
+
+	glm::mat3 cov(0.0f);
+	for (size_t i = 0; i < slots.size(); i++) {
+		const Gaussian& g = gaussians[slots[i]];
+		glm::vec3 d = g.position - mean;
+		cov += weights[i] * (ToMat3(g.covariance) + glm::outerProduct(d, d));
+		weights[i] /= totalWeight;
+	}
+	cov /= totalWeight;
+
+	Gaussian merged{};
+	merged.position = mean;
+	merged.opacity = glm::clamp(totalWeight / Area(cov), 0.0f, 1.0f);
+	merged.covariance[0] = cov[0][0];
+	merged.covariance[1] = cov[0][1];
+	merged.covariance[2] = cov[0][2];
+	merged.covariance[3] = cov[1][1];
+	merged.covariance[4] = cov[1][2];
+	merged.covariance[5] = cov[2][2];
+	return merged;
+}
+RENDERABLE_END
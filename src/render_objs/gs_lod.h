@@ -0,0 +1,59 @@
+#pragma once
+#include <vector>
+#include <functional>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "common.h"
+
+RENDERABLE_BEGIN
+// Level of detail hierarchy for 3D gaussian scenes.
+// Leaves are the original splats addressed by their texture slot, every internal node is a
+// moment-matched merge of up to eight spatially coherent children and is appended after the
+// leaves, so node slots stay valid indices into the gaussian texture.
+class GSLodHierarchy
+{
+public:
+	struct Gaussian {
+		glm::vec3 position;
+		float opacity;
+		float covariance[6];  // xx, xy, xz, yy, yz, zz
+	};
+
+	// slot of the merged gaussian, slots of its children and their normalised weights
+	using MergeCallback = std::function<void(uint32_t, const std::vector<uint32_t>&, const std::vector<float>&)>;
+
+	// gaussians[i] is the leaf stored in slot i, merged parents are appended to the vector
+	void Build(std::vector<Gaussian>& gaussians, const MergeCallback& onMerge);
+	// number of merged parents Build appends for leafCount leaves
+	static uint32_t CountMergedNodes(uint32_t leafCount);
+	// collect the slots of the coarsest nodes whose projected radius is below pixelError
+	void SelectCut(const glm::mat4& view, float focalPixel, float pixelError, std::vector<uint32_t>& cut) const;
+	bool Empty() const { return m_nodes.empty(); }
+	uint32_t GetLeafCount() const { return m_leafCount; }
+	uint32_t GetNodeCount() const { return static_cast<uint32_t>(m_nodes.size()); }
+	uint32_t GetDepth() const { return m_depth; }
+
+private:
+	struct Node {
+		glm::vec3 center;
+		float radius;  // bounding sphere of the 3 sigma extent of every covered splat
+		uint32_t slot;
+		uint32_t firstChild;
+		uint32_t childCount;  // 0 for leaves
+	};
+
+	uint32_t BuildNode(std::vector<Gaussian>& gaussians, uint32_t begin, uint32_t end, uint32_t depth, const MergeCallback& onMerge);
+	uint32_t SplitRange(const std::vector<Gaussian>& gaussians, uint32_t begin, uint32_t end);
+	Gaussian Merge(const std::vector<Gaussian>& gaussians, const std::vector<uint32_t>& slots, std::vector<float>& weights) const;
+
+private:
+	static constexpr uint32_t MAX_CHILDREN = 8;
+	std::vector<Node> m_nodes{};
+	std::vector<uint32_t> m_children{};
+	std::vector<uint32_t> m_order{};
+	mutable std::vector<uint32_t> m_stack{};
+	uint32_t m_root = 0;
+	uint32_t m_leafCount = 0;
+	uint32_t m_depth = 0;
+};
+RENDERABLE_END
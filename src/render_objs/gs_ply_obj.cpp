@@ -1,6 +1,12 @@
+#include <eigen3/Eigen/Dense>
 #include "./gs_ply_obj.h"
+#include "../draw/program_cache.h"
 
 #include <mutex>
+#include <cstring>
+#include <format>
+#include <numeric>
+#include <algorithm>
 RENDERABLE_BEGIN
 constexpr const float SH_C0 = 0.28209479177387814f;
 constexpr const float SH_C1 = 0.4886025119029199f;
@@ -21,6 +27,48 @@ constexpr const float SH_C3[] = {
 	-0.5900435899266435f
 };
 
+// GL_KHR_shader_subgroup is not part of the loaded GL headers
+#ifndef GL_SUBGROUP_SIZE_KHR
+#define GL_SUBGROUP_SIZE_KHR 0x9532
+#define GL_SUBGROUP_SUPPORTED_STAGES_KHR 0x9533
+#define GL_SUBGROUP_SUPPORTED_FEATURES_KHR 0x9534
+#define GL_SUBGROUP_FEATURE_BASIC_BIT_KHR 0x00000001
+#define GL_SUBGROUP_FEATURE_ARITHMETIC_BIT_KHR 0x00000004
+#define GL_SUBGROUP_FEATURE_BALLOT_BIT_KHR 0x00000008
+#endif
+
+// GL_ARB_pipeline_statistics_query, core in GL 4.6
+#ifndef GL_FRAGMENT_SHADER_INVOCATIONS_ARB
+#define GL_FRAGMENT_SHADER_INVOCATIONS_ARB 0x82F4
+#endif
+
+const ShaderDefines& GetRadixSortDefines()
+{
+	static std::once_flag once;
+	static ShaderDefines defines{};
+	std::call_once(once, []() {
+		bool hasSubgroups = false;
+		GLint extensionCount = 0;
+		glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+		for (GLint i = 0; i < extensionCount && !hasSubgroups; i++) {
+			const char* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+			hasSubgroups = extension && std::strcmp(extension, "GL_KHR_shader_subgroup") == 0;
+		}
+		GLint size = 0, stages = 0, features = 0;
+		if (hasSubgroups) {
+			glGetIntegerv(GL_SUBGROUP_SIZE_KHR, &size);
+			glGetIntegerv(GL_SUBGROUP_SUPPORTED_STAGES_KHR, &stages);
+			glGetIntegerv(GL_SUBGROUP_SUPPORTED_FEATURES_KHR, &features);
+		}
+		const GLint REQUIRED_FEATURES = GL_SUBGROUP_FEATURE_BASIC_BIT_KHR | GL_SUBGROUP_FEATURE_ARITHMETIC_BIT_KHR | GL_SUBGROUP_FEATURE_BALLOT_BIT_KHR;
+		// the kernel keeps one partial sum per subgroup in RADIX_SORT_BINS / 32 slots
+		const GLint MIN_SUBGROUP_SIZE = 32;
+		if (size < MIN_SUBGROUP_SIZE || !(stages & GL_COMPUTE_SHADER_BIT) || (features & REQUIRED_FEATURES) != REQUIRED_FEATURES)
+			defines.push_back("SHARED_MEMORY_SCAN");
+	});
+	return defines;
+}
+
 std::pair<float, float> Base3DGSObj::calculateMinMax(const std::vector<float>& data)
 {
 	float min, max;
@@ -91,6 +139,26 @@ void GetSigma(std::vector<T>& scale, std::vector<T>& rotation, std::vector<T>& s
 	sigma[5] = M[2] * M[2] + M[5] * M[5] + M[8] * M[8];
 }
 
+// inverse of GetSigma: the eigenvectors of the covariance are the columns of the rotation
+// and the square roots of its eigenvalues the scale
+void GetScaleRotation(const float* sigma, glm::vec3& scale, glm::vec4& rotation)
+{
+	Eigen::Matrix3d covariance;
+	covariance << sigma[0], sigma[1], sigma[2],
+		sigma[1], sigma[3], sigma[4],
+		sigma[2], sigma[4], sigma[5];
+	Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> solver(covariance);
+	Eigen::Matrix3d axes = solver.eigenvectors();
+	if (axes.determinant() < 0.0)
+		axes.col(2) = -axes.col(2);  // a proper rotation, not a reflection
+
+	Eigen::Quaterniond q(axes);
+	q.normalize();
+	Eigen::Vector3d variance = solver.eigenvalues().cwiseMax(0.0);
+	scale = glm::vec3(std::sqrt(variance.x()), std::sqrt(variance.y()), std::sqrt(variance.z()));
+	rotation = glm::vec4(q.w(), q.x(), q.y(), q.z());
+}
+
 void GSPlyObj::PlyHeader::UpdateVerticesOffset(std::string property, std::pair<size_t, size_t>& start_end)
 {
 	if (verticePropertiesOffset.find(property) == verticePropertiesOffset.end()) {
@@ -104,58 +172,186 @@ void GSPlyObj::PlyHeader::UpdateVerticesOffset(std::string property, std::pair<s
 
 GSPlyObj::GSPlyObj(std::shared_ptr<Parser::RenderObjConfigBase> baseConfigPtr)
 {
-	auto configPtr = std::static_pointer_cast<Parser::RenderObjConfig3DGS>(baseConfigPtr);
-	SetUpShader(configPtr->vertexShader.c_str(), configPtr->fragmentShader.c_str());
-	SetUpFbo(configPtr->fboVertexShader.c_str(), configPtr->fboFragmentShader.c_str());
-	std::ifstream file(configPtr->modelPath, std::ios::binary);
+	LoadConfig(baseConfigPtr);
+}
+
+GSPlyObj::~GSPlyObj()
+{
+	if (m_recordBuffer != 0)
+	{
+		GpuMemoryTracker::GetInstance()->Release(GpuMemoryTracker::Kind::Buffer, m_recordBuffer);
+		glDeleteBuffers(1, &m_recordBuffer);
+	}
+	if (m_fragmentQueries[0] != 0)
+		glDeleteQueries(FRAGMENT_QUERY_COUNT, m_fragmentQueries);
+}
+
+void GSPlyObj::LoadData()
+{
+	std::ifstream file(m_config->modelPath, std::ios::binary);
 	LoadModelHeader(file, m_header);
 	SetUpAttribute();
 	LoadVertices(file);
 	PresortIndices(m_vertices);
+	if (m_config->lod) {
+		m_enableLod = true;
+		m_lodPixelError = m_config->lodPixelError;
+		BuildLodHierarchy();
+	}
+	ComputeImportance();
+	m_quality.SetConfig(m_config->quality);
 	GenerateTextureData();
+}
+
+size_t GSPlyObj::GetMemoryUsage() const
+{
+	return Base3DGSObj::GetMemoryUsage() + m_vertices.size() * sizeof(PlyVertex3) +
+		m_slotImportance.size() * sizeof(float) + m_importanceOrder.size() * sizeof(uint32_t) + m_vertexCount * SPLAT_RECORD_SIZE +
+		(m_tileRasterizer ? m_tileRasterizer->GetMemoryUsage() : 0);
+}
+
+void GSPlyObj::SetUpGL()
+{
+	// the adaptive quality controller changes the SH degree at runtime, so every variant is built up front
+	std::vector<ShaderDefines> variants;
+	for (int shDegree = 0; shDegree < SH_DEGREE_COUNT; shDegree++) {
+		variants.push_back(GetVariantDefines(shDegree, false));
+		variants.push_back(GetVariantDefines(shDegree, true));
+	}
+	PrefetchPrograms(variants);
+	std::vector<ProgramStages> preprocessPrograms{
+		{ { GL_VERTEX_SHADER, PLY_EXPAND_VERTEX_SHADER }, { GL_FRAGMENT_SHADER, m_config->fragmentShader } },
+	};
+	for (int shDegree = 0; shDegree < SH_DEGREE_COUNT; shDegree++) {
+		preprocessPrograms.push_back({ { GL_COMPUTE_SHADER, PLY_PREPROCESS_SHADER, { std::format("SH_DEGREE {}", shDegree) } } });
+	}
+	for (auto& program : GSTileRasterizer::GetPrograms()) {
+		preprocessPrograms.push_back(std::move(program));
+	}
+	ProgramCache::GetInstance()->Prefetch(preprocessPrograms);
+	SelectShaderVariant(false);
+	m_expandShader = std::make_shared<Shader>(PLY_EXPAND_VERTEX_SHADER, m_config->fragmentShader.c_str());
+	m_expandRenderSizeUniform = m_expandShader->GetUniformHandle("renderSize");
+	// a cut or a budget only ever draws fewer splats than there are leaves
+	glGenBuffers(1, &m_recordBuffer);
+	GpuMemoryTracker::GetInstance()->Allocate(GpuMemoryTracker::Kind::Buffer, m_recordBuffer, m_vertexCount * SPLAT_RECORD_SIZE, "splat record buffer");
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_recordBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, m_vertexCount * SPLAT_RECORD_SIZE, nullptr, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	SetUpFbo(m_config->fboVertexShader.c_str(), m_config->fboFragmentShader.c_str());
 	GenerateTexture();
 	SetUpData();
 }
 
-void GSPlyObj::DrawObj(const std::unordered_map<std::string, std::any>& uniform)
+void GSPlyObj::DrawObj(const FrameContext& frame)
 {
+	UpdateQuality();
+	if (m_scaleCheckRequested) {
+		m_scaleCheckRequested = false;
+		CheckResolutionScale();
+	}
 	if (m_fbo)
 		m_fbo->PrepareDraw();
-	{
-		glm::mat4 projection = std::any_cast<glm::mat4>(uniform.at("perspective_projection"));
-		glm::mat4 view = std::any_cast<glm::mat4>(uniform.at("view"));
-		glm::mat4 model = std::any_cast<glm::mat4>(uniform.at("model"));
-		glm::vec2 focal = std::any_cast<glm::vec2>(uniform.at("focal"));
-		glm::vec2 viewport = std::any_cast<glm::vec2>(uniform.at("viewport"));
-		glm::vec3 camPos = std::any_cast<glm::vec3>(uniform.at("camPos"));
-		glm::vec2 tanFov = std::any_cast<glm::vec2>(uniform.at("tanFov"));
-		glm::vec2 nearFar = std::any_cast<glm::vec2>(uniform.at("nearFar"));
-		SetUpGLStatus();
-		RunSortUpdateDepth();
-		m_shader->Use();
-		m_renderVAO->Bind();
-		m_gaussian_texture->BindTexture(m_textureIdx);
-		m_shader->SetMat4("projection", projection);
-		m_shader->SetMat4("view", view);
-		m_shader->SetMat4("model", model);
-		m_shader->SetVec2("focal", focal);
-		m_shader->SetVec2("viewport", viewport);
-		m_shader->SetVec3("camPos", camPos);
-		m_shader->SetVec2("tanFov", tanFov);
-		m_shader->SetVec2("nearFar", nearFar);
-		m_shader->SetInt("u_texture", m_textureIdx);
-		m_shader->SetInt("sphericalHarmonicsDegree", m_sphericalHarmonicsDegree);
-		m_shader->SetInt("showGaussian", 3);
-		Draw();
-		m_renderVAO->Unbind();
+	DrawSplats();
+	if (m_cpuReferenceRequested) {
+		m_cpuReferenceRequested = false;
+		RenderCpuReference(frame);
 	}
 	if (m_fbo)
-		m_fbo->DrawObj(uniform);
+		m_fbo->DrawObj(frame);
+}
+
+void GSPlyObj::DrawSplats()
+{
+	SetUpGLStatus();
+	RunSortUpdateDepth();
+	// GPU sorted indices are read in place, the instanced index attribute is only fed by the CPU sorters
+	GLuint gpuIndexBuffer = m_sortMethod > RADIX_SORT ? m_sorter->GetIndexBuffer() : 0;
+	m_gaussian_texture->BindTexture(m_textureIdx);
+	if (m_backend == TILE_COMPUTE) {
+		// the tiles sort by depth themselves, the sorted order only decides the record order
+		PreprocessSplats(gpuIndexBuffer != 0 ? gpuIndexBuffer : m_depthIndexVBO->GetObj());
+		if (!m_tileRasterizer)
+			m_tileRasterizer = std::make_shared<GSTileRasterizer>();
+		m_tileRasterizer->Render(m_recordBuffer, m_drawCount, m_fbo->GetRenderSize(), m_fbo->GetColorTexture(), m_fbo->GetColorFormat());
+		return;
+	}
+	// the fragments are compared with splats projected for the screen, the pass covers only renderSize pixels
+	glm::vec2 renderSize = m_fbo->GetRenderSize();
+	if (m_usePreprocess) {
+		PreprocessSplats(gpuIndexBuffer != 0 ? gpuIndexBuffer : m_depthIndexVBO->GetObj());
+		m_expandShader->Use();
+		m_expandShader->SetVec2(m_expandRenderSizeUniform, renderSize);
+	}
+	else {
+		SelectShaderVariant(gpuIndexBuffer != 0);
+		if (gpuIndexBuffer != 0)
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, gpuIndexBuffer);
+		m_shader->Use();
+		m_shader->SetInt(m_textureUniform, m_textureIdx);
+		m_shader->SetBool(m_fixedExtentUniform, !m_opacityAwareExtent);
+		m_shader->SetVec2(m_renderSizeUniform, renderSize);
+	}
+	m_renderVAO->Bind();
+	{
+		PROFILE_SCOPE("Splat Draw");
+		bool countFragments = BeginFragmentCount();
+		Draw(m_drawCount);
+		if (countFragments)
+			glEndQuery(GL_FRAGMENT_SHADER_INVOCATIONS_ARB);
+	}
+	m_renderVAO->Unbind();
 }
 
 void GSPlyObj::ImGuiCallback()
 {
-	ImGui::SliderInt("SphericalHarmonicsDegree", &m_sphericalHarmonicsDegree, 1, 3);
+	ImGui::SliderInt("SphericalHarmonicsDegree", &m_sphericalHarmonicsDegree, 0, SH_DEGREE_COUNT - 1);
+	{
+		int backend = static_cast<int>(m_backend);
+		ImGui::Text("Splat Backend");
+		ImGui::RadioButton("Hardware Blend", &backend, HARDWARE_BLEND);
+		ImGui::SameLine();
+		ImGui::RadioButton("Tile Compute", &backend, TILE_COMPUTE);
+		m_backend = static_cast<SPLAT_BACKEND>(backend);
+	}
+	ImGui::Checkbox("Opacity Aware Extent", &m_opacityAwareExtent);
+	if (ImGui::IsItemHovered())
+		ImGui::SetTooltip("Ends the quads where the splats fade below the discarded alpha instead of at 3 sigma");
+	if (m_backend == HARDWARE_BLEND) {
+		ImGui::Checkbox("Compute Preprocess", &m_usePreprocess);
+		if (ImGui::IsItemHovered())
+			ImGui::SetTooltip("Projects each splat once in a compute pass, compare Splat Preprocess + Splat Draw in the profiler");
+		ImGui::Checkbox("Count Shaded Fragments", &m_countFragments);
+		if (m_countFragments) {
+			// toggle the extent to fill in both counts
+			ImGui::Text("Shaded Fragments: 3 sigma %llu, opacity aware %llu", static_cast<unsigned long long>(m_shadedFragments[0]),
+				static_cast<unsigned long long>(m_shadedFragments[1]));
+			if (m_shadedFragments[0] != 0 && m_shadedFragments[1] != 0)
+				ImGui::Text("Opacity aware extent shades %.1f%% of the fragments", 100.0 * m_shadedFragments[1] / m_shadedFragments[0]);
+		}
+	}
+	else if (m_tileRasterizer) {
+		m_tileRasterizer->ImGuiCallback();
+	}
+	if (ImGui::Button("CPU Reference"))
+		m_cpuReferenceRequested = true;
+	if (ImGui::IsItemHovered())
+		ImGui::SetTooltip("Renders the next frame with the software rasterizer to gs_cpu_reference.png and compares it with the splat framebuffer of the selected backend");
+	ImGui::SameLine();
+	if (ImGui::Button("Resolution Check"))
+		m_scaleCheckRequested = true;
+	if (ImGui::IsItemHovered())
+		ImGui::SetTooltip("Renders the next frame at resolution scale 1 and 0.5 and prints the difference of the two");
+	if (m_cpuRasterizer)
+		ImGui::Text("CPU Reference: %.1f ms, %zu tile entries", m_cpuRasterizer->GetLastRenderMs(), m_cpuRasterizer->GetLastDuplicateCount());
+	if (m_lod)
+	{
+		ImGui::Checkbox("Level Of Detail", &m_enableLod);
+		ImGui::SliderFloat("LOD Pixel Error", &m_lodPixelError, 0.5f, 16.0f);
+		ImGui::Text("LOD Cut: %u / %u splats, depth %u", m_drawCount, m_lod->GetLeafCount(), m_lod->GetDepth());
+		if (m_enableLod && m_sortMethod > RADIX_SORT)
+			ImGui::Text("LOD is only applied with CPU sorting methods");
+	}
 	{
 		static int selected_option = 0;
 		ImGui::Text("Sorting Method");
@@ -184,13 +380,312 @@ void GSPlyObj::ImGuiCallback()
 		}
 		m_sortMethod = static_cast<SORT_METHOD>(selected_option);
 	}
+	m_quality.ImGuiCallback();
 	Base3DGSObj::ImGuiCallback();
 	m_fbo->ImGuiCallback();
 }
 
 void GSPlyObj::RunSortUpdateDepth()
 {
-	m_sorter->Sort(m_vertices, m_indices, m_depthIndex, m_depthIndexVBO);
+	PROFILE_CPU_SCOPE("Sort");
+	// the quality controller may let the previous order stand for a few frames
+	if (m_sortSkip > 0) {
+		m_sortSkip--;
+		return;
+	}
+	m_sortSkip = m_sortInterval - 1;
+
+	// the GPU sorters keep their own copy of the leaf positions, so the cut and the budget are CPU only
+	bool isCpuSort = m_sortMethod <= RADIX_SORT;
+	bool useLod = m_enableLod && m_lod && isCpuSort;
+	uint32_t budget = static_cast<uint32_t>(m_splatRatio * m_vertexCount);
+	bool useBudget = isCpuSort && budget < m_vertexCount;
+	if (!useLod && !useBudget) {
+		if (m_subsetActive) {
+			m_sorter->SetVertexCount(m_vertexCount);
+			m_subsetActive = false;
+		}
+		m_sorter->Sort(m_vertices, m_indices, m_depthIndex, isCpuSort ? m_depthIndexVBO : nullptr);
+		m_drawCount = m_vertexCount;
+		return;
+	}
+
+	if (useLod) {
+		auto camera = Camera::GetInstance();
+		float focalPixel = camera->GetProjMat()[1][1] * 0.5f * camera->GetScreenHeight();
+		m_lod->SelectCut(camera->GetViewMat(), focalPixel, m_lodPixelError, m_drawSlots);
+		if (useBudget && m_drawSlots.size() > budget) {
+			std::nth_element(m_drawSlots.begin(), m_drawSlots.begin() + budget, m_drawSlots.end(), [this](uint32_t a, uint32_t b) {
+				return m_slotImportance[a] > m_slotImportance[b];
+				});
+			m_drawSlots.resize(budget);
+		}
+	}
+	else {
+		m_drawSlots.assign(m_importanceOrder.begin(), m_importanceOrder.begin() + budget);
+	}
+	m_drawSlotIndices.resize(m_drawSlots.size());
+	for (size_t i = 0; i < m_drawSlots.size(); i++) {
+		m_drawSlotIndices[i] = m_indices[m_drawSlots[i]];
+	}
+
+	// sort positions within the subset, then translate them back into texture slots
+	m_drawCount = static_cast<uint32_t>(m_drawSlots.size());
+	m_sorter->SetVertexCount(m_drawCount);
+	m_sorter->Sort(m_vertices, m_drawSlotIndices, m_depthIndex, nullptr);
+	for (uint32_t i = 0; i < m_drawCount; i++) {
+		m_depthIndex[i] = m_drawSlots[m_depthIndex[i]];
+	}
+	{
+		PROFILE_SCOPE("Index Upload");
+		m_depthIndexVBO->UpdateRange(m_depthIndex, 0, m_drawCount, true);
+	}
+	m_subsetActive = true;
+}
+
+void GSPlyObj::ComputeImportance()
+{
+	// opacity times the trace of the covariance, a cheap proxy for the screen area a splat covers
+	m_slotImportance.resize(m_indices.size());
+	for (size_t slot = 0; slot < m_indices.size(); slot++) {
+		const auto& vertex = m_vertices[m_indices[slot]];
+		m_slotImportance[slot] = vertex.opacity * glm::dot(vertex.scale, vertex.scale);
+	}
+
+	m_importanceOrder.resize(m_vertexCount);
+	std::iota(m_importanceOrder.begin(), m_importanceOrder.end(), 0);
+	std::sort(m_importanceOrder.begin(), m_importanceOrder.end(), [this](uint32_t a, uint32_t b) {
+		return m_slotImportance[a] > m_slotImportance[b];
+		});
+}
+
+void GSPlyObj::UpdateQuality()
+{
+	bool isEnabled = m_quality.IsEnabled();
+	// the work time only changes when the profiler resolves a frame, and never while profiling is off,
+	// feeding the same sample again would count one slow frame as many
+	auto profiler = Profiler::GetInstance();
+	bool hasSample = profiler->GetResolvedCount() != m_qualitySample;
+	m_qualitySample = profiler->GetResolvedCount();
+	if (!(hasSample && m_quality.Update(profiler->GetWorkMs())) && isEnabled == m_qualityApplied)
+		return;
+	// disabling the controller drops it back to level 0, which restores full quality once
+	m_qualityApplied = isEnabled;
+	const auto& settings = m_quality.GetSettings();
+	m_sphericalHarmonicsDegree = settings.shDegree;
+	m_splatRatio = settings.splatRatio;
+	m_sortInterval = settings.sortInterval;
+	m_sortSkip = 0;
+	// both backends sample the splats at the screen position of their pixels, the hardware path since gs_ply_fs
+	// maps gl_FragCoord by viewport / renderSize, so a lowered scale only coarsens the image
+	if (m_fbo)
+		m_fbo->SetResolutionScale(settings.resolutionScale);
+}
+
+ShaderDefines GSPlyObj::GetVariantDefines(int shDegree, bool gpuSort)
+{
+	ShaderDefines defines{ std::format("SH_DEGREE {}", shDegree) };
+	if (gpuSort)
+		defines.push_back("USE_GPU_SORT");
+	return defines;
+}
+
+void GSPlyObj::SelectShaderVariant(bool gpuSort)
+{
+	int shDegree = std::clamp(m_sphericalHarmonicsDegree, 0, SH_DEGREE_COUNT - 1);
+	ShaderVariant& variant = m_shaderVariants[shDegree][gpuSort ? 1 : 0];
+	if (!variant.shader) {
+		variant.shader = std::make_shared<Shader>(m_config->vertexShader.c_str(), m_config->fragmentShader.c_str(), GetVariantDefines(shDegree, gpuSort));
+		variant.textureUniform = variant.shader->GetUniformHandle("u_texture");
+		variant.fixedExtentUniform = variant.shader->GetUniformHandle("fixedExtent");
+		variant.renderSizeUniform = variant.shader->GetUniformHandle("renderSize");
+	}
+	m_shader = variant.shader;
+	m_textureUniform = variant.textureUniform;
+	m_fixedExtentUniform = variant.fixedExtentUniform;
+	m_renderSizeUniform = variant.renderSizeUniform;
+}
+
+void GSPlyObj::PreprocessSplats(GLuint indexBuffer)
+{
+	PROFILE_SCOPE("Splat Preprocess");
+	int shDegree = std::clamp(m_sphericalHarmonicsDegree, 0, SH_DEGREE_COUNT - 1);
+	PreprocessVariant& variant = m_preprocessVariants[shDegree];
+	if (!variant.program) {
+		variant.program = std::make_shared<ComputeShader>(PLY_PREPROCESS_SHADER, ShaderDefines{ std::format("SH_DEGREE {}", shDegree) });
+		variant.textureUniform = variant.program->GetUniformHandle("u_texture");
+		variant.splatCountUniform = variant.program->GetUniformHandle("splatCount");
+		variant.fixedExtentUniform = variant.program->GetUniformHandle("fixedExtent");
+	}
+	variant.program->Use();
+	variant.program->SetInt(variant.textureUniform, m_textureIdx);
+	variant.program->SetUInt(variant.splatCountUniform, m_drawCount);
+	variant.program->SetBool(variant.fixedExtentUniform, !m_opacityAwareExtent);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, indexBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, m_recordBuffer);
+
+	const uint32_t LOCAL_SIZE = 256;
+	glDispatchCompute((m_drawCount + LOCAL_SIZE - 1) / LOCAL_SIZE, 1, 1);
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+bool GSPlyObj::BeginFragmentCount()
+{
+	static const bool SUPPORTED = []() {
+		GLint major = 0, minor = 0, extensionCount = 0;
+		glGetIntegerv(GL_MAJOR_VERSION, &major);
+		glGetIntegerv(GL_MINOR_VERSION, &minor);
+		glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+		bool hasStatistics = major > 4 || (major == 4 && minor >= 6);
+		for (GLint i = 0; i < extensionCount && !hasStatistics; i++) {
+			const char* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+			hasStatistics = extension && std::strcmp(extension, "GL_ARB_pipeline_statistics_query") == 0;
+		}
+		if (!hasStatistics)
+			std::cerr << "Counting shaded fragments needs GL 4.6 or GL_ARB_pipeline_statistics_query" << std::endl;
+		return hasStatistics;
+		}();
+	if (!m_countFragments || !SUPPORTED)
+		return false;
+	if (m_fragmentQueries[0] == 0)
+		glGenQueries(FRAGMENT_QUERY_COUNT, m_fragmentQueries);
+
+	// the query issued FRAGMENT_QUERY_COUNT draws ago is read back before it is reused, a result
+	// that is not available yet skips this frame's count rather than stalling
+	size_t index = m_fragmentQueryIndex;
+	if (m_fragmentQueryIssued[index]) {
+		GLuint64 available = 0;
+		glGetQueryObjectui64v(m_fragmentQueries[index], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available)
+			return false;
+		GLuint64 fragments = 0;
+		glGetQueryObjectui64v(m_fragmentQueries[index], GL_QUERY_RESULT, &fragments);
+		m_shadedFragments[m_fragmentQueryOpacityAware[index] ? 1 : 0] = fragments;
+	}
+	glBeginQuery(GL_FRAGMENT_SHADER_INVOCATIONS_ARB, m_fragmentQueries[index]);
+	m_fragmentQueryIssued[index] = true;
+	m_fragmentQueryOpacityAware[index] = m_opacityAwareExtent;
+	m_fragmentQueryIndex = (index + 1) % FRAGMENT_QUERY_COUNT;
+	return true;
+}
+
+void GSPlyObj::ExportSplats(std::vector<GSCpuRasterizer::Splat>& splats) const
+{
+	splats.resize(m_subsetActive ? m_drawCount : m_vertexCount);
+	for (size_t i = 0; i < splats.size(); i++) {
+		size_t slot = m_subsetActive ? m_drawSlots[i] : i;
+		// the layout written by GenerateTextureData
+		const float* data = reinterpret_cast<const float*>(&m_textureData[m_vertexLength * slot]);
+		GSCpuRasterizer::Splat& splat = splats[i];
+		splat.position = glm::vec3(data[0], data[1], data[2]);
+		std::copy_n(data + 4, 6, splat.covariance);
+		splat.opacity = data[11];
+		std::copy_n(data + 12, 48, &splat.sh[0].x);
+	}
+}
+
+void GSPlyObj::RenderCpuReference(const FrameContext& frame)
+{
+	PROFILE_CPU_SCOPE("CPU Reference");
+	if (!m_cpuRasterizer)
+		m_cpuRasterizer = std::make_shared<GSCpuRasterizer>();
+	std::vector<GSCpuRasterizer::Splat> splats;
+	ExportSplats(splats);
+	GSCpuRasterizer::Image reference;
+	glm::ivec2 renderSize = m_fbo->GetRenderSize();
+	m_cpuRasterizer->Render(splats, GetShDegree(), frame, renderSize, reference);
+	const char* REFERENCE_PATH = "gs_cpu_reference.png";
+	if (!reference.WritePng(REFERENCE_PATH))
+		std::cerr << std::format("Failed to write {}", REFERENCE_PATH) << std::endl;
+
+	GSCpuRasterizer::Image gpu;
+	ReadSplatImage(gpu);
+	std::cout << std::format("CPU reference: {} splats in {:.1f} ms, max difference to the {} backend {:.5f}",
+		splats.size(), m_cpuRasterizer->GetLastRenderMs(), m_backend == TILE_COMPUTE ? "tile compute" : "hardware blend",
+		GSCpuRasterizer::Image::MaxDifference(reference, gpu)) << std::endl;
+}
+
+void GSPlyObj::ReadSplatImage(GSCpuRasterizer::Image& image)
+{
+	// the splat framebuffer is allocated at screen size, the frame covers its lower left renderSize pixels
+	glm::ivec2 renderSize = m_fbo->GetRenderSize();
+	glm::ivec2 fboSize = m_fbo->GetFboSize();
+	std::vector<glm::vec4> pixels(static_cast<size_t>(fboSize.x) * fboSize.y);
+	// through the cache, a raw bind or unbind would leave it believing the old texture is still bound
+	GLStateCache::GetInstance()->BindTexture(GL_TEXTURE_2D, m_fbo->GetColorTexture());
+	glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_FLOAT, pixels.data());
+	image.width = renderSize.x;
+	image.height = renderSize.y;
+	image.pixels.resize(static_cast<size_t>(renderSize.x) * renderSize.y);
+	for (int y = 0; y < renderSize.y; y++) {
+		std::copy_n(&pixels[static_cast<size_t>(y) * fboSize.x], renderSize.x, &image.pixels[static_cast<size_t>(y) * renderSize.x]);
+	}
+}
+
+void GSPlyObj::CheckResolutionScale()
+{
+	const float SCALES[2] = { 1.0f, 0.5f };
+	GSCpuRasterizer::Image images[2];
+	float scale = m_fbo->GetResolutionScale();
+	// PrepareDraw clears with the colour set before it, both passes have to start from the same one
+	glm::vec4 clearColor{ 0.0f };
+	glGetFloatv(GL_COLOR_CLEAR_VALUE, &clearColor.x);
+	for (int i = 0; i < 2; i++) {
+		glClearColor(clearColor.r, clearColor.g, clearColor.b, clearColor.a);
+		m_fbo->SetResolutionScale(SCALES[i]);
+		m_fbo->PrepareDraw();
+		DrawSplats();
+		ReadSplatImage(images[i]);
+		m_fbo->BindTarget();
+	}
+	m_fbo->SetResolutionScale(scale);
+	// a half resolution pixel centre lies between four full resolution ones, only splats thinner than a pixel
+	// should differ, a splat evaluated at the wrong position shows up as a difference close to 1
+	GSCpuRasterizer::Image full = images[0].Resample(images[1].width, images[1].height);
+	std::cout << std::format("Resolution scale check: {} x {} against {} x {}, max difference {:.5f}, mean difference {:.5f}",
+		images[1].width, images[1].height, images[0].width, images[0].height,
+		GSCpuRasterizer::Image::MaxDifference(full, images[1]), GSCpuRasterizer::Image::MeanDifference(full, images[1])) << std::endl;
+}
+
+void GSPlyObj::BuildLodHierarchy()
+{
+	std::vector<GSLodHierarchy::Gaussian> gaussians(m_vertexCount);
+	for (uint32_t i = 0; i < m_vertexCount; i++) {
+		auto& vertex = m_vertices[m_indices[i]];
+		std::vector<float> sigmas;
+		GetSigmaFloat32(vertex.rotation, vertex.scale, sigmas);
+		gaussians[i].position = glm::vec3(vertex.position);
+		gaussians[i].opacity = vertex.opacity;
+		std::copy_n(sigmas.data(), 6, gaussians[i].covariance);
+	}
+
+	// merged gaussians are appended so that slot, vertex and index stay identical
+	const size_t shCount = (std::max)(m_header.verticePropertiesOffset["shs"].second / sizeof(float), static_cast<size_t>(3));
+	const uint32_t mergedCount = GSLodHierarchy::CountMergedNodes(m_vertexCount);
+	m_vertices.reserve(m_vertexCount + mergedCount);
+	m_indices.reserve(m_vertexCount + mergedCount);
+	gaussians.reserve(m_vertexCount + mergedCount);
+	m_lod = std::make_shared<GSLodHierarchy>();
+	m_lod->Build(gaussians, [&](uint32_t slot, const std::vector<uint32_t>& children, const std::vector<float>& weights) {
+		PlyVertex3 merged{};
+		merged.position = glm::vec4(gaussians[slot].position, 1.0f);
+		merged.opacity = gaussians[slot].opacity;
+		// stored like the leaves, so everything reading scale and rotation sees the merged covariance
+		GetScaleRotation(gaussians[slot].covariance, merged.scale, merged.rotation);
+		for (size_t i = 0; i < children.size(); i++) {
+			const auto& child = m_vertices[m_indices[children[i]]];
+			for (size_t j = 0; j < shCount; j++) {
+				merged.shs[j] += weights[i] * child.shs[j];
+			}
+		}
+		m_vertices.push_back(merged);
+		m_indices.push_back(static_cast<uint32_t>(m_vertices.size() - 1));
+	});
+
+	m_textureHeight = std::ceil((2.0f * m_indices.size()) / m_textureWidth) * 8;
+	m_textureData.resize(m_textureWidth * m_textureHeight * 4);
+	std::cout << std::format("LOD hierarchy: {} splats, {} merged nodes, depth {}",
+		m_lod->GetLeafCount(), m_lod->GetNodeCount() - m_lod->GetLeafCount(), m_lod->GetDepth()) << std::endl;
 }
 
 void GSPlyObj::LoadModelHeader(std::ifstream& file, PlyHeader& header)
@@ -325,7 +820,7 @@ void GSPlyObj::LoadVertices(std::ifstream& file)
 
 void GSPlyObj::GenerateTextureData()
 {
-	for (size_t i = 0; i < m_vertexCount; i++) {
+	for (size_t i = 0; i < m_indices.size(); i++) {
 		size_t idx = m_indices[i];
 		glm::vec3 pos = m_vertices[idx].position;
 		glm::vec3* sh = reinterpret_cast<glm::vec3*>(&m_vertices[idx].shs);
@@ -386,9 +881,31 @@ void GSPlyObj::SetUpFbo(const char* vertexShader, const char* fragmentShader)
 	m_fbo = std::make_shared<GSFrameBufferObj>(vertexShader, fragmentShader);
 }
 
+void Base3DGSObj::LoadConfig(std::shared_ptr<Parser::RenderObjConfigBase> baseConfigPtr)
+{
+	m_config = std::static_pointer_cast<Parser::RenderObjConfig3DGS>(baseConfigPtr);
+}
+
 void Base3DGSObj::SetUpShader(const char* vertexShader, const char* fragmentShader)
 {
 	m_shader = std::make_shared<Shader>(vertexShader, fragmentShader);
+	m_textureUniform = m_shader->GetUniformHandle("u_texture");
+}
+
+void Base3DGSObj::PrefetchPrograms(const std::vector<ShaderDefines>& variants)
+{
+	std::vector<ProgramStages> programs{
+		{ { GL_COMPUTE_SHADER, PRESORT_SHADER } },
+		{ { GL_COMPUTE_SHADER, SINGLE_RADIX_SORT_SHADER } },
+		{ { GL_COMPUTE_SHADER, MULTI_RADIX_SORT_SHADER, GetRadixSortDefines() } },
+		{ { GL_COMPUTE_SHADER, MULTI_RADIX_SORT_HISTOGRAM_SHADER } },
+	};
+	for (const auto& defines : variants) {
+		programs.push_back({ { GL_VERTEX_SHADER, m_config->vertexShader, defines }, { GL_FRAGMENT_SHADER, m_config->fragmentShader, defines } });
+	}
+	if (!m_config->fboVertexShader.empty())
+		programs.push_back({ { GL_VERTEX_SHADER, m_config->fboVertexShader }, { GL_FRAGMENT_SHADER, m_config->fboFragmentShader } });
+	ProgramCache::GetInstance()->Prefetch(programs);
 }
 
 void Base3DGSObj::GenerateTexture()
@@ -424,16 +941,22 @@ void Base3DGSObj::SetUpData()
 
 void Base3DGSObj::Draw()
 {
-	glDrawArraysInstanced(GL_TRIANGLE_FAN, 0, 4, m_vertexCount);
+	Draw(m_vertexCount);
+}
+
+void Base3DGSObj::Draw(uint32_t instanceCount)
+{
+	glDrawArraysInstanced(GL_TRIANGLE_FAN, 0, 4, instanceCount);
 }
 
 void Base3DGSObj::SetUpGLStatus()
 {
-	glEnable(GL_BLEND);
-	glEnable(GL_STENCIL_TEST);
-	glDisable(GL_DEPTH_TEST);
-	glBlendEquationSeparate(GL_FUNC_ADD, GL_FUNC_ADD);
-	glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+	auto glState = GLStateCache::GetInstance();
+	glState->Enable(GL_BLEND);
+	glState->Enable(GL_STENCIL_TEST);
+	glState->Disable(GL_DEPTH_TEST);
+	glState->BlendEquationSeparate(GL_FUNC_ADD, GL_FUNC_ADD);
+	glState->BlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
 }
 
 void Base3DGSObj::SetUpAttribute()
@@ -447,6 +970,14 @@ void Base3DGSObj::SetUpAttribute()
 	m_textureData.resize(m_textureWidth * m_textureHeight * 4);
 }
 
+size_t Base3DGSObj::GetMemoryUsage() const
+{
+	// cpu side arrays, plus the gaussian texture and the depth index buffer they are uploaded to
+	size_t cpuBytes = (m_depthIndex.size() + m_indices.size() + m_textureData.size()) * sizeof(uint32_t);
+	size_t gpuBytes = (m_textureData.size() + m_depthIndex.size()) * sizeof(uint32_t);
+	return cpuBytes + gpuBytes;
+}
+
 void Base3DGSObj::ImGuiCallback()
 {
 	static bool isFolded = true;
@@ -463,12 +994,52 @@ void Base3DGSObj::ImGuiCallback()
 
 GSSplatObj::GSSplatObj(std::shared_ptr<Parser::RenderObjConfigBase> baseConfigPtr)
 {
-	auto configPtr = std::static_pointer_cast<Parser::RenderObjConfig3DGS>(baseConfigPtr);
-	SetUpShader(configPtr->vertexShader.c_str(), configPtr->fragmentShader.c_str());
-	std::ifstream file(configPtr->modelPath, std::ios::binary);
+	LoadConfig(baseConfigPtr);
+}
+
+void GSSplatObj::LoadData()
+{
+	std::ifstream file(m_config->modelPath, std::ios::binary);
 	GetVertexCount(file);
 	SetUpAttribute();
 	LoadVertices(file);
+}
+
+size_t GSSplatObj::GetMemoryUsage() const
+{
+	return Base3DGSObj::GetMemoryUsage() + m_vertices.size() * sizeof(SplatVertex);
+}
+
+void GSSplatObj::ExportSplats(std::vector<GSCpuRasterizer::Splat>& splats) const
+{
+	splats.resize(m_vertexCount);
+	for (size_t i = 0; i < splats.size(); i++) {
+		const SplatVertex& vertex = m_vertices[i];
+		// the covariance of GetSigmaHalf2x16 before it is packed to halves
+		std::vector<double> rotation(4);
+		for (size_t j = 0; j < 4; j++) {
+			rotation[j] = (static_cast<double>(vertex.rotation[j]) - 128.0) / 128.0;
+		}
+		std::vector<double> scale{ vertex.scale.x, vertex.scale.y, vertex.scale.z };
+		std::vector<double> sigma(6);
+		GetSigma(scale, rotation, sigma);
+
+		GSCpuRasterizer::Splat& splat = splats[i];
+		splat = GSCpuRasterizer::Splat{};
+		splat.position = vertex.position;
+		for (size_t j = 0; j < 6; j++) {
+			splat.covariance[j] = static_cast<float>(sigma[j]);
+		}
+		// the stored colour is the evaluated base band, the rasterizer adds the 0.5 offset back
+		splat.sh[0] = glm::vec3(vertex.shs[0], vertex.shs[1], vertex.shs[2]) / 255.0f - 0.5f;
+		splat.opacity = vertex.shs[3] / 255.0f;
+	}
+}
+
+void GSSplatObj::SetUpGL()
+{
+	PrefetchPrograms();
+	SetUpShader(m_config->vertexShader.c_str(), m_config->fragmentShader.c_str());
 	GenerateTexture();
 	SetUpData();
 }
@@ -479,7 +1050,7 @@ void GSSplatObj::LoadVertices(std::ifstream& file)
 	file.seekg(0, std::ios::beg);
 	m_vertices.resize(m_vertexCount);
 	for (size_t i = 0; i < m_vertexCount; i++) {
-		assert(file.is_open(), "");
+		assert(file.is_open());
 		file.read(reinterpret_cast<char*>(&m_vertices[i]), sizeof(SplatVertex));
 		std::vector<uint32_t> sigmasHalf2x16;
 		GetSigmaHalf2x16(m_vertices[i], sigmasHalf2x16);
@@ -491,27 +1062,18 @@ void GSSplatObj::LoadVertices(std::ifstream& file)
 }
 
 
-void GSSplatObj::DrawObj(const std::unordered_map<std::string, std::any>& uniform)
+void GSSplatObj::DrawObj(const FrameContext& /*frame*/)
 {
-	glm::mat4 projection = std::any_cast<glm::mat4>(uniform.at("perspective_projection"));
-	glm::mat4 view = std::any_cast<glm::mat4>(uniform.at("view"));
-	glm::mat4 model = std::any_cast<glm::mat4>(uniform.at("model"));
-	glm::vec2 focal = std::any_cast<glm::vec2>(uniform.at("focal"));
-	glm::vec2 viewport = std::any_cast<glm::vec2>(uniform.at("viewport"));
-	glm::vec2 nearFar = std::any_cast<glm::vec2>(uniform.at("nearFar"));
 	SetUpGLStatus();
 	RunSortUpdateDepth();
 	m_shader->Use();
 	m_renderVAO->Bind();
 	m_gaussian_texture->BindTexture(m_textureIdx);
-	m_shader->SetMat4("projection", projection);
-	m_shader->SetMat4("view", view);
-	m_shader->SetMat4("model", model);
-	m_shader->SetVec2("focal", focal);
-	m_shader->SetVec2("viewport", viewport);
-	m_shader->SetVec2("nearFar", nearFar);
-	m_shader->SetInt("u_texture", m_textureIdx);
-	Draw();
+	m_shader->SetInt(m_textureUniform, m_textureIdx);
+	{
+		PROFILE_SCOPE("Splat Draw");
+		Draw();
+	}
 	m_renderVAO->Unbind();
 }
 
@@ -549,6 +1111,7 @@ void GSSplatObj::ImGuiCallback()
 
 void GSSplatObj::RunSortUpdateDepth()
 {
+	PROFILE_CPU_SCOPE("Sort");
 	m_sorter->Sort(m_vertices, m_indices, m_depthIndex, m_depthIndexVBO);
 }
 
@@ -10,7 +10,12 @@
 #include "../draw/vertexbuffer.h"
 #include "../draw/camera.h"
 #include "./gs_framebuffer_obj.h"
+#include "./gs_lod.h"
+#include "./gs_quality.h"
+#include "./gs_tile_raster.h"
+#include "./gs_cpu_raster.h"
 #include "../draw/shader_c.h"
+#include "../utils/profiler.h"
 RENDERABLE_BEGIN
 enum SORT_ORDER : uint32_t
 {
@@ -26,12 +31,36 @@ enum SORT_METHOD : uint32_t
 	GPU_SINGLE_RADIX_SORT,
 	GPU_MULTI_RADIX_SORT
 };
+
+enum SPLAT_BACKEND : uint32_t
+{
+	HARDWARE_BLEND,  // one alpha blended quad per splat
+	TILE_COMPUTE     // GSTileRasterizer
+};
+
+constexpr const char* PRESORT_SHADER = "./shader/presort_comp.glsl";
+constexpr const char* SINGLE_RADIX_SORT_SHADER = "./shader/single_radixsort_comp.glsl";
+constexpr const char* MULTI_RADIX_SORT_SHADER = "./shader/multi_radixsort_comp.glsl";
+constexpr const char* MULTI_RADIX_SORT_HISTOGRAM_SHADER = "./shader/multi_radixsort_histograms_comp.glsl";
+constexpr const char* PLY_PREPROCESS_SHADER = "./shader/gs_ply_preprocess_comp.glsl";
+constexpr const char* PLY_EXPAND_VERTEX_SHADER = "./shader/gs_ply_expand_vs.glsl";
+
+// defines of MULTI_RADIX_SORT_SHADER for this context, it falls back to a shared memory scan
+// when compute shaders lack subgroups of at least SUBGROUP_SIZE invocations
+const ShaderDefines& GetRadixSortDefines();
+
 template <typename T>
 class BaseSorter {
 public:
 	BaseSorter() {}
 	BaseSorter(uint32_t vertexCount, SORT_ORDER sortOrder) :m_vertexCount(vertexCount), m_sortOrder(sortOrder) {}
+	// the CPU sorters upload the first GetVertexCount entries of depthIndex to vbo, orphaning the rest of it
 	virtual void Sort(const std::vector<T>& vertices, const std::vector<uint32_t>& indices, std::vector<uint32_t>& depthIndex, std::shared_ptr<VertexBufferObject> vbo) = 0;
+	// number of leading entries of indices taken into account by the next Sort
+	virtual void SetVertexCount(uint32_t vertexCount) { m_vertexCount = vertexCount; }
+	uint32_t GetVertexCount() const { return m_vertexCount; }
+	// shader storage buffer with the sorted indices of the last Sort, 0 when they only reach the vbo passed to Sort
+	virtual GLuint GetIndexBuffer() const { return 0; }
 
 protected:
 	uint32_t m_vertexCount = 0;
@@ -46,8 +75,12 @@ public:
 	{
 		this->m_vertexCount = vertexCount;
 		this->m_sortOrder = sortOrder;
-		m_preSortProg = std::make_shared<ComputeShader>("./shader/presort_comp.glsl");
-		m_sortProg = std::make_shared<ComputeShader>("./shader/single_radixsort_comp.glsl");
+		m_preSortProg = std::make_shared<ComputeShader>(PRESORT_SHADER);
+		m_sortProg = std::make_shared<ComputeShader>(SINGLE_RADIX_SORT_SHADER);
+		m_modelViewProjUniform = m_preSortProg->GetUniformHandle("modelViewProj");
+		m_nearFarUniform = m_preSortProg->GetUniformHandle("nearFar");
+		m_keyMaxUniform = m_preSortProg->GetUniformHandle("keyMax");
+		m_numElementsUniform = m_sortProg->GetUniformHandle("g_num_elements");
 	}
 	void Sort(const std::vector<T>& vertices, const std::vector<uint32_t>& indices, std::vector<uint32_t>& depthIndex, std::shared_ptr<VertexBufferObject> vbo)
 	{
@@ -57,15 +90,16 @@ public:
 		}
 
 		{ // presort
+			PROFILE_SCOPE("GPU Presort");
 			const uint32_t MAX_DEPTH = UINT32_MAX;
 			auto instance = Camera::GetInstance();
 			glm::vec2 nearFar = glm::vec2(instance->GetNear(), instance->GetFar());
 			glm::mat4 modelViewProjMatrix = instance->GetProjMat() * instance->GetViewMat();
 
 			m_preSortProg->Use();
-			m_preSortProg->SetMat4("modelViewProj", modelViewProjMatrix);
-			m_preSortProg->SetVec2("nearFar", nearFar);
-			m_preSortProg->SetUInt("keyMax", MAX_DEPTH);
+			m_preSortProg->SetMat4(m_modelViewProjUniform, modelViewProjMatrix);
+			m_preSortProg->SetVec2(m_nearFarUniform, nearFar);
+			m_preSortProg->SetUInt(m_keyMaxUniform, MAX_DEPTH);
 
 			// reset counter back to zero
 			m_atomicCounterVec[0] = 0;
@@ -87,8 +121,9 @@ public:
 		}
 
 		{  // singleSort
+			PROFILE_SCOPE("GPU Radix Sort");
 			m_sortProg->Use();
-			m_sortProg->SetUInt("g_num_elements", m_atomicCounterVec[0]);
+			m_sortProg->SetUInt(m_numElementsUniform, m_atomicCounterVec[0]);
 			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_keyBuffer->GetObj());
 			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, m_keyBuffer2->GetObj());
 			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, m_valBuffer->GetObj());
@@ -98,13 +133,15 @@ public:
 			glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
 		}
 
-		{
+		if (vbo) {
+			PROFILE_SCOPE("Index Upload");
 			glBindBuffer(GL_COPY_READ_BUFFER, m_valBuffer2->GetObj());
 			glBindBuffer(GL_COPY_WRITE_BUFFER, vbo->GetObj());
 			glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, this->m_vertexCount * sizeof(uint32_t));
 			glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
 		}
 	}
+	GLuint GetIndexBuffer() const override { return m_valBuffer2 ? m_valBuffer2->GetObj() : 0; }
 
 private:
 	void InitBuffer(const std::vector<T>& vertices, const std::vector<uint32_t>& indices)
@@ -129,6 +166,7 @@ private:
 
 	std::shared_ptr<ComputeShader> m_preSortProg = nullptr;
 	std::shared_ptr<ComputeShader> m_sortProg = nullptr;
+	UniformHandle m_modelViewProjUniform{}, m_nearFarUniform{}, m_keyMaxUniform{}, m_numElementsUniform{};
 	std::shared_ptr<VertexBufferObject> m_keyBuffer = nullptr;
 	std::shared_ptr<VertexBufferObject> m_keyBuffer2 = nullptr;
 	std::shared_ptr<VertexBufferObject> m_valBuffer = nullptr;
@@ -151,9 +189,16 @@ public:
 	{
 		this->m_vertexCount = vertexCount;
 		this->m_sortOrder = sortOrder;
-		m_preSortProg = std::make_shared<ComputeShader>("./shader/presort_comp.glsl");
-		m_sortProg = std::make_shared<ComputeShader>("./shader/multi_radixsort_comp.glsl");
-		m_histogramProg = std::make_shared<ComputeShader>("shader/multi_radixsort_histograms_comp.glsl");
+		m_preSortProg = std::make_shared<ComputeShader>(PRESORT_SHADER);
+		m_sortProg = std::make_shared<ComputeShader>(MULTI_RADIX_SORT_SHADER, GetRadixSortDefines());
+		m_histogramProg = std::make_shared<ComputeShader>(MULTI_RADIX_SORT_HISTOGRAM_SHADER);
+		m_modelViewProjUniform = m_preSortProg->GetUniformHandle("modelViewProj");
+		m_nearFarUniform = m_preSortProg->GetUniformHandle("nearFar");
+		m_keyMaxUniform = m_preSortProg->GetUniformHandle("keyMax");
+		m_sortUniforms = { m_sortProg->GetUniformHandle("g_num_elements"), m_sortProg->GetUniformHandle("g_num_workgroups"),
+			m_sortProg->GetUniformHandle("g_num_blocks_per_workgroup"), m_sortProg->GetUniformHandle("g_shift") };
+		m_histogramUniforms = { m_histogramProg->GetUniformHandle("g_num_elements"), UniformHandle{},
+			m_histogramProg->GetUniformHandle("g_num_blocks_per_workgroup"), m_histogramProg->GetUniformHandle("g_shift") };
 	}
 	void Sort(const std::vector<T>& vertices, const std::vector<uint32_t>& indices, std::vector<uint32_t>& depthIndex, std::shared_ptr<VertexBufferObject> vbo)
 	{
@@ -163,15 +208,16 @@ public:
 		}
 
 		{ // presort
+			PROFILE_SCOPE("GPU Presort");
 			const uint32_t MAX_DEPTH = UINT32_MAX;
 			auto instance = Camera::GetInstance();
 			glm::vec2 nearFar = glm::vec2(instance->GetNear(), instance->GetFar());
 			glm::mat4 modelViewProjMatrix = instance->GetProjMat() * instance->GetViewMat();
 
 			m_preSortProg->Use();
-			m_preSortProg->SetMat4("modelViewProj", modelViewProjMatrix);
-			m_preSortProg->SetVec2("nearFar", nearFar);
-			m_preSortProg->SetUInt("keyMax", MAX_DEPTH);
+			m_preSortProg->SetMat4(m_modelViewProjUniform, modelViewProjMatrix);
+			m_preSortProg->SetVec2(m_nearFarUniform, nearFar);
+			m_preSortProg->SetUInt(m_keyMaxUniform, MAX_DEPTH);
 
 			// reset counter back to zero
 			m_atomicCounterVec[0] = 0;
@@ -193,22 +239,23 @@ public:
 		}
 
 		{  // multi-pass sort
+			PROFILE_SCOPE("GPU Radix Sort");
 			const uint32_t NUM_ELEMENTS = static_cast<uint32_t>(m_atomicCounterVec[0]);
 			const uint32_t NUM_WORKGROUPS = (NUM_ELEMENTS + m_numBlocksPerWorkgroup - 1) / m_numBlocksPerWorkgroup;
 			const uint32_t NUM_BYTES = 4;
 			m_sortProg->Use();
-			m_sortProg->SetUInt("g_num_elements", NUM_ELEMENTS);
-			m_sortProg->SetUInt("g_num_workgroups", NUM_WORKGROUPS);
-			m_sortProg->SetUInt("g_num_blocks_per_workgroup", m_numBlocksPerWorkgroup);
+			m_sortProg->SetUInt(m_sortUniforms.numElements, NUM_ELEMENTS);
+			m_sortProg->SetUInt(m_sortUniforms.numWorkgroups, NUM_WORKGROUPS);
+			m_sortProg->SetUInt(m_sortUniforms.numBlocksPerWorkgroup, m_numBlocksPerWorkgroup);
 
 			m_histogramProg->Use();
-			m_histogramProg->SetUInt("g_num_elements", NUM_ELEMENTS);
-			m_histogramProg->SetUInt("g_num_blocks_per_workgroup", m_numBlocksPerWorkgroup);
+			m_histogramProg->SetUInt(m_histogramUniforms.numElements, NUM_ELEMENTS);
+			m_histogramProg->SetUInt(m_histogramUniforms.numBlocksPerWorkgroup, m_numBlocksPerWorkgroup);
 
 			for (uint32_t i = 0; i < NUM_BYTES; i++)
 			{
 				m_histogramProg->Use();
-				m_histogramProg->SetUInt("g_shift", 8 * i);
+				m_histogramProg->SetUInt(m_histogramUniforms.shift, 8 * i);
 
 				if (i == 0 || i == 2)
 				{
@@ -225,7 +272,7 @@ public:
 				glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
 
 				m_sortProg->Use();
-				m_sortProg->SetUInt("g_shift", 8 * i);
+				m_sortProg->SetUInt(m_sortUniforms.shift, 8 * i);
 
 				if ((i % 2) == 0)  // even
 				{
@@ -249,13 +296,16 @@ public:
 			}
 		}
 
-		{
+		if (vbo) {
+			PROFILE_SCOPE("Index Upload");
 			glBindBuffer(GL_COPY_READ_BUFFER, m_valBuffer->GetObj());
 			glBindBuffer(GL_COPY_WRITE_BUFFER, vbo->GetObj());
 			glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, this->m_vertexCount * sizeof(uint32_t));
 			glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
 		}
 	}
+	// the passes ping-pong between the value buffers, after the four 8 bit passes the result is back in the first
+	GLuint GetIndexBuffer() const override { return m_valBuffer ? m_valBuffer->GetObj() : 0; }
 private:
 	void InitBuffer(const std::vector<T>& vertices, const std::vector<uint32_t>& indices)
 	{
@@ -283,6 +333,14 @@ private:
 	std::shared_ptr<ComputeShader> m_preSortProg = nullptr;
 	std::shared_ptr<ComputeShader> m_sortProg = nullptr;
 	std::shared_ptr<ComputeShader> m_histogramProg = nullptr;
+	struct RadixPassUniforms {
+		UniformHandle numElements{};
+		UniformHandle numWorkgroups{};
+		UniformHandle numBlocksPerWorkgroup{};
+		UniformHandle shift{};
+	};
+	UniformHandle m_modelViewProjUniform{}, m_nearFarUniform{}, m_keyMaxUniform{};
+	RadixPassUniforms m_sortUniforms{}, m_histogramUniforms{};
 	std::shared_ptr<VertexBufferObject> m_keyBuffer = nullptr;
 	std::shared_ptr<VertexBufferObject> m_keyBuffer2 = nullptr;
 	std::shared_ptr<VertexBufferObject> m_valBuffer = nullptr;
@@ -315,6 +373,7 @@ class RadixSortCPU : public BaseSorter<T>
 public:
 	RadixSortCPU(uint32_t vertexCount, SORT_ORDER sortOrder);
 	void Sort(const std::vector<T>& vertices, const std::vector<uint32_t>& indices, std::vector<uint32_t>& depthIndex, std::shared_ptr<VertexBufferObject> vbo) override;
+	void SetVertexCount(uint32_t vertexCount) override;
 
 private:
 	const uint32_t m_bit = 32;
@@ -357,6 +416,14 @@ public:
 	glm::vec2 GetTanFov() { return glm::vec2(m_width / m_fx * 0.5f, m_height / m_fy * 0.5f); }
 	glm::vec2 GetNearFar() { return glm::vec2(m_near, m_far); }
 	const glm::mat4& GetProjection() const { return m_projection; }
+	void SetIntrinsics(float fx, float fy, float width, float height)
+	{
+		m_fx = fx;
+		m_fy = fy;
+		m_width = width;
+		m_height = height;
+		SetProjection();
+	}
 
 private:
 	float m_fy = 1164.66f;  // focal_y
@@ -381,6 +448,11 @@ private:
 
 class Base3DGSObj : public RenderObjectBase
 {
+public:
+	// the splats as the software rasterizer takes them, only needs LoadData so it works without a GL context
+	virtual void ExportSplats(std::vector<GSCpuRasterizer::Splat>& splats) const = 0;
+	virtual int GetShDegree() const { return 0; }
+
 protected:
 	enum MODEL_TYPE : uint32_t
 	{
@@ -388,13 +460,19 @@ protected:
 		PLY
 	};
 	void SetUpShader(const char* vertexShader, const char* fragmentShader);
+	// starts compiling every program the object may use, one per variant of the draw program and the
+	// GPU sorters, so they build concurrently
+	void PrefetchPrograms(const std::vector<ShaderDefines>& variants = { {} });
+	void LoadConfig(std::shared_ptr<Parser::RenderObjConfigBase> baseConfigPtr);
 	virtual void GenerateTexture();
 	virtual void SetUpData();
 	virtual void SetUpGLStatus();
 	void SetUpAttribute();
 	template <typename T> void PresortIndices(std::vector<T>& vertices);
 	void ImGuiCallback() override;
+	size_t GetMemoryUsage() const override;
 	void Draw();
+	void Draw(uint32_t instanceCount);
 
 protected:
 	uint32_t m_vertexCount = 0, m_vertexLength = 0;
@@ -406,7 +484,9 @@ protected:
 	std::vector<uint32_t> m_depthIndex{};
 	std::vector<uint32_t> m_textureData{};
 	std::vector<uint32_t> m_indices{};
+	std::shared_ptr<Parser::RenderObjConfig3DGS> m_config = nullptr;
 	std::shared_ptr<Shader> m_shader = nullptr;
+	UniformHandle m_textureUniform{};
 	std::shared_ptr<Texture> m_gaussian_texture = nullptr;
 	std::shared_ptr<VertexArrayObject> m_renderVAO = nullptr;
 	std::shared_ptr<VertexBufferObject> m_rectangleVBO = nullptr;
@@ -421,8 +501,15 @@ private:
 class GSPlyObj : public Base3DGSObj {
 public:
 	GSPlyObj(std::shared_ptr<Parser::RenderObjConfigBase> baseConfigPtr);
-	void DrawObj(const std::unordered_map<std::string, std::any>& uniform);
+	~GSPlyObj();
+	void LoadData() override;
+	void SetUpGL() override;
+	void DrawObj(const FrameContext& frame);
 	void ImGuiCallback() override;
+	size_t GetMemoryUsage() const override;
+	// the splats of the last cut or budget, decoded from the splat texture
+	void ExportSplats(std::vector<GSCpuRasterizer::Splat>& splats) const override;
+	int GetShDegree() const override { return std::clamp(m_sphericalHarmonicsDegree, 0, SH_DEGREE_COUNT - 1); }
 
 private:
 	struct PlyProperty {
@@ -491,14 +578,82 @@ private:
 	void SetUpAttribute();
 	void RunSortUpdateDepth();
 	void SetUpFbo(const char* vertexShader, const char* fragmentShader);
+	void BuildLodHierarchy();
+	void ComputeImportance();
+	void UpdateQuality();
+	static ShaderDefines GetVariantDefines(int shDegree, bool gpuSort);
+	// points m_shader at the program specialized for the current SH degree and index source
+	void SelectShaderVariant(bool gpuSort);
+	// projects the drawn splats once each into m_recordBuffer, indexBuffer holds their texture slots in draw order
+	void PreprocessSplats(GLuint indexBuffer);
+	// sorts and draws the splats into the prepared splat framebuffer with the selected backend
+	void DrawSplats();
+	// copies the renderSize pixels of the splat framebuffer
+	void ReadSplatImage(GSCpuRasterizer::Image& image);
+	// renders the splats at resolution scale 1 and 0.5 and compares the half image with the full one resampled
+	void CheckResolutionScale();
+	// renders the frame again with GSCpuRasterizer, writes it to png and compares it with the splat framebuffer
+	void RenderCpuReference(const FrameContext& frame);
+	// starts counting the fragments of the splat draw when enabled, returns whether a query was begun
+	bool BeginFragmentCount();
 
 private:
+	struct ShaderVariant {
+		std::shared_ptr<Shader> shader = nullptr;
+		UniformHandle textureUniform{}, fixedExtentUniform{}, renderSizeUniform{};
+	};
+	struct PreprocessVariant {
+		std::shared_ptr<ComputeShader> program = nullptr;
+		UniformHandle textureUniform{}, splatCountUniform{}, fixedExtentUniform{};
+	};
+	static constexpr size_t FRAGMENT_QUERY_COUNT = 2;
+	static constexpr int SH_DEGREE_COUNT = 4;
+	static constexpr size_t SPLAT_RECORD_SIZE = 4 * sizeof(glm::vec4);  // SplatRecord in gs_splat_record.glsl
+
 	PlyHeader m_header;
 	int m_sphericalHarmonicsDegree = 3;
 	MODEL_TYPE m_type = MODEL_TYPE::PLY;
 	std::vector<PlyVertex3> m_vertices;
 	std::shared_ptr<BaseSorter<PlyVertex3>> m_sorter = nullptr;
 	std::shared_ptr<GSFrameBufferObj> m_fbo = nullptr;
+	std::shared_ptr<GSLodHierarchy> m_lod = nullptr;
+	std::vector<uint32_t> m_drawSlots{};  // LOD cut and/or splat budget, texture slots
+	std::vector<uint32_t> m_drawSlotIndices{};
+	std::vector<float> m_slotImportance{};
+	std::vector<uint32_t> m_importanceOrder{};  // leaf slots, most important first
+	bool m_enableLod = false;
+	bool m_subsetActive = false;
+	float m_lodPixelError = 2.0f;
+	uint32_t m_drawCount = 0;
+	ShaderVariant m_shaderVariants[SH_DEGREE_COUNT][2]{};  // [SH degree][GPU sort]
+	// the vertex shader projects every splat four times, the preprocess pass once
+	bool m_usePreprocess = true;
+	PreprocessVariant m_preprocessVariants[SH_DEGREE_COUNT]{};
+	std::shared_ptr<Shader> m_expandShader = nullptr;
+	UniformHandle m_expandRenderSizeUniform{};
+	// quads end where the splat fades out instead of at 3 sigma, the fixed extent stays for comparison
+	bool m_opacityAwareExtent = true;
+	UniformHandle m_fixedExtentUniform{};
+	UniformHandle m_renderSizeUniform{};
+	// fragment shader invocations of the splat draw, read back a frame late from alternating queries
+	bool m_countFragments = false;
+	GLuint m_fragmentQueries[FRAGMENT_QUERY_COUNT]{};
+	bool m_fragmentQueryIssued[FRAGMENT_QUERY_COUNT]{};
+	bool m_fragmentQueryOpacityAware[FRAGMENT_QUERY_COUNT]{};
+	size_t m_fragmentQueryIndex = 0;
+	uint64_t m_shadedFragments[2]{};  // latest count with the fixed and the opacity aware extent
+	GLuint m_recordBuffer = 0;
+	SPLAT_BACKEND m_backend = HARDWARE_BLEND;
+	std::shared_ptr<GSTileRasterizer> m_tileRasterizer = nullptr;  // created when the backend is first selected
+	std::shared_ptr<GSCpuRasterizer> m_cpuRasterizer = nullptr;
+	bool m_cpuReferenceRequested = false;
+	bool m_scaleCheckRequested = false;
+	GSQualityController m_quality{};
+	bool m_qualityApplied = false;
+	size_t m_qualitySample = 0;  // resolved profiler frame last fed to the controller
+	float m_splatRatio = 1.0f;
+	int m_sortInterval = 1;
+	int m_sortSkip = 0;
 };
 
 template<typename T>
@@ -534,8 +689,13 @@ inline void Base3DGSObj::PresortIndices(std::vector<T>& vertices)
 class GSSplatObj : public Base3DGSObj {
 public:
 	GSSplatObj(std::shared_ptr<Parser::RenderObjConfigBase> baseConfigPtr);
-	void DrawObj(const std::unordered_map<std::string, std::any>& uniform);
+	void LoadData() override;
+	void SetUpGL() override;
+	void DrawObj(const FrameContext& frame);
 	void ImGuiCallback() override;
+	size_t GetMemoryUsage() const override;
+	// .splat files only carry the base colour, the splats have no higher spherical harmonics bands
+	void ExportSplats(std::vector<GSCpuRasterizer::Splat>& splats) const override;
 
 private:
 	struct SplatVertex {
@@ -582,13 +742,16 @@ inline void QuickSortCPU<T>::Sort(const std::vector<T>& vertices, const std::vec
 	m_index2depth.resize(this->m_vertexCount);
 	std::memset(m_index2depth.data(), 0, sizeof(float) * m_index2depth.size());
 
-	for (size_t i = 0; i < this->m_vertexCount; i++) {
-		size_t idx = indices[i];
+	{
+		PROFILE_CPU_SCOPE("Sort Keys");
+		for (size_t i = 0; i < this->m_vertexCount; i++) {
+			size_t idx = indices[i];
 
-		m_index2depth[i] = std::make_pair(i,
-			modelViewProjMatrix[0][2] * vertices[idx].position.x +
-			modelViewProjMatrix[1][2] * vertices[idx].position.y +
-			modelViewProjMatrix[2][2] * vertices[idx].position.z);
+			m_index2depth[i] = std::make_pair(i,
+				modelViewProjMatrix[0][2] * vertices[idx].position.x +
+				modelViewProjMatrix[1][2] * vertices[idx].position.y +
+				modelViewProjMatrix[2][2] * vertices[idx].position.z);
+		}
 	}
 
 	if (this->m_sortOrder == DESCENDING) {
@@ -609,7 +772,10 @@ inline void QuickSortCPU<T>::Sort(const std::vector<T>& vertices, const std::vec
 		depthIndex[i] = idx;
 	}
 
-	vbo->Update(depthIndex);
+	if (vbo) {
+		PROFILE_SCOPE("Index Upload");
+		vbo->UpdateRange(depthIndex, 0, this->m_vertexCount, true);
+	}
 }
 
 template<typename T>
@@ -626,6 +792,14 @@ inline RadixSortCPU<T>::RadixSortCPU(uint32_t vertexCount, SORT_ORDER sortOrder)
 	m_histogram.resize(m_bucketSize);
 }
 
+template<typename T>
+inline void RadixSortCPU<T>::SetVertexCount(uint32_t vertexCount)
+{
+	this->m_vertexCount = vertexCount;
+	m_index2depth1.resize(vertexCount);
+	m_index2depth2.resize(vertexCount);
+}
+
 template<typename T>
 inline void RadixSortCPU<T>::Sort(const std::vector<T>& vertices, const std::vector<uint32_t>& indices, std::vector<uint32_t>& depthIndex, std::shared_ptr<VertexBufferObject> vbo)
 {
@@ -634,13 +808,16 @@ inline void RadixSortCPU<T>::Sort(const std::vector<T>& vertices, const std::vec
 	float half_far = plane_far / 2.0f;
 	auto modelViewProjMatrix = instance->GetProjMat() * instance->GetViewMat();
 	const uint32_t MAX_DEPTH = UINT32_MAX;
-	for (size_t i = 0; i < this->m_vertexCount; i++) {
-		size_t idx = indices[i];
-		auto& pos = vertices[idx].position;
-		float depth = (modelViewProjMatrix[0][2] * pos.x +
-			modelViewProjMatrix[1][2] * pos.y +
-			modelViewProjMatrix[2][2] * pos.z);
-		m_index2depth1[i] = { i, MAX_DEPTH - static_cast<uint32_t>((depth - half_far) / plane_far * MAX_DEPTH) };
+	{
+		PROFILE_CPU_SCOPE("Sort Keys");
+		for (size_t i = 0; i < this->m_vertexCount; i++) {
+			size_t idx = indices[i];
+			auto& pos = vertices[idx].position;
+			float depth = (modelViewProjMatrix[0][2] * pos.x +
+				modelViewProjMatrix[1][2] * pos.y +
+				modelViewProjMatrix[2][2] * pos.z);
+			m_index2depth1[i] = { i, MAX_DEPTH - static_cast<uint32_t>((depth - half_far) / plane_far * MAX_DEPTH) };
+		}
 	}
 
 	for (size_t iter = 0; iter < m_totalIter; iter++)
@@ -691,7 +868,10 @@ inline void RadixSortCPU<T>::Sort(const std::vector<T>& vertices, const std::vec
 			depthIndex[this->m_vertexCount - 1 - i] = idx;
 	}
 
-	vbo->Update(depthIndex);
+	if (vbo) {
+		PROFILE_SCOPE("Index Upload");
+		vbo->UpdateRange(depthIndex, 0, this->m_vertexCount, true);
+	}
 }
 
 template<typename T>
@@ -714,14 +894,17 @@ inline void CountingSortCPU<T>::Sort(const std::vector<T>& vertices, const std::
 	float minDepth = FLT_MAX;
 
 	std::memset(m_sizeList.data(), 0, sizeof(uint32_t) * m_sizeList.size());
-	for (uint32_t i = 0; i < this->m_vertexCount; i++) {
-		size_t idx = indices[i];
-		auto& pos = vertices[idx].position;
-		m_depth[i] = (modelViewProjMatrix[0][2] * pos.x +
-			modelViewProjMatrix[1][2] * pos.y +
-			modelViewProjMatrix[2][2] * pos.z);
-		maxDepth = (std::max)(maxDepth, m_depth[i]);
-		minDepth = (std::min)(minDepth, m_depth[i]);
+	{
+		PROFILE_CPU_SCOPE("Sort Keys");
+		for (uint32_t i = 0; i < this->m_vertexCount; i++) {
+			size_t idx = indices[i];
+			auto& pos = vertices[idx].position;
+			m_depth[i] = (modelViewProjMatrix[0][2] * pos.x +
+				modelViewProjMatrix[1][2] * pos.y +
+				modelViewProjMatrix[2][2] * pos.z);
+			maxDepth = (std::max)(maxDepth, m_depth[i]);
+			minDepth = (std::min)(minDepth, m_depth[i]);
+		}
 	}
 
 	uint32_t sortBit = 256 * 256;
@@ -750,7 +933,10 @@ inline void CountingSortCPU<T>::Sort(const std::vector<T>& vertices, const std::
 			depthIndex[m_starts[m_sizeList[i]]++] = this->m_vertexCount - i - 1;
 	}
 
-	vbo->Update(depthIndex);
+	if (vbo) {
+		PROFILE_SCOPE("Index Upload");
+		vbo->UpdateRange(depthIndex, 0, this->m_vertexCount, true);
+	}
 }
 
 RENDERABLE_END
@@ -0,0 +1,72 @@
+#include "./gs_quality.h"
+
+#include <algorithm>
+#include <cmath>
+#include <imgui/imgui.h>
+RENDERABLE_BEGIN
+void GSQualityController::SetConfig(const Parser::QualityConfig& config)
+{
+	m_config = config;
+	m_config.minShDegree = std::clamp(m_config.minShDegree, 0, 3);
+	m_config.minSplatRatio = std::clamp(m_config.minSplatRatio, 0.01f, 1.0f);
+	m_config.minResolutionScale = std::clamp(m_config.minResolutionScale, 0.1f, 1.0f);
+	m_config.maxSortInterval = (std::max)(m_config.maxSortInterval, 1);
+	m_smoothedMs = 0.0f;
+	ApplyLevel(0);
+}
+
+bool GSQualityController::Update(float workMs)
+{
+	if (!m_config.enabled || workMs <= 0.0f)
+		return false;
+
+	m_smoothedMs = m_smoothedMs == 0.0f ? workMs : m_smoothedMs + SMOOTHING * (workMs - m_smoothedMs);
+	if (m_cooldown > 0) {
+		m_cooldown--;
+		return false;
+	}
+
+	m_overBudgetFrames = m_smoothedMs > m_config.targetFrameMs * DEGRADE_RATIO ? m_overBudgetFrames + 1 : 0;
+	m_underBudgetFrames = m_smoothedMs < m_config.targetFrameMs * UPGRADE_RATIO ? m_underBudgetFrames + 1 : 0;
+	int level = m_level;
+	if (m_overBudgetFrames >= DEGRADE_FRAMES)
+		level = (std::min)(m_level + 1, LEVEL_COUNT - 1);
+	else if (m_underBudgetFrames >= UPGRADE_FRAMES)
+		level = (std::max)(m_level - 1, 0);
+	if (level == m_level)
+		return false;
+
+	ApplyLevel(level);
+	return true;
+}
+
+void GSQualityController::ApplyLevel(int level)
+{
+	m_level = level;
+	m_overBudgetFrames = 0;
+	m_underBudgetFrames = 0;
+	m_cooldown = COOLDOWN_FRAMES;
+
+	float t = static_cast<float>(level) / (LEVEL_COUNT - 1);
+	m_settings.shDegree = static_cast<int>(std::round(3.0f + t * (m_config.minShDegree - 3.0f)));
+	m_settings.splatRatio = 1.0f + t * (m_config.minSplatRatio - 1.0f);
+	m_settings.resolutionScale = 1.0f + t * (m_config.minResolutionScale - 1.0f);
+	m_settings.sortInterval = static_cast<int>(std::round(1.0f + t * (m_config.maxSortInterval - 1.0f)));
+}
+
+void GSQualityController::ImGuiCallback()
+{
+	static bool isFolded = true;
+	if (ImGui::CollapsingHeader("Adaptive Quality", &isFolded, ImGuiTreeNodeFlags_DefaultOpen))  // default open
+	{
+		if (ImGui::Checkbox("Enable Adaptive Quality", &m_config.enabled) && !m_config.enabled)
+			ApplyLevel(0);
+		if (ImGui::IsItemHovered())
+			ImGui::SetTooltip("The frame work is measured by the profiler, the level holds while profiling is disabled");
+		ImGui::SliderFloat("Target Frame ms", &m_config.targetFrameMs, 4.0f, 50.0f);
+		ImGui::Text("Work %.2f ms, level %d / %d", m_smoothedMs, m_level, LEVEL_COUNT - 1);
+		ImGui::Text("SH degree %d, splats %.0f%%, resolution %.0f%%, sort every %d frames",
+			m_settings.shDegree, m_settings.splatRatio * 100.0f, m_settings.resolutionScale * 100.0f, m_settings.sortInterval);
+	}
+}
+RENDERABLE_END
@@ -0,0 +1,49 @@
+#pragma once
+#include <cstdint>
+#include "common.h"
+#include "../parser/config_parser.h"
+
+RENDERABLE_BEGIN
+// Closed loop controller that trades image quality of a gaussian scene for frame time.
+// Quality is a ladder of levels from full quality (0) to the configured minimums, every knob is
+// interpolated along the ladder. The measured frame work is smoothed and the level only moves
+// after it has stayed outside the band [UPGRADE_RATIO, DEGRADE_RATIO] * target for a while,
+// and never again before the effect of the last move can be measured.
+class GSQualityController
+{
+public:
+	struct Settings {
+		int shDegree = 3;
+		float splatRatio = 1.0f;
+		float resolutionScale = 1.0f;
+		int sortInterval = 1;
+	};
+
+	void SetConfig(const Parser::QualityConfig& config);
+	bool IsEnabled() const { return m_config.enabled; }
+	// feeds the work time of a newly resolved frame, returns true when the settings changed
+	bool Update(float workMs);
+	const Settings& GetSettings() const { return m_settings; }
+	void ImGuiCallback();
+
+private:
+	void ApplyLevel(int level);
+
+private:
+	static constexpr int LEVEL_COUNT = 8;
+	static constexpr float DEGRADE_RATIO = 1.05f;
+	static constexpr float UPGRADE_RATIO = 0.75f;
+	static constexpr int DEGRADE_FRAMES = 8;
+	static constexpr int UPGRADE_FRAMES = 60;
+	static constexpr int COOLDOWN_FRAMES = 30;  // profiler results lag two frames, the average needs a few more
+	static constexpr float SMOOTHING = 0.1f;
+
+	Parser::QualityConfig m_config{};
+	Settings m_settings{};
+	int m_level = 0;
+	float m_smoothedMs = 0.0f;
+	int m_overBudgetFrames = 0;
+	int m_underBudgetFrames = 0;
+	int m_cooldown = 0;
+};
+RENDERABLE_END
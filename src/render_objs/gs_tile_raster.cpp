@@ -0,0 +1,220 @@
+#include "./gs_tile_raster.h"
+#include "./gs_ply_obj.h"
+#include "../utils/profiler.h"
+#include "../utils/gpu_memory.h"
+
+#include <bit>
+#include <algorithm>
+#include <imgui/imgui.h>
+RENDERABLE_BEGIN
+GSTileRasterizer::GSTileRasterizer()
+{
+	m_duplicateProg = std::make_shared<ComputeShader>(TILE_DUPLICATE_SHADER);
+	m_keysProg = std::make_shared<ComputeShader>(TILE_KEYS_SHADER);
+	m_rangesProg = std::make_shared<ComputeShader>(TILE_RANGES_SHADER);
+	m_rasterProg = std::make_shared<ComputeShader>(TILE_RASTER_SHADER);
+	m_sortProg = std::make_shared<ComputeShader>(MULTI_RADIX_SORT_SHADER, GetRadixSortDefines());
+	m_histogramProg = std::make_shared<ComputeShader>(MULTI_RADIX_SORT_HISTOGRAM_SHADER);
+	m_sortUniforms = { m_sortProg->GetUniformHandle("g_num_elements"), m_sortProg->GetUniformHandle("g_num_workgroups"),
+		m_sortProg->GetUniformHandle("g_num_blocks_per_workgroup"), m_sortProg->GetUniformHandle("g_shift") };
+	m_histogramUniforms = { m_histogramProg->GetUniformHandle("g_num_elements"), UniformHandle{},
+		m_histogramProg->GetUniformHandle("g_num_blocks_per_workgroup"), m_histogramProg->GetUniformHandle("g_shift") };
+	m_duplicateSplatCountUniform = m_duplicateProg->GetUniformHandle("splatCount");
+	m_duplicateCapacityUniform = m_duplicateProg->GetUniformHandle("capacity");
+	m_duplicateRenderSizeUniform = m_duplicateProg->GetUniformHandle("renderSize");
+	m_keysCountUniform = m_keysProg->GetUniformHandle("duplicateCount");
+	m_rangesCountUniform = m_rangesProg->GetUniformHandle("duplicateCount");
+	m_rasterRenderSizeUniform = m_rasterProg->GetUniformHandle("renderSize");
+}
+
+GSTileRasterizer::~GSTileRasterizer()
+{
+	for (Buffer* buffer : { &m_counterBuffer, &m_keyBuffers[0], &m_keyBuffers[1], &m_valueBuffers[0], &m_valueBuffers[1],
+		&m_duplicateBuffer, &m_histogramBuffer, &m_rangeBuffer }) {
+		if (buffer->id == 0)
+			continue;
+		GpuMemoryTracker::GetInstance()->Release(GpuMemoryTracker::Kind::Buffer, buffer->id);
+		glDeleteBuffers(1, &buffer->id);
+	}
+}
+
+std::vector<ProgramStages> GSTileRasterizer::GetPrograms()
+{
+	return {
+		{ { GL_COMPUTE_SHADER, TILE_DUPLICATE_SHADER } },
+		{ { GL_COMPUTE_SHADER, TILE_KEYS_SHADER } },
+		{ { GL_COMPUTE_SHADER, TILE_RANGES_SHADER } },
+		{ { GL_COMPUTE_SHADER, TILE_RASTER_SHADER } },
+		{ { GL_COMPUTE_SHADER, MULTI_RADIX_SORT_SHADER, GetRadixSortDefines() } },
+		{ { GL_COMPUTE_SHADER, MULTI_RADIX_SORT_HISTOGRAM_SHADER } },
+	};
+}
+
+void GSTileRasterizer::Render(GLuint recordBuffer, uint32_t splatCount, glm::ivec2 renderSize, GLuint target, GLenum targetFormat)
+{
+	renderSize = (glm::max)(renderSize, glm::ivec2(1));
+	m_tileGrid = (glm::uvec2(renderSize) + TILE_SIZE - 1u) / TILE_SIZE;
+	m_splatCount = splatCount;
+	const uint32_t TILE_COUNT = m_tileGrid.x * m_tileGrid.y;
+	const uint32_t TILE_BITS = (std::max)(static_cast<uint32_t>(std::bit_width(TILE_COUNT - 1)), 1u);
+
+	m_duplicateProg->Use();
+	m_duplicateProg->SetVec2(m_duplicateRenderSizeUniform, glm::vec2(renderSize));
+	if (m_capacity == 0)
+		m_capacity = (std::max)(splatCount * 4, 1u << 16);
+	uint32_t duplicateCount = 0;
+	{
+		PROFILE_SCOPE("Tile Duplicate");
+		duplicateCount = Duplicate(recordBuffer, splatCount);
+		if (duplicateCount > m_capacity) {
+			// the count is only known after the pass, grow with some headroom so a moving camera does not repeat this
+			m_capacity = duplicateCount + duplicateCount / 2;
+			duplicateCount = Duplicate(recordBuffer, splatCount);
+		}
+	}
+	m_duplicateCount = duplicateCount;
+
+	uint32_t result = 0;
+	if (duplicateCount > 0) {
+		PROFILE_SCOPE("Tile Sort");
+		// depth first, the tile passes are stable and keep the depth order inside every tile
+		result = RadixSort(duplicateCount, 32, 0);
+		m_keysProg->Use();
+		m_keysProg->SetUInt(m_keysCountUniform, duplicateCount);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_keyBuffers[result].id);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, m_valueBuffers[result].id);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, m_duplicateBuffer.id);
+		glDispatchCompute((duplicateCount + LOCAL_SIZE - 1) / LOCAL_SIZE, 1, 1);
+		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+		result = RadixSort(duplicateCount, TILE_BITS, result);
+	}
+
+	{
+		PROFILE_SCOPE("Tile Ranges");
+		Reserve(m_rangeBuffer, static_cast<size_t>(TILE_COUNT) * sizeof(glm::uvec2));
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_rangeBuffer.id);
+		glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+		if (duplicateCount > 0) {
+			m_rangesProg->Use();
+			m_rangesProg->SetUInt(m_rangesCountUniform, duplicateCount);
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_keyBuffers[result].id);
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, m_rangeBuffer.id);
+			glDispatchCompute((duplicateCount + LOCAL_SIZE - 1) / LOCAL_SIZE, 1, 1);
+			glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+		}
+	}
+
+	{
+		PROFILE_SCOPE("Tile Raster");
+		m_rasterProg->Use();
+		m_rasterProg->SetVec2(m_rasterRenderSizeUniform, glm::vec2(renderSize));
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, recordBuffer);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, m_valueBuffers[result].id);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, m_rangeBuffer.id);
+		glBindImageTexture(0, target, 0, GL_FALSE, 0, GL_WRITE_ONLY, targetFormat);
+		glDispatchCompute(m_tileGrid.x, m_tileGrid.y, 1);
+		glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_FRAMEBUFFER_BARRIER_BIT);
+		glBindImageTexture(0, 0, 0, GL_FALSE, 0, GL_WRITE_ONLY, targetFormat);
+	}
+}
+
+uint32_t GSTileRasterizer::Duplicate(GLuint recordBuffer, uint32_t splatCount)
+{
+	Reserve(m_keyBuffers[0], static_cast<size_t>(m_capacity) * sizeof(uint32_t));
+	Reserve(m_keyBuffers[1], static_cast<size_t>(m_capacity) * sizeof(uint32_t));
+	Reserve(m_valueBuffers[0], static_cast<size_t>(m_capacity) * sizeof(uint32_t));
+	Reserve(m_valueBuffers[1], static_cast<size_t>(m_capacity) * sizeof(uint32_t));
+	Reserve(m_duplicateBuffer, static_cast<size_t>(m_capacity) * sizeof(glm::uvec2));
+	Reserve(m_counterBuffer, sizeof(uint32_t));
+
+	uint32_t count = 0;
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_counterBuffer.id);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(uint32_t), &count);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	m_duplicateProg->Use();
+	m_duplicateProg->SetUInt(m_duplicateSplatCountUniform, splatCount);
+	m_duplicateProg->SetUInt(m_duplicateCapacityUniform, m_capacity);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, recordBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, m_counterBuffer.id);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, m_keyBuffers[0].id);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, m_valueBuffers[0].id);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, m_duplicateBuffer.id);
+	glDispatchCompute((splatCount + LOCAL_SIZE - 1) / LOCAL_SIZE, 1, 1);
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+
+	// the sort sizes its dispatches on the CPU, like the presort of the GPU sorters this waits for the GPU
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_counterBuffer.id);
+	glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(uint32_t), &count);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	return count;
+}
+
+uint32_t GSTileRasterizer::RadixSort(uint32_t count, uint32_t bitCount, uint32_t source)
+{
+	const uint32_t NUM_WORKGROUPS = (count + LOCAL_SIZE * BLOCKS_PER_WORKGROUP - 1) / (LOCAL_SIZE * BLOCKS_PER_WORKGROUP);
+	Reserve(m_histogramBuffer, static_cast<size_t>(NUM_WORKGROUPS) * RADIX_SORT_BINS * sizeof(uint32_t));
+	m_sortProg->Use();
+	m_sortProg->SetUInt(m_sortUniforms.numElements, count);
+	m_sortProg->SetUInt(m_sortUniforms.numWorkgroups, NUM_WORKGROUPS);
+	m_sortProg->SetUInt(m_sortUniforms.numBlocksPerWorkgroup, BLOCKS_PER_WORKGROUP);
+	m_histogramProg->Use();
+	m_histogramProg->SetUInt(m_histogramUniforms.numElements, count);
+	m_histogramProg->SetUInt(m_histogramUniforms.numBlocksPerWorkgroup, BLOCKS_PER_WORKGROUP);
+
+	for (uint32_t shift = 0; shift < bitCount; shift += 8) {
+		const uint32_t DEST = 1 - source;
+		m_histogramProg->Use();
+		m_histogramProg->SetUInt(m_histogramUniforms.shift, shift);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_keyBuffers[source].id);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, m_histogramBuffer.id);
+		glDispatchCompute(NUM_WORKGROUPS, 1, 1);
+		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+		m_sortProg->Use();
+		m_sortProg->SetUInt(m_sortUniforms.shift, shift);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_keyBuffers[source].id);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, m_keyBuffers[DEST].id);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, m_valueBuffers[source].id);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, m_valueBuffers[DEST].id);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, m_histogramBuffer.id);
+		glDispatchCompute(NUM_WORKGROUPS, 1, 1);
+		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+		source = DEST;
+	}
+	return source;
+}
+
+void GSTileRasterizer::Reserve(Buffer& buffer, size_t size)
+{
+	if (buffer.id != 0 && buffer.size >= size)
+		return;
+	if (buffer.id == 0)
+		glGenBuffers(1, &buffer.id);
+	GpuMemoryTracker::GetInstance()->Allocate(GpuMemoryTracker::Kind::Buffer, buffer.id, size, "tile raster buffer");
+	// the contents are rewritten every frame, nothing has to survive the reallocation
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer.id);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, size, nullptr, GL_DYNAMIC_COPY);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	buffer.size = size;
+}
+
+size_t GSTileRasterizer::GetMemoryUsage() const
+{
+	size_t bytes = 0;
+	for (const Buffer* buffer : { &m_counterBuffer, &m_keyBuffers[0], &m_keyBuffers[1], &m_valueBuffers[0], &m_valueBuffers[1],
+		&m_duplicateBuffer, &m_histogramBuffer, &m_rangeBuffer }) {
+		bytes += buffer->size;
+	}
+	return bytes;
+}
+
+void GSTileRasterizer::ImGuiCallback()
+{
+	ImGui::Text("%u x %u tiles, %u duplicates of %u splats (%.1f per splat)", m_tileGrid.x, m_tileGrid.y,
+		m_duplicateCount, m_splatCount, m_splatCount > 0 ? static_cast<float>(m_duplicateCount) / m_splatCount : 0.0f);
+	ImGui::Text("Duplicate capacity %u, %.1f MB", m_capacity, GetMemoryUsage() / (1024.0f * 1024.0f));
+}
+RENDERABLE_END
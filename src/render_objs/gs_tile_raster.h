@@ -0,0 +1,82 @@
+#pragma once
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <vector>
+#include <memory>
+#include "common.h"
+#include "../draw/shader_c.h"
+#include "../draw/program_cache.h"
+
+RENDERABLE_BEGIN
+constexpr const char* TILE_DUPLICATE_SHADER = "./shader/gs_tile_duplicate_comp.glsl";
+constexpr const char* TILE_KEYS_SHADER = "./shader/gs_tile_keys_comp.glsl";
+constexpr const char* TILE_RANGES_SHADER = "./shader/gs_tile_ranges_comp.glsl";
+constexpr const char* TILE_RASTER_SHADER = "./shader/gs_tile_raster_comp.glsl";
+
+// Compute rasterizer for gaussian splats, an alternative to blending one quad per splat in hardware.
+// Follows the tile rasterizer of the reference 3DGS implementation: every splat record of the preprocess
+// pass is duplicated once per overlapped 16 x 16 tile, the duplicates are sorted by (tile, depth) and
+// every tile blends its range front to back in one workgroup, which stops as soon as all of its pixels
+// are saturated. The sort reuses the multi pass radix sort kernels, the 64 bit key is sorted as four
+// passes on the view depth followed by stable passes on the tile.
+class GSTileRasterizer
+{
+public:
+	GSTileRasterizer();
+	~GSTileRasterizer();
+	GSTileRasterizer(const GSTileRasterizer&) = delete;
+	GSTileRasterizer& operator=(const GSTileRasterizer&) = delete;
+
+	// programs of the rasterizer, for ProgramCache::Prefetch
+	static std::vector<ProgramStages> GetPrograms();
+	// rasterizes splatCount SplatRecords into the lower left renderSize pixels of target, an RGBA
+	// texture of targetFormat. The records are projected for the viewport of the FrameContext
+	void Render(GLuint recordBuffer, uint32_t splatCount, glm::ivec2 renderSize, GLuint target, GLenum targetFormat);
+	size_t GetMemoryUsage() const;
+	void ImGuiCallback();
+
+private:
+	struct Buffer {
+		GLuint id = 0;
+		size_t size = 0;
+	};
+
+	// returns the number of duplicates, they are only all written when it does not exceed m_capacity
+	uint32_t Duplicate(GLuint recordBuffer, uint32_t splatCount);
+	// sorts keys and values of buffers[source] by bitCount low bits of the keys, returns the buffer holding the result
+	uint32_t RadixSort(uint32_t count, uint32_t bitCount, uint32_t source);
+	void Reserve(Buffer& buffer, size_t size);
+
+private:
+	static constexpr uint32_t TILE_SIZE = 16;
+	static constexpr uint32_t LOCAL_SIZE = 256;
+	static constexpr uint32_t RADIX_SORT_BINS = 256;
+	static constexpr uint32_t BLOCKS_PER_WORKGROUP = 32;
+
+	std::shared_ptr<ComputeShader> m_duplicateProg = nullptr;
+	std::shared_ptr<ComputeShader> m_keysProg = nullptr;
+	std::shared_ptr<ComputeShader> m_rangesProg = nullptr;
+	std::shared_ptr<ComputeShader> m_rasterProg = nullptr;
+	std::shared_ptr<ComputeShader> m_sortProg = nullptr;
+	std::shared_ptr<ComputeShader> m_histogramProg = nullptr;
+	struct RadixPassUniforms {
+		UniformHandle numElements{};
+		UniformHandle numWorkgroups{};
+		UniformHandle numBlocksPerWorkgroup{};
+		UniformHandle shift{};
+	};
+	RadixPassUniforms m_sortUniforms{}, m_histogramUniforms{};
+	UniformHandle m_duplicateSplatCountUniform{}, m_duplicateCapacityUniform{}, m_duplicateRenderSizeUniform{};
+	UniformHandle m_keysCountUniform{}, m_rangesCountUniform{}, m_rasterRenderSizeUniform{};
+
+	Buffer m_counterBuffer{};
+	Buffer m_keyBuffers[2]{}, m_valueBuffers[2]{};
+	Buffer m_duplicateBuffer{};
+	Buffer m_histogramBuffer{};
+	Buffer m_rangeBuffer{};
+	uint32_t m_capacity = 0;  // duplicates the buffers hold
+	glm::uvec2 m_tileGrid = { 0, 0 };
+	uint32_t m_duplicateCount = 0;
+	uint32_t m_splatCount = 0;
+};
+RENDERABLE_END
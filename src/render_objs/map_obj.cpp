@@ -1,156 +1,238 @@
 #include "map_obj.h"
 #include <math.h>
+#include <cfloat>
 RENDERABLE_BEGIN
 MapObj::MapObj(std::shared_ptr<Parser::RenderObjConfigBase> baseConfigPtr)
 {
-	SetUpData();
 	SetUpGLStatus();
 	auto ConfigPtr = std::static_pointer_cast<Parser::RenderObjConfigSimple>(baseConfigPtr);
 	SetUpShader(ConfigPtr->vertexShader, ConfigPtr->fragmentShader);
-	SetUpTexture(1);
+	m_gridWidthUniform = m_shader->GetUniformHandle("gridWidth");
+	m_gridHeightUniform = m_shader->GetUniformHandle("gridHeight");
+	m_gridRectUniform = m_shader->GetUniformHandle("gridRect");
+	m_transformScaleUniform = m_shader->GetUniformHandle("transformScale");
+	m_tiles = std::make_unique<MapTileEngine>(ConfigPtr->tileDirectory);
 }
 
-#define PI 3.1415926535f
-void MapObj::UV2XYZ(const Point& uv, Point& xyz) {
-	float lon = uv.x * 180.0f;
-	float lat = uv.y * 90.0f;
+void MapObj::LoadData()
+{
+	m_tiles->ScanLevels();
+}
 
-	float radLon = (lon - 90.0f) * PI / 180.0f;
-	float radLat = lat * PI / 180.0f;
+void MapObj::SetUpGL()
+{
+	// the vertices come from gl_VertexID, the core profile still needs a vertex array to draw
+	glGenVertexArrays(1, &m_VAO);
+	SetUpTexture();
+}
 
-	const float earthPerimeter = 20037508.34f;
-	const float earthRadius = 6378137.0f;
+size_t MapObj::GetMemoryUsage() const
+{
+	return m_tiles->GetMemoryUsage();
+}
 
-	xyz.x = cos(radLat) * cos(radLon);
-	xyz.y = sin(radLat);
-	xyz.z = cos(radLat) * sin(radLon);
+#define PI 3.1415926535f
+glm::vec3 MapObj::GridToPosition(glm::vec2 grid) const
+{
+	float radLon = (grid.x * 180.0f - 90.0f) * PI / 180.0f;
+	float radLat = grid.y * 90.0f * PI / 180.0f;
+	glm::vec3 sphere(cos(radLat) * cos(radLon), sin(radLat), cos(radLat) * sin(radLon));
+	return glm::vec3(grid, 0.0f) * (1 - m_transform_scale) + sphere * m_transform_scale;
+}
 
-	if (abs(lat) < 85) {
-		float WebMercatorX = earthRadius * radLon;
-		float WebMercatorY = earthRadius * log(tan((PI / 4.0f) + (radLat / 2.0f)));
+glm::vec2 MapObj::GridToTexCoord(glm::vec2 grid) const
+{
+	glm::vec2 uv = (grid - glm::vec2(m_gridLeft, m_gridBottom)) / glm::vec2(m_gridRight - m_gridLeft, m_gridTop - m_gridBottom);
+	float radLon = (grid.x * 180.0f - 90.0f) * PI / 180.0f;
+	float radLat = grid.y * 90.0f * PI / 180.0f;
+	glm::vec2 mercator = uv;
+	if (abs(grid.y * 90.0f) < 85.0f)
+		mercator = (glm::vec2(radLon, log(tan(PI / 4.0f + radLat / 2.0f))) / PI + 1.0f) * 0.5f;
+	return uv * (1 - m_transform_scale) + mercator * m_transform_scale;
+}
 
-		xyz.u = (WebMercatorX / earthPerimeter + 1.0f) / 2.0f;
-		xyz.v = (WebMercatorY / earthPerimeter + 1.0f) / 2.0f;
-	}
-	else {
-		xyz.u = uv.u;
-		xyz.v = uv.v;
+float MapObj::TexCoordToRow(float v) const
+{
+	float vBottom = GridToTexCoord(glm::vec2(m_gridLeft, m_gridBottom)).y;
+	float vTop = GridToTexCoord(glm::vec2(m_gridLeft, m_gridTop)).y;
+	if (v < vBottom)
+		return m_gridBottom - (vBottom - v);
+	if (v > vTop)
+		return m_gridTop + (v - vTop);
+	// v grows with the row, apart from the seam of the caps at 85 degrees where the bisection ends on either side
+	float low = m_gridBottom, high = m_gridTop;
+	for (int i = 0; i < 16; i++) {
+		float mid = 0.5f * (low + high);
+		if (GridToTexCoord(glm::vec2(m_gridLeft, mid)).y < v)
+			low = mid;
+		else
+			high = mid;
 	}
+	return 0.5f * (low + high);
 }
 
+float MapObj::TexCoordToColumn(float u, float row) const
+{
+	// along a row u is linear in x
+	float uLeft = GridToTexCoord(glm::vec2(m_gridLeft, row)).x;
+	float uRight = GridToTexCoord(glm::vec2(m_gridRight, row)).x;
+	return m_gridLeft + (u - uLeft) / (uRight - uLeft) * (m_gridRight - m_gridLeft);
+}
 
-void MapObj::SetUpData()
+bool MapObj::ProjectTile(const FrameContext& frame, const MapTileEngine::TileKey& key, float& pixelSize) const
 {
-	uint32_t numVerticesPerRow = m_gridWidth + 1;
-	float gridUnitWidth = (m_gridRight - m_gridLeft) / m_gridWidth;
-	float gridUnitHeight = (m_gridTop - m_gridBottom) / m_gridHeight;
-	float uvUnitWidth = 1.0f / m_gridWidth;
-	float uvUnitHeight = 1.0f / m_gridHeight;
-
-	std::vector<Point> m_vertices;
-	std::vector<uint32_t> indices;
-
-	for (uint32_t i = 0; i <= static_cast<uint32_t>(m_gridWidth); i++)
-	{
-		for (uint32_t j = 0; j <= static_cast<uint32_t>(m_gridHeight); j++)
-		{
-			Point start{ .x = m_gridLeft + i * gridUnitWidth,
-						 .y = m_gridBottom + j * gridUnitHeight,
-						 .u = uvUnitWidth * i,
-						 .v = uvUnitHeight * j };
-
-			Point end;
-			UV2XYZ(start, end);
-
-			m_vertices.emplace_back(start * (1 - m_transform_scale) + end * m_transform_scale);
-
-			if (i != m_gridWidth && j != m_gridHeight) {
-				indices.emplace_back(i + j * numVerticesPerRow);
-				indices.emplace_back(i + 1 + (j + 1) * numVerticesPerRow);
-				indices.emplace_back(i + 1 + j * numVerticesPerRow);
-
-				indices.emplace_back(i + (j + 1) * numVerticesPerRow);
-				indices.emplace_back(i + 1 + (j + 1) * numVerticesPerRow);
-				indices.emplace_back(i + j * numVerticesPerRow);
-			}
+	if (m_gridRight <= m_gridLeft || m_gridTop <= m_gridBottom)
+		return false;
+
+	// the texture coordinates of the corners and the center, v grows to the north
+	float tileCount = static_cast<float>(1 << key.z);
+	glm::vec2 texCoords[5] = {
+		glm::vec2(key.x, key.y),
+		glm::vec2(key.x + 1, key.y),
+		glm::vec2(key.x + 1, key.y + 1),
+		glm::vec2(key.x, key.y + 1),
+		glm::vec2(key.x + 0.5f, key.y + 0.5f)
+	};
+	// map_fs.glsl wraps u, the tile is moved to the turn the grid shows around its middle row
+	float middle = 0.5f * (m_gridBottom + m_gridTop);
+	float uMin = (std::min)(GridToTexCoord(glm::vec2(m_gridLeft, middle)).x, GridToTexCoord(glm::vec2(m_gridRight, middle)).x);
+	float shift = ceil(uMin - (key.x + 0.5f) / tileCount);
+	for (auto& texCoord : texCoords) {
+		texCoord = glm::vec2(texCoord.x / tileCount + shift, 1.0f - texCoord.y / tileCount);
+	}
+
+	// the grid points showing them, the corners share their rows
+	float rows[3] = { TexCoordToRow(texCoords[0].y), TexCoordToRow(texCoords[2].y), TexCoordToRow(texCoords[4].y) };
+	glm::vec2 grids[5];
+	glm::vec2 gridMin(FLT_MAX), gridMax(-FLT_MAX);
+	for (int i = 0; i < 5; i++) {
+		float row = rows[i == 4 ? 2 : i / 2];
+		grids[i] = glm::vec2(TexCoordToColumn(texCoords[i].x, row), row);
+		gridMin = glm::min(gridMin, grids[i]);
+		gridMax = glm::max(gridMax, grids[i]);
+		grids[i] = glm::clamp(grids[i], glm::vec2(m_gridLeft, m_gridBottom), glm::vec2(m_gridRight, m_gridTop));
+	}
+	if (gridMax.x < m_gridLeft || gridMin.x > m_gridRight || gridMax.y < m_gridBottom || gridMin.y > m_gridTop)
+		return false;
+
+	glm::mat4 modelView = frame.view * frame.model;
+	glm::vec4 clips[5];
+	glm::vec3 views[5];
+	for (int i = 0; i < 5; i++) {
+		glm::vec4 view = modelView * glm::vec4(GridToPosition(grids[i]), 1.0f);
+		views[i] = glm::vec3(view);
+		clips[i] = frame.projection * view;
+	}
+	// outside when all points are beyond the same plane of the frustum
+	for (int axis = 0; axis < 3; axis++) {
+		bool beyondMin = true, beyondMax = true;
+		for (const auto& clip : clips) {
+			beyondMin &= clip[axis] < -clip.w;
+			beyondMax &= clip[axis] > clip.w;
+		}
+		if (beyondMin || beyondMax)
+			return false;
+	}
+	// on the globe, behind the horizon when no point faces the eye. The tiles of the first levels are too large
+	// for their points to tell
+	if (m_transform_scale >= 1.0f && key.z >= 3) {
+		glm::vec3 center = glm::vec3(modelView * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+		bool isOrthogonal = frame.projection[3][3] == 1.0f;
+		bool isFacing = false;
+		for (const auto& view : views) {
+			glm::vec3 toEye = isOrthogonal ? glm::vec3(0.0f, 0.0f, 1.0f) : -view;
+			isFacing |= glm::dot(view - center, toEye) > 0.0f;
 		}
+		if (!isFacing)
+			return false;
 	}
 
-	//glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-	SetMesh(&m_vertices, &m_vertexInfo, &indices);
+	glm::vec2 screens[5];
+	for (int i = 0; i < 5; i++) {
+		if (clips[i].w <= 0.0f) {
+			// reaches behind the eye, refined until its parts are in front
+			pixelSize = FLT_MAX;
+			return true;
+		}
+		screens[i] = (glm::vec2(clips[i]) / clips[i].w * 0.5f + 0.5f) * frame.viewport;
+	}
+	pixelSize = 0.0f;
+	for (int i = 0; i < 4; i++) {
+		pixelSize = (std::max)(pixelSize, glm::length(screens[(i + 1) % 4] - screens[i]));
+	}
+	pixelSize = (std::max)(pixelSize, glm::length(screens[2] - screens[0]) / sqrt(2.0f));
+	pixelSize = (std::max)(pixelSize, glm::length(screens[3] - screens[1]) / sqrt(2.0f));
+	return true;
 }
 
 void MapObj::SetUpGLStatus()
 {
-	glEnable(GL_DEPTH_TEST);
-	glEnable(GL_CULL_FACE);
-	glCullFace(GL_BACK);
+	auto glState = GLStateCache::GetInstance();
+	glState->Enable(GL_DEPTH_TEST);
+	glState->Enable(GL_CULL_FACE);
+	glState->CullFace(GL_BACK);
 }
 
-void MapObj::DrawObj(const std::unordered_map<std::string, std::any>& uniform)
+void MapObj::DrawObj(const FrameContext& frame)
 {
 	SetUpGLStatus();
 
-	auto projection = std::any_cast<glm::mat4>(uniform.at("projection"));
-	auto view = std::any_cast<glm::mat4>(uniform.at("view"));
-	auto model = std::any_cast<glm::mat4>(uniform.at("model"));
-
+	m_tiles->Update([this, &frame](const MapTileEngine::TileKey& key, float& pixelSize) { return ProjectTile(frame, key, pixelSize); });
 	m_shader->Use();
-	m_shader->SetMat4("projection", projection);
-	m_shader->SetMat4("view", view);
-	m_shader->SetMat4("model", model);
-	for (auto idx : m_textureIdxes) {
-		m_textures->BindTexture(idx);
-	}
-	RenderObjectNaive::Draw();
+	m_shader->SetInt(m_gridWidthUniform, m_gridWidth);
+	m_shader->SetInt(m_gridHeightUniform, m_gridHeight);
+	m_shader->SetVec4(m_gridRectUniform, m_gridLeft, m_gridBottom, m_gridRight, m_gridTop);
+	m_shader->SetFloat(m_transformScaleUniform, m_transform_scale);
+	m_tiles->Bind(0, 1);
+
+	// a triangle strip per row, 2 vertices a column and 2 more to step to the next row through
+	// degenerate triangles, see map_vs.glsl
+	auto glState = GLStateCache::GetInstance();
+	glState->BindVertexArray(m_VAO);
+	glDrawArrays(GL_TRIANGLE_STRIP, 0, m_gridHeight * (2 * m_gridWidth + 4) - 2);
+	glState->BindVertexArray(0);
 }
 
-void MapObj::SetUpTexture(int num)
+void MapObj::SetUpTexture(int /*num*/)
 {
-	GLint maxTextureSize = 0;
-	glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
-	GLint maxLayers = 0;
-	glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
-
-	m_textures = std::make_unique<Texture>(num);
-	size_t idx1 = m_textures->GenerateTexture("D:/jupyter_notebook/cg_practise/httplib/output/0/0/0.png");
-	m_textureIdxes.emplace_back(idx1);
+	// the tiles are streamed into one array texture, drawn through the quadtree of the resident ones
+	m_tiles->SetUpGL();
 
 	m_shader->Use();
-	m_shader->SetInt("texture1", static_cast<int>(idx1));
+	m_shader->SetInt("tileCache", 0);
+	m_shader->SetInt("tileTree", 1);
 }
 
 
 void MapObj::ImGuiCallback()
 {
-	bool is_change = false;
-
 	static int selection = 2;
 	if (ImGui::CollapsingHeader("Rasterization Mode")) {
-		is_change |= ImGui::RadioButton("point", &selection, 0);
+		ImGui::RadioButton("point", &selection, 0);
 		ImGui::SameLine();
-		is_change |= ImGui::RadioButton("line", &selection, 1);
+		ImGui::RadioButton("line", &selection, 1);
 		ImGui::SameLine();
-		is_change |= ImGui::RadioButton("fill", &selection, 2);
+		ImGui::RadioButton("fill", &selection, 2);
 	}
 	if (selection == 0) {
-		glPolygonMode(GL_FRONT_AND_BACK, GL_POINT);
+		GLStateCache::GetInstance()->PolygonMode(GL_POINT);
 	}
 	else if (selection == 1) {
-		glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+		GLStateCache::GetInstance()->PolygonMode(GL_LINE);
 	}
 	else if (selection == 2) {
-		glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+		GLStateCache::GetInstance()->PolygonMode(GL_FILL);
 	}
 
-	is_change |= ImGui::SliderInt("grid_width", &m_gridWidth, 2, 50);
-	is_change |= ImGui::SliderInt("grid_height", &m_gridHeight, 2, 50);
-	is_change |= ImGui::SliderFloat("grid_left", &m_gridLeft, -1.0f, 0.0f);
-	is_change |= ImGui::SliderFloat("grid_bottom", &m_gridBottom, -1.0f, 0.0f);
-	is_change |= ImGui::SliderFloat("grid_right", &m_gridRight, 0.0f, 1.0f);
-	is_change |= ImGui::SliderFloat("grid_top", &m_gridTop, 0.0f, 1.0f);
-	is_change |= ImGui::SliderFloat("transform_scale", &m_transform_scale, 0.0f, 1.0f);
-	if (is_change) SetUpData();
+	// the grid is generated in map_vs.glsl, changing it only changes its uniforms
+	ImGui::SliderInt("grid_width", &m_gridWidth, 2, 2048, "%d", ImGuiSliderFlags_Logarithmic);
+	ImGui::SliderInt("grid_height", &m_gridHeight, 2, 2048, "%d", ImGuiSliderFlags_Logarithmic);
+	ImGui::SliderFloat("grid_left", &m_gridLeft, -1.0f, 0.0f);
+	ImGui::SliderFloat("grid_bottom", &m_gridBottom, -1.0f, 0.0f);
+	ImGui::SliderFloat("grid_right", &m_gridRight, 0.0f, 1.0f);
+	ImGui::SliderFloat("grid_top", &m_gridTop, 0.0f, 1.0f);
+	ImGui::SliderFloat("transform_scale", &m_transform_scale, 0.0f, 1.0f);
+	m_tiles->ImGuiCallback();
 }
 
 
@@ -0,0 +1,328 @@
+#include "map_tiles.h"
+
+#include <cfloat>
+#include <format>
+#include <iostream>
+#include <filesystem>
+#include <algorithm>
+#include "stb/stb_image.h"
+
+RENDERABLE_BEGIN
+MapTileEngine::MapTileEngine(const std::string& directory, int layerCount) : m_directory(directory), m_layerCount(layerCount)
+{
+}
+
+MapTileEngine::~MapTileEngine()
+{
+	// the pool joins once its queue is empty, the queued decodes now finish at once and only those in flight are awaited
+	m_cancelled = true;
+	auto tracker = GpuMemoryTracker::GetInstance();
+	if (m_cache != 0) {
+		tracker->Release(GpuMemoryTracker::Kind::Texture, m_cache);
+		GLStateCache::GetInstance()->OnDeleteTexture(m_cache);
+		glDeleteTextures(1, &m_cache);
+	}
+	if (m_treeTexture != 0) {
+		GLStateCache::GetInstance()->OnDeleteTexture(m_treeTexture);
+		glDeleteTextures(1, &m_treeTexture);
+	}
+	if (m_treeBuffer != 0) {
+		tracker->Release(GpuMemoryTracker::Kind::Buffer, m_treeBuffer);
+		glDeleteBuffers(1, &m_treeBuffer);
+	}
+}
+
+void MapTileEngine::ScanLevels()
+{
+	// tileDirectory is optional, without it only the grid is drawn
+	if (m_directory.empty())
+		return;
+	std::error_code error;
+	if (!std::filesystem::is_directory(m_directory, error)) {
+		std::cerr << std::format("Error occur: the tile directory {} does not exist.", m_directory) << std::endl;
+		return;
+	}
+	for (const auto& entry : std::filesystem::directory_iterator(m_directory, error)) {
+		std::string name = entry.path().filename().string();
+		if (!entry.is_directory() || name.empty() || !std::all_of(name.begin(), name.end(), [](char c) { return c >= '0' && c <= '9'; }))
+			continue;
+		if (name.size() <= 2)
+			m_maxLevel = (std::max)(m_maxLevel, (std::min)(std::stoi(name), MAX_LEVEL));
+	}
+}
+
+void MapTileEngine::SetUpGL()
+{
+	GLint maxLayers = 0;
+	glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+	m_layerCount = (std::min)(m_layerCount, static_cast<int>(maxLayers));
+
+	glGenTextures(1, &m_cache);
+	GLStateCache::GetInstance()->BindTexture(GL_TEXTURE_2D_ARRAY, m_cache);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	GpuMemoryTracker::GetInstance()->Allocate(GpuMemoryTracker::Kind::Texture, m_cache,
+		GpuMemoryTracker::GetTextureBytes(TILE_SIZE, TILE_SIZE, GL_RGBA8, true) * m_layerCount, "map tile cache");
+	glTexStorage3D(GL_TEXTURE_2D_ARRAY, MIP_LEVELS, GL_RGBA8, TILE_SIZE, TILE_SIZE, m_layerCount);
+
+	// popped from the back, the first layers are filled first
+	m_freeLayers.resize(m_layerCount);
+	for (int i = 0; i < m_layerCount; i++) {
+		m_freeLayers[i] = m_layerCount - 1 - i;
+	}
+
+	glGenBuffers(1, &m_treeBuffer);
+	glGenTextures(1, &m_treeTexture);
+	BuildTree();
+	GLStateCache::GetInstance()->BindTexture(GL_TEXTURE_BUFFER, m_treeTexture);
+	glTexBuffer(GL_TEXTURE_BUFFER, GL_RG32I, m_treeBuffer);
+}
+
+void MapTileEngine::Update(const TileProjector& projector)
+{
+	if (m_cache == 0 || m_maxLevel < 0)
+		return;
+	m_frame++;
+	Select(projector);
+	for (const TileKey& key : m_wanted) {
+		auto it = m_resident.find(key.GetId());
+		if (it != m_resident.end())
+			Touch(it->second);
+	}
+	RequestTiles();
+	UploadTiles();
+	if (m_treeDirty)
+		BuildTree();
+}
+
+void MapTileEngine::Bind(GLuint cacheUnit, GLuint treeUnit)
+{
+	auto glState = GLStateCache::GetInstance();
+	glState->ActiveTexture(GL_TEXTURE0 + cacheUnit);
+	glState->BindTexture(GL_TEXTURE_2D_ARRAY, m_cache);
+	glState->ActiveTexture(GL_TEXTURE0 + treeUnit);
+	glState->BindTexture(GL_TEXTURE_BUFFER, m_treeTexture);
+}
+
+size_t MapTileEngine::GetMemoryUsage() const
+{
+	return GpuMemoryTracker::GetTextureBytes(TILE_SIZE, TILE_SIZE, GL_RGBA8, true) * m_layerCount + m_treeBytes;
+}
+
+MapTileEngine::DecodedTile MapTileEngine::Decode(const std::string& path)
+{
+	DecodedTile tile;
+	// the cache keeps the rows from the north like the pyramid, whatever the other loaders set
+	stbi_set_flip_vertically_on_load_thread(0);
+	int width = 0, height = 0, channels = 0;
+	unsigned char* data = stbi_load(path.c_str(), &width, &height, &channels, 4);
+	if (data == nullptr)
+		return tile;
+	if (width != TILE_SIZE || height != TILE_SIZE) {
+		std::cerr << std::format("Error occur: the tile {} is {} x {}, expected {} x {}.", path, width, height, TILE_SIZE, TILE_SIZE) << std::endl;
+		stbi_image_free(data);
+		return tile;
+	}
+
+	// the mips are box filtered here so the upload does not have to generate them for the whole array
+	size_t bytes = 0;
+	for (int level = 0; level < MIP_LEVELS; level++) {
+		bytes += static_cast<size_t>(TILE_SIZE >> level) * (TILE_SIZE >> level) * 4;
+	}
+	tile.texels.resize(bytes);
+	std::copy(data, data + static_cast<size_t>(TILE_SIZE) * TILE_SIZE * 4, tile.texels.begin());
+	stbi_image_free(data);
+	uint8_t* source = tile.texels.data();
+	for (int level = 1; level < MIP_LEVELS; level++) {
+		int sourceSize = TILE_SIZE >> (level - 1);
+		int size = sourceSize / 2;
+		uint8_t* target = source + static_cast<size_t>(sourceSize) * sourceSize * 4;
+		for (int y = 0; y < size; y++) {
+			const uint8_t* row0 = source + static_cast<size_t>(2 * y) * sourceSize * 4;
+			const uint8_t* row1 = row0 + static_cast<size_t>(sourceSize) * 4;
+			for (int x = 0; x < size * 4; x++) {
+				int i = (x / 4) * 8 + x % 4;
+				target[y * size * 4 + x] = static_cast<uint8_t>((row0[i] + row0[i + 4] + row1[i] + row1[i + 4] + 2) / 4);
+			}
+		}
+		source = target;
+	}
+	tile.loaded = true;
+	return tile;
+}
+
+void MapTileEngine::Select(const TileProjector& projector)
+{
+	// breadth first, so a full budget leaves the detail even rather than deep in one corner
+	size_t budget = static_cast<size_t>(m_layerCount) * 3 / 4;
+	std::vector<float> pixelSizes{ FLT_MAX };
+	m_wanted.assign(1, TileKey{});
+	for (size_t i = 0; i < m_wanted.size(); i++) {
+		TileKey key = m_wanted[i];
+		if (key.z >= m_maxLevel || pixelSizes[i] <= TILE_SIZE * m_refineRatio || m_missing.count(key.GetId()))
+			continue;
+		if (m_wanted.size() + 4 > budget)
+			break;
+		for (int child = 0; child < 4; child++) {
+			TileKey childKey = key.GetChild(child);
+			float pixelSize = FLT_MAX;
+			if (childKey.z >= PINNED_LEVELS && !projector(childKey, pixelSize))
+				continue;
+			m_wanted.push_back(childKey);
+			pixelSizes.push_back(pixelSize);
+		}
+	}
+}
+
+void MapTileEngine::RequestTiles()
+{
+	// coarse tiles first, and a tile only after its parent so there is always something to fall back to
+	for (const TileKey& key : m_wanted) {
+		if (m_pending.size() >= MAX_PENDING)
+			break;
+		uint64_t id = key.GetId();
+		if (m_resident.count(id) || m_pending.count(id) || m_missing.count(id))
+			continue;
+		if (key.z > 0 && !m_resident.count(key.GetParent().GetId()))
+			continue;
+		std::string path = std::format("{}/{}/{}/{}.png", m_directory, key.z, key.x, key.y);
+		m_requests.push_back(Request{ key, m_decoder.Enqueue([this, path]() { return m_cancelled ? DecodedTile{} : Decode(path); }) });
+		m_pending.insert(id);
+	}
+}
+
+void MapTileEngine::UploadTiles()
+{
+	int uploads = 0;
+	auto glState = GLStateCache::GetInstance();
+	for (auto& request : m_requests) {
+		if (uploads >= m_maxUploadsPerFrame)
+			break;
+		if (request.result.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+			continue;
+		DecodedTile tile = request.result.get();
+		uint64_t id = request.key.GetId();
+		m_pending.erase(id);
+		if (!tile.loaded) {
+			m_missing.insert(id);
+			continue;
+		}
+		// without a layer the tile is dropped and requested again once one is free
+		int layer = AcquireLayer();
+		if (layer < 0)
+			continue;
+
+		glState->BindTexture(GL_TEXTURE_2D_ARRAY, m_cache);
+		const uint8_t* texels = tile.texels.data();
+		for (int level = 0; level < MIP_LEVELS; level++) {
+			int size = TILE_SIZE >> level;
+			glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, size, size, 1, GL_RGBA, GL_UNSIGNED_BYTE, texels);
+			texels += static_cast<size_t>(size) * size * 4;
+		}
+		Resident& resident = m_resident[id];
+		resident.layer = layer;
+		resident.pinned = request.key.z < PINNED_LEVELS;
+		if (!resident.pinned)
+			resident.lru = m_lru.insert(m_lru.begin(), id);
+		Touch(resident);
+		m_treeDirty = true;
+		m_uploadedCount++;
+		uploads++;
+	}
+	std::erase_if(m_requests, [](const Request& request) { return !request.result.valid(); });
+}
+
+int MapTileEngine::AcquireLayer()
+{
+	if (!m_freeLayers.empty()) {
+		int layer = m_freeLayers.back();
+		m_freeLayers.pop_back();
+		return layer;
+	}
+	// the tiles wanted this frame stay, the tree stops at their budget so there is room for the rest
+	if (m_lru.empty())
+		return -1;
+	auto it = m_resident.find(m_lru.back());
+	if (it->second.lastUsed == m_frame)
+		return -1;
+	int layer = it->second.layer;
+	m_lru.pop_back();
+	m_resident.erase(it);
+	m_evictedCount++;
+	m_treeDirty = true;
+	return layer;
+}
+
+void MapTileEngine::Touch(Resident& resident)
+{
+	resident.lastUsed = m_frame;
+	if (!resident.pinned)
+		m_lru.splice(m_lru.begin(), m_lru, resident.lru);
+}
+
+void MapTileEngine::BuildTree()
+{
+	// the resident tiles and all their ancestors become nodes, the path to an evicted parent is still walked
+	std::unordered_set<uint64_t> nodes{ TileKey{}.GetId() };
+	for (const auto& [id, resident] : m_resident) {
+		TileKey key{ static_cast<int>(id >> 58), static_cast<int>((id >> 29) & 0x1FFFFFFF), static_cast<int>(id & 0x1FFFFFFF) };
+		while (key.z > 0 && nodes.insert(key.GetId()).second) {
+			key = key.GetParent();
+		}
+	}
+
+	auto GetLayer = [this](const TileKey& key) {
+		auto it = m_resident.find(key.GetId());
+		return it != m_resident.end() ? it->second.layer : -1;
+		};
+	m_treeNodes.assign(1, glm::ivec2(-1, GetLayer(TileKey{})));
+	std::vector<std::pair<TileKey, int>> queue{ { TileKey{}, 0 } };
+	for (size_t i = 0; i < queue.size(); i++) {
+		auto [key, node] = queue[i];
+		bool hasChildren = false;
+		for (int child = 0; child < 4; child++) {
+			hasChildren |= nodes.count(key.GetChild(child).GetId()) > 0;
+		}
+		if (!hasChildren)
+			continue;
+		int firstChild = static_cast<int>(m_treeNodes.size());
+		m_treeNodes[node].x = firstChild;
+		for (int child = 0; child < 4; child++) {
+			TileKey childKey = key.GetChild(child);
+			m_treeNodes.emplace_back(-1, GetLayer(childKey));
+			if (nodes.count(childKey.GetId()))
+				queue.emplace_back(childKey, firstChild + child);
+		}
+	}
+
+	m_treeBytes = m_treeNodes.size() * sizeof(glm::ivec2);
+	GpuMemoryTracker::GetInstance()->Allocate(GpuMemoryTracker::Kind::Buffer, m_treeBuffer, m_treeBytes, "map tile tree");
+	glBindBuffer(GL_TEXTURE_BUFFER, m_treeBuffer);
+	glBufferData(GL_TEXTURE_BUFFER, m_treeBytes, m_treeNodes.data(), GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+	m_treeDirty = false;
+}
+
+void MapTileEngine::ImGuiCallback()
+{
+	static bool isFolded = true;
+	if (ImGui::CollapsingHeader("Map Tiles", &isFolded, ImGuiTreeNodeFlags_DefaultOpen))  // default open
+	{
+		if (m_maxLevel < 0) {
+			ImGui::Text("No tiles in %s", m_directory.c_str());
+			return;
+		}
+		ImGui::Text("Levels 0 - %d, %zu tiles wanted", m_maxLevel, m_wanted.size());
+		ImGui::Text("%zu / %d layers resident, %zu decoding", m_resident.size(), m_layerCount, m_pending.size());
+		ImGui::Text("%zu uploaded, %zu evicted, %zu missing", m_uploadedCount, m_evictedCount, m_missing.size());
+		ImGui::SliderFloat("Refine Ratio", &m_refineRatio, 0.5f, 4.0f, "%.2f", ImGuiSliderFlags_Logarithmic);
+		if (ImGui::IsItemHovered())
+			ImGui::SetTooltip("A tile is replaced by its children once it spans more than this many screen pixels per texel");
+		ImGui::SliderInt("Uploads Per Frame", &m_maxUploadsPerFrame, 1, 32);
+		if (ImGui::IsItemHovered())
+			ImGui::SetTooltip("Decoded tiles uploaded into the cache per frame, the rest wait for the next frames");
+	}
+}
+RENDERABLE_END
@@ -0,0 +1,118 @@
+#pragma once
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <list>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <future>
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+#include "common.h"
+#include "../threadpool/threadpool.h"
+
+RENDERABLE_BEGIN
+// Streams a slippy map pyramid of z/x/y.png tiles (256 x 256, rows counted from the north) for MapObj.
+// Every frame the quadtree is refined breadth first where a tile covers more screen pixels than it has texels,
+// the wanted tiles are decoded with stb_image on worker threads and uploaded into the layers of one texture
+// array, a cache that evicts the least recently wanted tile. The resident tiles are published as a flat quadtree
+// in a buffer texture, map_fs.glsl walks it down to the finest resident tile over every fragment, so a parent
+// keeps being drawn until its children arrive. The context thread never waits for a file: decodes are polled
+// and only a bounded number of tiles is uploaded per frame.
+class MapTileEngine
+{
+public:
+	struct TileKey {
+		int z = 0;
+		int x = 0;
+		int y = 0;
+
+		uint64_t GetId() const { return (static_cast<uint64_t>(z) << 58) | (static_cast<uint64_t>(x) << 29) | static_cast<uint64_t>(y); }
+		TileKey GetParent() const { return TileKey{ z - 1, x >> 1, y >> 1 }; }
+		// children in the order of the tree nodes, bit 0 east, bit 1 south
+		TileKey GetChild(int i) const { return TileKey{ z + 1, 2 * x + (i & 1), 2 * y + (i >> 1) }; }
+	};
+
+	// returns false when no part of the tile can be seen, pixelSize is the edge length of the tile on screen
+	using TileProjector = std::function<bool(const TileKey& key, float& pixelSize)>;
+
+	explicit MapTileEngine(const std::string& directory, int layerCount = DEFAULT_LAYER_COUNT);
+	~MapTileEngine();
+	MapTileEngine(const MapTileEngine&) = delete;
+	MapTileEngine& operator=(const MapTileEngine&) = delete;
+
+	// finds the zoom levels in the directory, touches only the file system and may run on a loader thread
+	void ScanLevels();
+	// creates the tile cache and the tree buffer
+	void SetUpGL();
+	// selects the tiles for this frame, requests the missing ones and uploads the decoded ones, once a frame
+	void Update(const TileProjector& projector);
+	void Bind(GLuint cacheUnit, GLuint treeUnit);
+	size_t GetMemoryUsage() const;
+	void ImGuiCallback();
+
+	static constexpr int TILE_SIZE = 256;
+	static constexpr int MAX_LEVEL = 22;  // the uv of a fragment has no more bits
+	static constexpr int DEFAULT_LAYER_COUNT = 128;
+
+private:
+	struct Resident {
+		int layer = 0;
+		uint64_t lastUsed = 0;
+		bool pinned = false;
+		std::list<uint64_t>::iterator lru{};
+	};
+
+	struct DecodedTile {
+		bool loaded = false;
+		std::vector<uint8_t> texels{};  // rgba of every mip level, the largest first
+	};
+
+	struct Request {
+		TileKey key{};
+		std::future<DecodedTile> result{};
+	};
+
+	static DecodedTile Decode(const std::string& path);
+	void Select(const TileProjector& projector);
+	void RequestTiles();
+	void UploadTiles();
+	int AcquireLayer();
+	void Touch(Resident& resident);
+	void BuildTree();
+
+private:
+	static constexpr int MIP_LEVELS = 9;  // 256 down to 1
+	static constexpr int PINNED_LEVELS = 2;  // the tiles above are kept as the last fallback and always refined
+	static constexpr size_t DECODE_THREADS = 2;
+	static constexpr size_t MAX_PENDING = 16;
+
+	std::string m_directory = "";
+	int m_maxLevel = -1;
+	int m_layerCount = 0;
+	GLuint m_cache = 0;
+	GLuint m_treeBuffer = 0;
+	GLuint m_treeTexture = 0;
+	size_t m_treeBytes = 0;
+
+	std::unordered_map<uint64_t, Resident> m_resident{};
+	std::list<uint64_t> m_lru{};  // unpinned resident tiles, the most recently wanted first
+	std::vector<int> m_freeLayers{};
+	std::unordered_set<uint64_t> m_missing{};
+	std::unordered_set<uint64_t> m_pending{};
+	std::vector<Request> m_requests{};
+	std::vector<TileKey> m_wanted{};
+	std::vector<glm::ivec2> m_treeNodes{};  // first child, -1 for a leaf, and layer, -1 while not resident
+	bool m_treeDirty = true;
+	uint64_t m_frame = 0;
+	std::atomic<bool> m_cancelled = false;  // set on destruction, the queued decodes return without reading their file
+
+	float m_refineRatio = 1.0f;
+	int m_maxUploadsPerFrame = 4;
+	size_t m_uploadedCount = 0;
+	size_t m_evictedCount = 0;
+
+	ThreadPool m_decoder{ DECODE_THREADS };  // declared last, joined before the members its tasks read
+};
+RENDERABLE_END
@@ -10,7 +10,7 @@ Rectangle2DObj::Rectangle2DObj(std::shared_ptr<Parser::RenderObjConfigBase> base
 	SetUpGLStatus();
 }
 
-void Rectangle2DObj::DrawObj(const std::unordered_map<std::string, std::any>& uniform)
+void Rectangle2DObj::DrawObj(const FrameContext& /*frame*/)
 {
 	m_shader->Use();
 	RenderObjectNaive::Draw();
@@ -18,7 +18,7 @@ void Rectangle2DObj::DrawObj(const std::unordered_map<std::string, std::any>& un
 
 void Rectangle2DObj::SetUpGLStatus()
 {
-	glDisable(GL_DEPTH_TEST);
+	GLStateCache::GetInstance()->Disable(GL_DEPTH_TEST);
 }
 
 void Rectangle2DObj::SetUpData()
@@ -3,11 +3,14 @@
 #include <vector>
 #include <string>
 #include <unordered_map>
-#include <any>
 
 #include "../draw/shader_s.h"
+#include "../draw/frame_context.h"
 #include "../draw/texture.h"
+#include "../draw/gl_state_cache.h"
+#include "../draw/draw_batcher.h"
 #include "../parser/config_parser.h"
+#include "../utils/gpu_memory.h"
 
 #define RENDERABLE_BEGIN namespace Renderable {
 #define RENDERABLE_END }
@@ -25,13 +28,23 @@ struct VertexInfo {
 	uint32_t offset = 0;
 	uint32_t stride = 0;
 
+	bool operator==(const VertexInfo&) const = default;
 };
 
 class RenderObjectBase {
 public:
-	virtual ~RenderObjectBase() = default;
-	virtual void DrawObj(const std::unordered_map<std::string, std::any>& uniform) = 0;
+	// runs after the members of the derived object released their gpu resources
+	virtual ~RenderObjectBase() { GpuMemoryTracker::GetInstance()->RemoveOwner(this); };
+	virtual void DrawObj(const FrameContext& frame) = 0;
 	virtual void ImGuiCallback() {};
+	// objects with heavy assets are built in two steps after construction: LoadData runs on a
+	// worker thread and must not touch GL, SetUpGL runs afterwards on the context thread
+	virtual void LoadData() {};
+	virtual void SetUpGL() {};
+	// approximate bytes held on the cpu and gpu, used to bound the scene cache
+	virtual size_t GetMemoryUsage() const { return 0; };
+	// batched objects only queue their draw in DrawObj, it is issued by the next DrawBatcher::Flush
+	virtual bool IsBatched() const { return false; };
 
 protected:
 	virtual void Draw() = 0;
@@ -48,8 +61,22 @@ private:
 	float m_pointSize = 0.0f;
 	std::vector<vT> m_vertices;
 	std::vector<iT> m_indices;
+	std::vector<VertexInfo> m_vertexInfos;
+	std::string m_batchVertexShader = "";
+	std::string m_batchFragmentShader = "";
+	std::shared_ptr<DrawBatcher> m_batcher = nullptr;
+	uint32_t m_batchId = 0;
+	bool m_batchDirty = false;
+	size_t m_vboCapacity = 0;
+	size_t m_eboCapacity = 0;
+
+	void RegisterBatchMesh();
+	void UploadMesh(const std::vector<VertexInfo>& vertexInfos);
+	template<typename T>
+	void UploadBuffer(GLenum target, uint32_t buffer, size_t& capacity, const std::vector<T>& data, const char* label);
 
 protected:
+	glm::mat4 m_model = glm::mat4(1.0f);
 	uint32_t m_VAO = 0;
 	uint32_t m_VBO = 0;
 	uint32_t m_EBO = 0;
@@ -60,23 +87,34 @@ protected:
 	virtual void SetUpShader() {};
 	virtual void SetUpData() {};
 	virtual void SetUpTexture(int num = 0) {};
-	virtual void DrawObj(const std::unordered_map<std::string, std::any>& uniform) {};
+	virtual void DrawObj(const FrameContext& /*frame*/) {};
 	RenderObjectNaive() {};
 	RenderObjectNaive(Parser::RenderObjConfigSimple& config) {}
 	~RenderObjectNaive();
 
-	void SetLineWidth(float val) { m_lineWidth = val; }
-	void SetPointSize(float val) { m_pointSize = val; }
+	void SetLineWidth(float val) { m_lineWidth = val; m_batchDirty = true; }
+	void SetPointSize(float val) { m_pointSize = val; m_batchDirty = true; }
 	void SetVertexCount(int val) { m_vertexCount = val; }
 	void SetIndiceCount(int val) { m_indiceCount = val; }
-	void SetPrimitive(GLsizei val) { m_primitive = val; }
+	void SetPrimitive(GLsizei val) { m_primitive = val; m_batchDirty = true; }
 	const GLsizei GetPrimitive() const { return m_primitive; }
 	uint32_t GetVAO() { return m_VAO; }
 	uint32_t GetVBO() { return m_VBO; }
 	uint32_t GetEBO() { return m_EBO; }
+	// copies the mesh, the indices are kept when none are passed
 	void SetMesh(std::vector<vT>* vertices = nullptr, std::vector<VertexInfo>* vertexInfos = nullptr, std::vector<iT>* indices = nullptr);
+	// takes over the vectors, for meshes that are regenerated: the data is written into the existing buffers
+	// when it fits, so only generating it costs. Like above, empty indices keep the previous ones
+	void SetMesh(std::vector<vT>&& vertices, const std::vector<VertexInfo>& vertexInfos, std::vector<iT>&& indices = {});
 	void Draw();
+	// opts into the DrawBatcher when the config names a batch vertex shader, which reads its model matrix
+	// from the batch transforms instead of the frame context
+	void SetUpBatching(const Parser::RenderObjConfigSimple& config);
+	// queues the mesh with the batcher, returns false when the object has to be drawn directly
+	bool SubmitBatched(const FrameContext& frame);
 
+public:
+	bool IsBatched() const override { return m_batchId != 0; }
 };
 
 template<typename vT, typename iT>
@@ -88,20 +126,30 @@ inline void RenderObjectNaive<vT, iT>::SetUpShader(const std::string& vertexShad
 template<typename vT, typename iT>
 inline RenderObjectNaive<vT, iT>::~RenderObjectNaive()
 {
+	if (m_batchId != 0)
+	{
+		m_batcher->Unregister(m_batchId);
+		m_batchId = 0;
+	}
+
 	if (m_VAO > 0)
 	{
+		GLStateCache::GetInstance()->OnDeleteVertexArray(m_VAO);
 		glDeleteVertexArrays(1, &m_VAO);
 		m_VAO = 0;
 	}
 
+	auto tracker = GpuMemoryTracker::GetInstance();
 	if (m_VBO > 0)
 	{
+		tracker->Release(GpuMemoryTracker::Kind::Buffer, m_VBO);
 		glDeleteBuffers(1, &m_VBO);
 		m_VBO = 0;
 	}
 
 	if (m_EBO > 0)
 	{
+		tracker->Release(GpuMemoryTracker::Kind::Buffer, m_EBO);
 		glDeleteBuffers(1, &m_EBO);
 		m_EBO = 0;
 	}
@@ -113,12 +161,38 @@ inline void RenderObjectNaive<vT, iT>::SetMesh(std::vector<vT>* vertices, std::v
 	if ((*vertices).empty()) return;
 
 	m_vertices = *vertices;
-	m_vertexAttributeNum = (*vertexInfos)[0].offset;
-	m_vertexCount = m_vertices.size() / m_vertexAttributeNum;
-
 	if (indices) {
 		m_indices = *indices;
-		m_indiceCount = m_indices.size();
+	}
+	UploadMesh(*vertexInfos);
+}
+
+template<typename vT, typename iT>
+inline void RenderObjectNaive<vT, iT>::SetMesh(std::vector<vT>&& vertices, const std::vector<VertexInfo>& vertexInfos, std::vector<iT>&& indices)
+{
+	if (vertices.empty()) return;
+
+	m_vertices = std::move(vertices);
+	if (!indices.empty()) {
+		m_indices = std::move(indices);
+	}
+	UploadMesh(vertexInfos);
+}
+
+template<typename vT, typename iT>
+inline void RenderObjectNaive<vT, iT>::UploadMesh(const std::vector<VertexInfo>& vertexInfos)
+{
+	m_vertexAttributeNum = vertexInfos[0].offset;
+	m_vertexCount = m_vertices.size() / m_vertexAttributeNum;
+	m_indiceCount = m_indices.size();
+	m_batchDirty = true;
+
+	// the attribute pointers are part of the VAO and refer to the buffer object, not to its storage,
+	// so they only have to be set when the VAO is new or the layout changes
+	bool layoutChanged = m_VAO == 0 || vertexInfos != m_vertexInfos;
+	if (layoutChanged)
+	{
+		m_vertexInfos = vertexInfos;
 	}
 
 	if (m_VAO == 0)
@@ -136,25 +210,48 @@ inline void RenderObjectNaive<vT, iT>::SetMesh(std::vector<vT>* vertices, std::v
 		glGenBuffers(1, &m_EBO);
 	}
 
-	glBindVertexArray(m_VAO);
+	GLStateCache::GetInstance()->BindVertexArray(m_VAO);
 	glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
-	glBufferData(GL_ARRAY_BUFFER, m_vertices.size() * sizeof(vT), static_cast<void*>(m_vertices.data()), GL_STATIC_DRAW);
+	UploadBuffer(GL_ARRAY_BUFFER, m_VBO, m_vboCapacity, m_vertices, "vertex buffer");
 
 	if (m_EBO != 0)
 	{
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_indices.size() * sizeof(iT), static_cast<void*>(m_indices.data()), GL_STATIC_DRAW);
+		UploadBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO, m_eboCapacity, m_indices, "index buffer");
 	}
 
-
-	for (auto info : *vertexInfos)
+	if (layoutChanged)
 	{
-		glVertexAttribPointer(info.attributeLocation, info.count, info.type, info.normalized, info.offset * sizeof(vT), (void*)(info.stride * sizeof(info.type)));
-		glEnableVertexAttribArray(info.attributeLocation);
+		for (const auto& info : m_vertexInfos)
+		{
+			glVertexAttribPointer(info.attributeLocation, info.count, info.type, info.normalized, info.offset * sizeof(vT), (void*)(info.stride * sizeof(info.type)));
+			glEnableVertexAttribArray(info.attributeLocation);
+		}
 	}
 
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindVertexArray(0);
+	GLStateCache::GetInstance()->BindVertexArray(0);
+}
+
+template<typename vT, typename iT>
+template<typename T>
+inline void RenderObjectNaive<vT, iT>::UploadBuffer(GLenum target, uint32_t buffer, size_t& capacity, const std::vector<T>& data, const char* label)
+{
+	// the buffer has to be bound to target
+	size_t size = data.size() * sizeof(T);
+	if (size > capacity)
+	{
+		// the first upload fits the mesh exactly, a mesh that outgrows it is being regenerated and gets
+		// twice the storage so growing it step by step does not reallocate every time
+		GLenum usage = capacity == 0 ? GL_STATIC_DRAW : GL_DYNAMIC_DRAW;
+		capacity = capacity == 0 ? size : (std::max)(size, capacity * 2);
+		GpuMemoryTracker::GetInstance()->Allocate(GpuMemoryTracker::Kind::Buffer, buffer, capacity, label);
+		glBufferData(target, capacity, nullptr, usage);
+	}
+	if (size > 0)
+	{
+		glBufferSubData(target, 0, size, data.data());
+	}
 }
 
 template<typename vT, typename iT>
@@ -170,19 +267,20 @@ inline void RenderObjectNaive<vT, iT>::Draw()
 		return;
 	}
 
+	auto glState = GLStateCache::GetInstance();
 	if (m_VAO > 0)
 	{
-		glBindVertexArray(m_VAO);
+		glState->BindVertexArray(m_VAO);
 	}
 
 	if (m_lineWidth > 0.0f)
 	{
-		glLineWidth(m_lineWidth);
+		glState->LineWidth(m_lineWidth);
 	}
 
 	if (m_pointSize > 0.0f)
 	{
-		glPointSize(m_pointSize);
+		glState->PointSize(m_pointSize);
 	}
 
 	if (!m_indices.empty())
@@ -193,7 +291,61 @@ inline void RenderObjectNaive<vT, iT>::Draw()
 	{
 		glDrawArrays(m_primitive, 0, static_cast<GLsizei>(m_vertexCount));
 	}
-	glBindVertexArray(0);
+	glState->BindVertexArray(0);
+}
+
+template<typename vT, typename iT>
+inline void RenderObjectNaive<vT, iT>::SetUpBatching(const Parser::RenderObjConfigSimple& config)
+{
+	if (config.batchVertexShader.empty())
+		return;
+	m_batchVertexShader = config.batchVertexShader;
+	m_batchFragmentShader = config.fragmentShader;
+	m_batcher = DrawBatcher::GetInstance();
+	m_batchDirty = true;
+}
+
+template<typename vT, typename iT>
+inline void RenderObjectNaive<vT, iT>::RegisterBatchMesh()
+{
+	m_batchDirty = false;
+	if (m_batchId != 0)
+	{
+		m_batcher->Unregister(m_batchId);
+		m_batchId = 0;
+	}
+	// a point cloud would be refused by Register anyway, not worth the copy of its indices
+	if (m_vertices.empty() || m_vertexInfos.empty() || m_vertexCount > DrawBatcher::MAX_MESH_VERTICES)
+		return;
+
+	// VertexInfo keeps the stride in elements of vT and the offset in 4 byte units, see SetMesh
+	DrawBatcher::Key key;
+	key.vertexShader = m_batchVertexShader;
+	key.fragmentShader = m_batchFragmentShader;
+	key.primitive = static_cast<GLenum>(m_primitive);
+	key.vertexSize = static_cast<uint32_t>(m_vertexAttributeNum * sizeof(vT));
+	key.lineWidth = m_lineWidth;
+	key.pointSize = m_pointSize;
+	for (const auto& info : m_vertexInfos)
+	{
+		key.attributes.push_back({ info.attributeLocation, static_cast<GLint>(info.count), info.type,
+			static_cast<GLboolean>(info.normalized), static_cast<uint32_t>(info.stride * sizeof(info.type)) });
+	}
+	std::vector<uint32_t> indices(m_indices.begin(), m_indices.end());
+	m_batchId = m_batcher->Register(key, m_vertices.data(), static_cast<uint32_t>(m_vertexCount), indices);
+}
+
+template<typename vT, typename iT>
+inline bool RenderObjectNaive<vT, iT>::SubmitBatched(const FrameContext& frame)
+{
+	if (!m_batcher)
+		return false;
+	if (m_batchDirty)
+		RegisterBatchMesh();
+	if (m_batchId == 0)
+		return false;
+	m_batcher->Submit(m_batchId, frame.model * m_model);
+	return true;
 }
 RENDERABLE_END
 
@@ -1,4 +1,5 @@
 #include "sphere_obj.h"
+#include "../utils/sampling.h"
 
 RENDERABLE_BEGIN
 SphereObj::SphereObj(std::shared_ptr<Parser::RenderObjConfigBase> baseConfigPtr)
@@ -6,29 +7,27 @@ SphereObj::SphereObj(std::shared_ptr<Parser::RenderObjConfigBase> baseConfigPtr)
 	SetUpData();
 	auto ConfigPtr = std::static_pointer_cast<Parser::RenderObjConfigSimple>(baseConfigPtr);
 	SetUpShader(ConfigPtr->vertexShader, ConfigPtr->fragmentShader);
+	SetUpBatching(*ConfigPtr);
 	SetUpAABB();
 }
 
-void SphereObj::DrawObj(const std::unordered_map<std::string, std::any>& uniform)
+void SphereObj::DrawObj(const FrameContext& frame)
 {
-	m_shader->Use();
-	auto projection = std::any_cast<glm::mat4>(uniform.at("projection"));
-	auto view = std::any_cast<glm::mat4>(uniform.at("view"));
-	auto model = std::any_cast<glm::mat4>(uniform.at("model"));
-	m_shader->SetMat4("projection", projection);
-	m_shader->SetMat4("view", view);
-	m_shader->SetMat4("model", model);
-	RenderObjectNaive::Draw();
+	if (!SubmitBatched(frame)) {
+		m_shader->Use();
+		RenderObjectNaive::Draw();
+	}
 
 	if (m_imguiParams.showAABB) {
-		m_aabbObj->DrawObj(uniform);
+		m_aabbObj->DrawObj(frame);
 	}
 }
 
 void SphereObj::ImGuiCallback()
 {
 	bool changed = false;
-	changed |= ImGui::SliderInt("number", &m_number, 0, 100000);
+	changed |= ImGui::SliderInt("number", &m_number, 0, 20000000, "%d", ImGuiSliderFlags_Logarithmic);
+	changed |= ImGui::InputInt("seed", &m_seed);
 	if (changed |= ImGui::SliderFloat("radius", &m_radius, 0.0, 5.0)) {
 		SetUpAABB();
 	}
@@ -39,25 +38,15 @@ void SphereObj::ImGuiCallback()
 
 void SphereObj::SetUpData()
 {
-	unsigned seed = static_cast<unsigned int>(std::chrono::system_clock::now().time_since_epoch().count());
-	std::mt19937 generator(seed);
-	auto m_uniform01 = std::uniform_real_distribution<float>(0.0, 1.0);
+	// the same seed gives the same points, so dragging the radius scales the cloud instead of reshuffling it
 	std::vector<glm::vec3> vertices;
-
-	for (int i = 0; i < m_number; i++) {
-		float theta = 2 * M_PI * m_uniform01(generator);
-		float phi = acos(1 - 2 * m_uniform01(generator));
-		float x = sin(phi) * cos(theta) * m_radius;
-		float y = sin(phi) * sin(theta) * m_radius;
-		float z = cos(phi) * m_radius;
-		vertices.emplace_back(glm::vec3(x, y, z));
-	}
+	PointSampler::GetInstance()->SampleSurface(static_cast<uint64_t>(m_seed), glm::mat3(m_radius), static_cast<size_t>(m_number), vertices);
 
 	std::vector<VertexInfo> vertexInfo = std::vector<VertexInfo>{
 		{"aPos", 0, 3, GL_FLOAT, GL_FALSE, 1, 0},
 	};
 
-	SetMesh(&vertices, &vertexInfo);
+	SetMesh(std::move(vertices), vertexInfo);
 	SetPrimitive(GL_POINTS);
 }
 
@@ -28,7 +28,7 @@ class SphereObj : public RenderObjectNaive<glm::vec3, uint32_t> {
 
 public:
 	SphereObj(std::shared_ptr<Parser::RenderObjConfigBase> baseConfigPtr);
-	void DrawObj(const std::unordered_map<std::string, std::any>& uniform);
+	void DrawObj(const FrameContext& frame);
 	virtual void ImGuiCallback();
 	~SphereObj() = default;
 
@@ -38,6 +38,7 @@ private:
 
 private:
 	int m_number = 10000;
+	int m_seed = 0;
 	float m_radius = 1.0;
 	std::shared_ptr<AABBObj> m_aabbObj = nullptr;
 
@@ -0,0 +1,100 @@
+#pragma once
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <type_traits>
+#include <algorithm>
+
+// Fixed size pool of worker threads consuming a FIFO task queue.
+class ThreadPool
+{
+public:
+	explicit ThreadPool(size_t threadCount = (std::max)(std::thread::hardware_concurrency(), 1u))
+	{
+		for (size_t i = 0; i < threadCount; i++) {
+			m_workers.emplace_back([this]() { WorkerLoop(); });
+		}
+	}
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_stop = true;
+		}
+		m_taskCondition.notify_all();
+		for (auto& worker : m_workers) {
+			worker.join();
+		}
+	}
+
+	template <typename F, typename... Args>
+	auto Enqueue(F&& func, Args&&... args) -> std::future<std::invoke_result_t<F, Args...>>
+	{
+		using ReturnType = std::invoke_result_t<F, Args...>;
+		auto task = std::make_shared<std::packaged_task<ReturnType()>>(
+			std::bind(std::forward<F>(func), std::forward<Args>(args)...));
+		std::future<ReturnType> result = task->get_future();
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_tasks.emplace([task]() { (*task)(); });
+			m_pendingCount++;
+		}
+		m_taskCondition.notify_one();
+		return result;
+	}
+
+	// blocks until every queued task has finished
+	void WaitIdle()
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_idleCondition.wait(lock, [this]() { return m_pendingCount == 0; });
+	}
+
+	size_t GetThreadCount() const { return m_workers.size(); }
+
+	size_t GetPendingCount()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_pendingCount;
+	}
+
+private:
+	void WorkerLoop()
+	{
+		while (true) {
+			std::function<void()> task;
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_taskCondition.wait(lock, [this]() { return m_stop || !m_tasks.empty(); });
+				if (m_stop && m_tasks.empty())
+					return;
+				task = std::move(m_tasks.front());
+				m_tasks.pop();
+			}
+			task();
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_pendingCount--;
+			}
+			m_idleCondition.notify_all();
+		}
+	}
+
+private:
+	std::vector<std::thread> m_workers{};
+	std::queue<std::function<void()>> m_tasks{};
+	std::mutex m_mutex;
+	std::condition_variable m_taskCondition;
+	std::condition_variable m_idleCondition;
+	size_t m_pendingCount = 0;
+	bool m_stop = false;
+};
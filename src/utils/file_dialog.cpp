@@ -0,0 +1,49 @@
+#include "file_dialog.h"
+
+#include <iostream>
+#include <filesystem>
+#ifdef _WIN32
+#include <windows.h>
+#include <commdlg.h>
+#endif
+
+#ifdef _WIN32
+static bool GetOFNPath(std::string& path, bool isSave)
+{
+	TCHAR szFile[MAX_PATH] = { 0 };
+	OPENFILENAME ofn;
+	ZeroMemory(&ofn, sizeof(ofn));
+
+	ofn.lStructSize = sizeof(ofn);
+	ofn.hwndOwner = NULL;
+	ofn.lpstrFilter = TEXT("Text Files\0*.TXT\0All Files\0*.*\0");
+	ofn.lpstrFile = szFile;
+	ofn.nFilterIndex = 1;
+	ofn.nMaxFile = MAX_PATH;
+	ofn.Flags = OFN_EXPLORER | OFN_PATHMUSTEXIST | OFN_OVERWRITEPROMPT | OFN_HIDEREADONLY;
+	ofn.lpstrDefExt = TEXT("txt\0json");
+	ofn.lpstrFileTitle = NULL;
+	ofn.nMaxFileTitle = 0;
+	ofn.lpstrInitialDir = NULL;
+	bool selected = isSave ? GetSaveFileName(&ofn) : GetOpenFileName(&ofn);
+	if (selected)
+		path = std::filesystem::path(szFile).string();
+	return selected;
+}
+#else
+static bool GetOFNPath(std::string& /*path*/, bool /*isSave*/)
+{
+	std::cerr << "File dialogs are only available on Windows, pass the path on the command line instead" << std::endl;
+	return false;
+}
+#endif
+
+bool OpenFileDialog(std::string& path)
+{
+	return GetOFNPath(path, false);
+}
+
+bool SaveFileDialog(std::string& path)
+{
+	return GetOFNPath(path, true);
+}
@@ -0,0 +1,7 @@
+#pragma once
+#include <string>
+
+// Native file dialogs. Only implemented on Windows, elsewhere they report that the path has to be
+// passed on the command line and return false, which keeps headless builds free of platform headers.
+bool OpenFileDialog(std::string& path);
+bool SaveFileDialog(std::string& path);
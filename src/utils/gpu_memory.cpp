@@ -0,0 +1,250 @@
+#include "gpu_memory.h"
+
+#include <iostream>
+#include <format>
+#include <vector>
+#include <algorithm>
+#include <imgui/imgui.h>
+
+static double ToMB(size_t bytes)
+{
+	return bytes / (1024.0 * 1024.0);
+}
+
+std::shared_ptr<GpuMemoryTracker> GpuMemoryTracker::GetInstance()
+{
+	static std::mutex mutex;
+	std::lock_guard<std::mutex> lock(mutex);
+	if (m_instance == nullptr) {
+		m_instance = std::make_shared<GpuMemoryTracker>();
+	}
+	return m_instance;
+}
+
+void GpuMemoryTracker::Allocate(Kind kind, uint32_t obj, size_t bytes, const char* label)
+{
+	auto it = m_resources.find(GetKey(kind, obj));
+	size_t previous = it != m_resources.end() ? it->second.bytes : 0;
+	const void* owner = it != m_resources.end() ? it->second.owner : m_currentOwner;
+	if (m_budget > 0 && bytes > previous && m_total - previous + bytes > m_budget) {
+		std::string message = std::format("{:.1f} MB for the {} of {} would exceed the GPU memory budget, {:.1f} of {:.1f} MB are in use",
+			ToMB(bytes), label, GetOwnerName(owner), ToMB(m_total), ToMB(m_budget));
+		if (m_enforceBudget && m_refuseOverBudget) {
+			m_refusedCount++;
+			throw GpuBudgetExceeded(message);
+		}
+		// once per excursion, resizes would repeat it every frame
+		if (!m_warned)
+			std::cerr << std::format("Warning: {}", message) << std::endl;
+		m_warned = true;
+	}
+
+	if (it == m_resources.end()) {
+		it = m_resources.emplace(GetKey(kind, obj), Resource{ 0, owner, label }).first;
+		m_owners[owner].resourceCount++;
+	}
+	Owner& entry = m_owners[owner];
+	entry.bytes = entry.bytes - previous + bytes;
+	m_kindTotals[static_cast<size_t>(kind)] = m_kindTotals[static_cast<size_t>(kind)] - previous + bytes;
+	m_total = m_total - previous + bytes;
+	m_peak = (std::max)(m_peak, m_total);
+	it->second.bytes = bytes;
+}
+
+void GpuMemoryTracker::Release(Kind kind, uint32_t obj)
+{
+	auto it = m_resources.find(GetKey(kind, obj));
+	if (it == m_resources.end())
+		return;
+	const Resource& resource = it->second;
+	auto owner = m_owners.find(resource.owner);
+	if (owner != m_owners.end()) {
+		owner->second.bytes -= resource.bytes;
+		owner->second.resourceCount--;
+	}
+	m_kindTotals[static_cast<size_t>(kind)] -= resource.bytes;
+	m_total -= resource.bytes;
+	m_resources.erase(it);
+	if (m_total <= m_budget)
+		m_warned = false;
+}
+
+void GpuMemoryTracker::SetLabel(Kind kind, uint32_t obj, const char* label)
+{
+	auto it = m_resources.find(GetKey(kind, obj));
+	if (it != m_resources.end())
+		it->second.label = label;
+}
+
+void GpuMemoryTracker::SetOwnerName(const void* owner, const std::string& name)
+{
+	m_owners[owner].name = name;
+}
+
+void GpuMemoryTracker::RemoveOwner(const void* owner)
+{
+	auto it = m_owners.find(owner);
+	if (it == m_owners.end())
+		return;
+	// resources the owner handed on, like shared buffers, are left unowned
+	if (it->second.resourceCount > 0) {
+		Owner& unowned = m_owners[nullptr];
+		for (auto& [key, resource] : m_resources) {
+			if (resource.owner != owner)
+				continue;
+			resource.owner = nullptr;
+			unowned.bytes += resource.bytes;
+			unowned.resourceCount++;
+		}
+	}
+	m_owners.erase(owner);
+}
+
+void GpuMemoryTracker::TransferOwner(const void* from, const void* to)
+{
+	auto it = m_owners.find(from);
+	if (it == m_owners.end() || from == to)
+		return;
+	Owner moved = std::move(it->second);
+	m_owners.erase(it);
+	for (auto& [key, resource] : m_resources) {
+		if (resource.owner == from)
+			resource.owner = to;
+	}
+	Owner& entry = m_owners[to];
+	entry.bytes += moved.bytes;
+	entry.resourceCount += moved.resourceCount;
+	if (entry.name.empty())
+		entry.name = std::move(moved.name);
+}
+
+size_t GpuMemoryTracker::GetOwnerTotal(const void* owner) const
+{
+	auto it = m_owners.find(owner);
+	return it != m_owners.end() ? it->second.bytes : 0;
+}
+
+const char* GpuMemoryTracker::GetOwnerName(const void* owner) const
+{
+	auto it = m_owners.find(owner);
+	if (owner == nullptr || it == m_owners.end() || it->second.name.empty())
+		return owner == nullptr ? "renderer" : "unnamed object";
+	return it->second.name.c_str();
+}
+
+size_t GpuMemoryTracker::GetTextureBytes(int width, int height, GLenum internalFormat, bool mipmapped)
+{
+	size_t texelBytes = 4;
+	switch (internalFormat) {
+	case GL_R8:
+		texelBytes = 1;
+		break;
+	case GL_RG8:
+	case GL_R16F:
+		texelBytes = 2;
+		break;
+	case GL_RGBA16F:
+	case GL_RG32F:
+	case GL_RGBA16:
+		texelBytes = 8;
+		break;
+	case GL_RGB32F:
+		texelBytes = 12;
+		break;
+	case GL_RGBA32F:
+	case GL_RGBA32UI:
+	case GL_RGBA32I:
+		texelBytes = 16;
+		break;
+	default:
+		// 8 bit rgb is padded to 4 bytes, the 24 bit depth formats to 32 bit
+		break;
+	}
+	size_t bytes = static_cast<size_t>(width) * height * texelBytes;
+	return mipmapped ? bytes + bytes / 3 : bytes;
+}
+
+const char* GpuMemoryTracker::GetBufferLabel(GLenum target)
+{
+	switch (target) {
+	case GL_ARRAY_BUFFER:
+		return "vertex buffer";
+	case GL_ELEMENT_ARRAY_BUFFER:
+		return "index buffer";
+	case GL_SHADER_STORAGE_BUFFER:
+		return "storage buffer";
+	case GL_ATOMIC_COUNTER_BUFFER:
+		return "atomic counter buffer";
+	case GL_UNIFORM_BUFFER:
+		return "uniform buffer";
+	case GL_PIXEL_PACK_BUFFER:
+		return "pixel pack buffer";
+	default:
+		return "buffer";
+	}
+}
+
+void GpuMemoryTracker::ImGuiCallback()
+{
+	static bool isFolded = true;
+	if (ImGui::CollapsingHeader("GPU Memory", &isFolded, ImGuiTreeNodeFlags_DefaultOpen))  // default open
+	{
+		ImGui::Text("%.1f MB in %zu resources, peak %.1f MB", ToMB(m_total), m_resources.size(), ToMB(m_peak));
+		ImGui::Text("Buffers %.1f MB, textures %.1f MB", ToMB(GetTotal(Kind::Buffer)), ToMB(GetTotal(Kind::Texture)));
+		int budgetMB = static_cast<int>(m_budget >> 20);
+		if (ImGui::InputInt("GPU Budget (MB)", &budgetMB, 256, 1024))
+			SetBudget(static_cast<size_t>((std::max)(budgetMB, 0)) << 20);
+		if (ImGui::IsItemHovered())
+			ImGui::SetTooltip("0 disables the budget");
+		ImGui::Checkbox("Refuse Over Budget", &m_refuseOverBudget);
+		if (ImGui::IsItemHovered())
+			ImGui::SetTooltip("Objects of a scene that would exceed the budget are not loaded, otherwise it only warns");
+		if (m_budget > 0) {
+			std::string overlay = std::format("{:.1f} / {:.1f} MB", ToMB(m_total), ToMB(m_budget));
+			ImGui::ProgressBar(static_cast<float>(m_total) / m_budget, ImVec2(-1.0f, 0.0f), overlay.c_str());
+		}
+		if (m_refusedCount > 0)
+			ImGui::Text("%zu allocations refused", m_refusedCount);
+
+		std::vector<std::pair<const void*, const Owner*>> owners;
+		for (const auto& [owner, entry] : m_owners) {
+			if (entry.bytes > 0)
+				owners.emplace_back(owner, &entry);
+		}
+		size_t ownerCount = (std::min)(owners.size(), TOP_CONSUMERS);
+		std::partial_sort(owners.begin(), owners.begin() + ownerCount, owners.end(), [](const auto& a, const auto& b) { return a.second->bytes > b.second->bytes; });
+		ImGui::Text("Top consumers");
+		for (size_t i = 0; i < ownerCount; i++) {
+			ImGui::BulletText("%s: %.1f MB in %zu resources", GetOwnerName(owners[i].first), ToMB(owners[i].second->bytes), owners[i].second->resourceCount);
+		}
+
+		std::vector<const Resource*> resources;
+		resources.reserve(m_resources.size());
+		for (const auto& [key, resource] : m_resources) {
+			resources.push_back(&resource);
+		}
+		size_t resourceCount = (std::min)(resources.size(), TOP_CONSUMERS);
+		std::partial_sort(resources.begin(), resources.begin() + resourceCount, resources.end(), [](const Resource* a, const Resource* b) { return a->bytes > b->bytes; });
+		ImGui::Text("Largest resources");
+		for (size_t i = 0; i < resourceCount; i++) {
+			ImGui::BulletText("%s of %s: %.1f MB", resources[i]->label, GetOwnerName(resources[i]->owner), ToMB(resources[i]->bytes));
+		}
+	}
+}
+
+GpuMemoryOwnerScope::GpuMemoryOwnerScope(const void* owner, bool enforceBudget)
+{
+	// scopes are opened around every object each frame, the instance is looked up once
+	static GpuMemoryTracker* const TRACKER = GpuMemoryTracker::GetInstance().get();
+	m_tracker = TRACKER;
+	m_previousOwner = m_tracker->m_currentOwner;
+	m_previousEnforceBudget = m_tracker->m_enforceBudget;
+	m_tracker->m_currentOwner = owner;
+	m_tracker->m_enforceBudget = enforceBudget;
+}
+
+GpuMemoryOwnerScope::~GpuMemoryOwnerScope()
+{
+	m_tracker->m_currentOwner = m_previousOwner;
+	m_tracker->m_enforceBudget = m_previousEnforceBudget;
+}
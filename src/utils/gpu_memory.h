@@ -0,0 +1,110 @@
+#pragma once
+#include <glad/glad.h>
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <cstdint>
+#include <stdexcept>
+#include <unordered_map>
+
+// thrown by GpuMemoryTracker::Allocate when an allocation inside an enforcing owner scope would exceed the budget
+class GpuBudgetExceeded : public std::runtime_error
+{
+public:
+	using std::runtime_error::runtime_error;
+};
+
+// Bookkeeping of the GL buffer and texture storage the renderer allocates, per resource and per owning render object.
+// The sizes are what was requested from GL, drivers may pad or compress them, so the totals are an estimate of the VRAM in use.
+// Resources are recorded by the code that allocates them and charged to the owner of the innermost GpuMemoryOwnerScope.
+// With a budget set, allocations that would exceed it are reported once; inside an enforcing scope, as used while a scene
+// is set up, they are refused with GpuBudgetExceeded before anything is allocated. Only call it from the context thread.
+class GpuMemoryTracker
+{
+public:
+	enum class Kind : uint32_t {
+		Buffer = 0,
+		Texture,
+		Count
+	};
+
+	static std::shared_ptr<GpuMemoryTracker> GetInstance();
+	GpuMemoryTracker() = default;
+	GpuMemoryTracker(const GpuMemoryTracker&) = delete;
+	GpuMemoryTracker& operator=(const GpuMemoryTracker&) = delete;
+
+	// records bytes of storage for the GL object, call it before the storage is (re)specified. A resource that is already
+	// tracked is resized and keeps its owner and label, label has to outlive the resource, a string literal naming its use
+	void Allocate(Kind kind, uint32_t obj, size_t bytes, const char* label);
+	void Release(Kind kind, uint32_t obj);
+	void SetLabel(Kind kind, uint32_t obj, const char* label);
+	// names the owner in the report, the owner is forgotten by RemoveOwner once the object is gone
+	void SetOwnerName(const void* owner, const std::string& name);
+	void RemoveOwner(const void* owner);
+	// charges the resources of from to to, for objects whose allocations start before the owner exists
+	void TransferOwner(const void* from, const void* to);
+
+	// 0 for no budget
+	void SetBudget(size_t bytes) { m_budget = bytes; m_warned = false; }
+	size_t GetBudget() const { return m_budget; }
+	size_t GetTotal() const { return m_total; }
+	size_t GetTotal(Kind kind) const { return m_kindTotals[static_cast<size_t>(kind)]; }
+	size_t GetOwnerTotal(const void* owner) const;
+	void ImGuiCallback();
+
+	// bytes of a 2D texture, mipmapped adds the third of the base level the chain takes
+	static size_t GetTextureBytes(int width, int height, GLenum internalFormat, bool mipmapped = false);
+	static const char* GetBufferLabel(GLenum target);
+
+private:
+	friend class GpuMemoryOwnerScope;
+
+	struct Resource {
+		size_t bytes = 0;
+		const void* owner = nullptr;
+		const char* label = "";
+	};
+
+	struct Owner {
+		std::string name = "";
+		size_t bytes = 0;
+		size_t resourceCount = 0;
+	};
+
+	static uint64_t GetKey(Kind kind, uint32_t obj) { return (static_cast<uint64_t>(kind) << 32) | obj; }
+	const char* GetOwnerName(const void* owner) const;
+
+private:
+	static inline std::shared_ptr<GpuMemoryTracker> m_instance = nullptr;
+	static constexpr size_t TOP_CONSUMERS = 8;
+
+	std::unordered_map<uint64_t, Resource> m_resources{};
+	std::unordered_map<const void*, Owner> m_owners{};
+	size_t m_kindTotals[static_cast<size_t>(Kind::Count)]{};
+	size_t m_total = 0;
+	size_t m_peak = 0;
+	size_t m_budget = 0;
+	size_t m_refusedCount = 0;
+	bool m_refuseOverBudget = true;
+	bool m_warned = false;
+
+	const void* m_currentOwner = nullptr;
+	bool m_enforceBudget = false;
+};
+
+// charges the resources allocated during its lifetime to owner, enforceBudget lets allocations over the budget throw.
+// The innermost scope decides both
+class GpuMemoryOwnerScope
+{
+public:
+	GpuMemoryOwnerScope(const void* owner, bool enforceBudget = false);
+	~GpuMemoryOwnerScope();
+	GpuMemoryOwnerScope(const GpuMemoryOwnerScope&) = delete;
+	GpuMemoryOwnerScope& operator=(const GpuMemoryOwnerScope&) = delete;
+
+private:
+	GpuMemoryTracker* m_tracker = nullptr;
+	const void* m_previousOwner = nullptr;
+	bool m_previousEnforceBudget = false;
+};
@@ -0,0 +1,222 @@
+#include "profiler.h"
+
+#include <iostream>
+#include <format>
+#include <cfloat>
+#include <algorithm>
+#include <imgui/imgui.h>
+
+std::shared_ptr<Profiler> Profiler::GetInstance()
+{
+	static std::mutex mutex;
+	std::lock_guard<std::mutex> lock(mutex);
+	if (m_instance == nullptr) {
+		m_instance = std::make_shared<Profiler>();
+	}
+	return m_instance;
+}
+
+Profiler::~Profiler()
+{
+	// the query objects go away with the GL context, which is already gone at this point
+	StopCapture();
+}
+
+size_t Profiler::RegisterSection(const std::string& name)
+{
+	for (size_t i = 0; i < m_sections.size(); i++) {
+		if (m_sections[i].name == name)
+			return i;
+	}
+	m_sections.push_back({ name });
+	return m_sections.size() - 1;
+}
+
+void Profiler::BeginFrame()
+{
+	if (!m_enabled)
+		return;
+	m_frameStart = std::chrono::high_resolution_clock::now();
+	// resolve the finished frames oldest first, the set about to be reused holds the frame from QUERY_SETS frames ago
+	for (size_t i = 0; i < QUERY_SETS; i++) {
+		if (!ResolveFrame((m_frameIndex + i) % QUERY_SETS))
+			break;
+	}
+	// the GPU is more than QUERY_SETS frames behind, this frame is not timed rather than waiting for it
+	if (m_pending[m_frameIndex % QUERY_SETS].valid)
+		return;
+	m_current.frameIndex = m_frameIndex;
+	m_current.cpuMs.assign(m_sections.size(), 0.0f);
+	m_current.gpuMs.assign(m_sections.size(), 0.0f);
+	m_current.valid = true;
+}
+
+void Profiler::BeginPresent()
+{
+	if (!m_enabled || !m_current.valid)
+		return;
+	m_current.presentMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - m_frameStart).count();
+}
+
+void Profiler::EndFrame()
+{
+	if (!m_enabled || !m_current.valid)
+		return;
+	m_current.frameMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - m_frameStart).count();
+	if (m_current.presentMs == 0.0f)
+		m_current.presentMs = m_current.frameMs;
+	m_pending[m_frameIndex % QUERY_SETS] = std::move(m_current);
+	m_current = FrameRecord{};
+	m_frameIndex++;
+}
+
+void Profiler::AddCpuTime(size_t section, float milliseconds)
+{
+	if (!m_current.valid)
+		return;
+	if (section >= m_current.cpuMs.size())
+		m_current.cpuMs.resize(m_sections.size(), 0.0f);
+	// a section entered several times per frame accumulates
+	m_current.cpuMs[section] += milliseconds;
+}
+
+bool Profiler::BeginGpu(size_t section)
+{
+	size_t querySet = m_frameIndex % QUERY_SETS;
+	Section& entry = m_sections[section];
+	if (m_gpuScopeActive || entry.issued[querySet])
+		return false;
+	if (entry.queries[0] == 0)
+		glGenQueries(QUERY_SETS, entry.queries);
+	glBeginQuery(GL_TIME_ELAPSED, entry.queries[querySet]);
+	entry.issued[querySet] = true;
+	m_gpuScopeActive = true;
+	return true;
+}
+
+void Profiler::EndGpu()
+{
+	glEndQuery(GL_TIME_ELAPSED);
+	m_gpuScopeActive = false;
+}
+
+bool Profiler::ResolveFrame(size_t querySet)
+{
+	FrameRecord& record = m_pending[querySet];
+	if (!record.valid)
+		return true;
+	for (const Section& section : m_sections) {
+		if (!section.issued[querySet])
+			continue;
+		GLint available = GL_FALSE;
+		glGetQueryObjectiv(section.queries[querySet], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (available == GL_FALSE)
+			return false;
+	}
+
+	record.cpuMs.resize(m_sections.size(), 0.0f);
+	record.gpuMs.resize(m_sections.size(), 0.0f);
+	float gpuMs = 0.0f;
+	for (size_t i = 0; i < m_sections.size(); i++) {
+		Section& section = m_sections[i];
+		if (section.issued[querySet]) {
+			GLuint64 elapsed = 0;
+			glGetQueryObjectui64v(section.queries[querySet], GL_QUERY_RESULT, &elapsed);
+			record.gpuMs[i] = static_cast<float>(elapsed * 1e-6);
+			section.issued[querySet] = false;
+		}
+		section.cpuHistory[m_historyOffset] = record.cpuMs[i];
+		section.gpuHistory[m_historyOffset] = record.gpuMs[i];
+		gpuMs += record.gpuMs[i];
+	}
+	// GPU scopes never nest, so their sum does not count any work twice
+	m_workMs = (std::max)(record.presentMs, gpuMs);
+	m_frameHistory[m_historyOffset] = record.frameMs;
+	m_historyOffset = (m_historyOffset + 1) % HISTORY_LENGTH;
+	m_resolvedCount++;
+
+	WriteCaptureRow(record);
+	record.valid = false;
+	return true;
+}
+
+bool Profiler::StartCapture(const std::string& path)
+{
+	StopCapture();
+	m_capture.open(path);
+	if (!m_capture.is_open()) {
+		std::cerr << std::format("Error occured while opening {}", path) << std::endl;
+		return false;
+	}
+	// sections registered after this point are not part of the capture
+	m_captureColumns = m_sections.size();
+	m_capture << "frame,frame_ms";
+	for (size_t i = 0; i < m_captureColumns; i++) {
+		m_capture << std::format(",{0}_cpu_ms,{0}_gpu_ms", m_sections[i].name);
+	}
+	m_capture << "\n";
+	std::cout << std::format("Capturing frame timings to {}", path) << std::endl;
+	return true;
+}
+
+void Profiler::StopCapture()
+{
+	if (m_capture.is_open())
+		m_capture.close();
+}
+
+void Profiler::WriteCaptureRow(const FrameRecord& record)
+{
+	if (!m_capture.is_open())
+		return;
+	m_capture << std::format("{},{:.4f}", record.frameIndex, record.frameMs);
+	for (size_t i = 0; i < m_captureColumns; i++) {
+		m_capture << std::format(",{:.4f},{:.4f}", record.cpuMs[i], record.gpuMs[i]);
+	}
+	m_capture << "\n";
+}
+
+float Profiler::GetAverage(const std::vector<float>& history) const
+{
+	// mean of the most recent samples, older entries of the ring may still be empty
+	const size_t SAMPLES = (std::min)(static_cast<size_t>(60), HISTORY_LENGTH);
+	size_t count = (std::min)(m_resolvedCount, SAMPLES);
+	if (count == 0)
+		return 0.0f;
+	float sum = 0.0f;
+	for (size_t i = 1; i <= count; i++) {
+		sum += history[(m_historyOffset + HISTORY_LENGTH - i) % HISTORY_LENGTH];
+	}
+	return sum / count;
+}
+
+void Profiler::ImGuiCallback()
+{
+	static bool isFolded = true;
+	if (ImGui::CollapsingHeader("Profiler", &isFolded, ImGuiTreeNodeFlags_DefaultOpen))  // default open
+	{
+		ImGui::Checkbox("Enable Profiling", &m_enabled);
+		float frameMs = GetAverage(m_frameHistory);
+		ImGui::Text("Frame %.3f ms (%.1f fps), work %.3f ms", frameMs, frameMs > 0.0f ? 1000.0f / frameMs : 0.0f, m_workMs);
+		ImGui::PlotLines("Frame ms", m_frameHistory.data(), static_cast<int>(HISTORY_LENGTH), static_cast<int>(m_historyOffset), nullptr, 0.0f, FLT_MAX, ImVec2(0, 60));
+
+		for (size_t i = 0; i < m_sections.size(); i++) {
+			const Section& section = m_sections[i];
+			ImGui::PushID(static_cast<int>(i));
+			ImGui::Text("%s: cpu %.3f ms, gpu %.3f ms", section.name.c_str(), GetAverage(section.cpuHistory), GetAverage(section.gpuHistory));
+			ImGui::PlotLines("##cpu", section.cpuHistory.data(), static_cast<int>(HISTORY_LENGTH), static_cast<int>(m_historyOffset), "cpu", 0.0f, FLT_MAX, ImVec2(150, 30));
+			ImGui::SameLine();
+			ImGui::PlotLines("##gpu", section.gpuHistory.data(), static_cast<int>(HISTORY_LENGTH), static_cast<int>(m_historyOffset), "gpu", 0.0f, FLT_MAX, ImVec2(150, 30));
+			ImGui::PopID();
+		}
+
+		ImGui::InputText("CSV File", m_capturePath, sizeof(m_capturePath));
+		if (m_capture.is_open()) {
+			if (ImGui::Button("Stop CSV Capture"))
+				StopCapture();
+		}
+		else if (ImGui::Button("Start CSV Capture")) {
+			StartCapture(m_capturePath);
+		}
+	}
+}
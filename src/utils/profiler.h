@@ -0,0 +1,140 @@
+#pragma once
+#include <glad/glad.h>
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <mutex>
+#include <chrono>
+#include <fstream>
+
+// Per-frame CPU and GPU timings of named sections.
+// CPU time is measured by RAII scopes, GPU time by GL_TIME_ELAPSED queries kept in a ring of sets, one per frame.
+// A frame is resolved once all of its queries are available, usually two frames late, so reading them back never
+// stalls the pipeline; while the oldest set is still in flight the new frame is not timed.
+// GL_TIME_ELAPSED queries cannot nest, a GPU scope opened while another one is active only records CPU time.
+class Profiler
+{
+public:
+	static std::shared_ptr<Profiler> GetInstance();
+	Profiler() = default;
+	~Profiler();
+	Profiler(const Profiler&) = delete;
+	Profiler& operator=(const Profiler&) = delete;
+
+	size_t RegisterSection(const std::string& name);
+	void BeginFrame();
+	// the CPU side of the frame is done, what follows until EndFrame is waiting on the swap
+	void BeginPresent();
+	void EndFrame();
+	void AddCpuTime(size_t section, float milliseconds);
+	bool BeginGpu(size_t section);
+	void EndGpu();
+
+	// busy time of the latest resolved frame, the larger of its CPU time before the swap and its summed GPU sections.
+	// Unlike the frame time it does not include waiting for vsync, 0 until a frame has been resolved
+	float GetWorkMs() const { return m_workMs; }
+	// number of frames resolved so far, a consumer of GetWorkMs compares it to tell a new sample from a stale one
+	size_t GetResolvedCount() const { return m_resolvedCount; }
+	bool IsEnabled() const { return m_enabled; }
+	void SetEnabled(bool enabled) { m_enabled = enabled; }
+	bool StartCapture(const std::string& path);
+	void StopCapture();
+	void ImGuiCallback();
+
+private:
+	static constexpr size_t QUERY_SETS = 3;
+	static constexpr size_t HISTORY_LENGTH = 240;
+
+	struct Section {
+		std::string name = "";
+		GLuint queries[QUERY_SETS] = {};
+		bool issued[QUERY_SETS] = {};
+		std::vector<float> cpuHistory = std::vector<float>(HISTORY_LENGTH, 0.0f);
+		std::vector<float> gpuHistory = std::vector<float>(HISTORY_LENGTH, 0.0f);
+	};
+
+	// timings of one frame, completed once its GPU queries have been read back
+	struct FrameRecord {
+		uint64_t frameIndex = 0;
+		float frameMs = 0.0f;
+		float presentMs = 0.0f;
+		std::vector<float> cpuMs{};
+		std::vector<float> gpuMs{};
+		bool valid = false;
+	};
+
+	// false while a query of the frame is still in flight, the frame is then kept for a later attempt
+	bool ResolveFrame(size_t querySet);
+	void WriteCaptureRow(const FrameRecord& record);
+	float GetAverage(const std::vector<float>& history) const;
+
+private:
+	static inline std::shared_ptr<Profiler> m_instance = nullptr;
+	bool m_enabled = true;
+	uint64_t m_frameIndex = 0;
+	size_t m_historyOffset = 0;
+	size_t m_resolvedCount = 0;
+	float m_workMs = 0.0f;
+	bool m_gpuScopeActive = false;
+	std::chrono::high_resolution_clock::time_point m_frameStart{};
+	std::vector<Section> m_sections{};
+	FrameRecord m_current{};
+	FrameRecord m_pending[QUERY_SETS]{};
+	std::vector<float> m_frameHistory = std::vector<float>(HISTORY_LENGTH, 0.0f);
+
+	std::ofstream m_capture{};
+	size_t m_captureColumns = 0;
+	char m_capturePath[256] = "./profile.csv";
+};
+
+class CpuProfileScope
+{
+public:
+	CpuProfileScope(Profiler* profiler, size_t section) : m_profiler(profiler), m_section(section), m_start(std::chrono::high_resolution_clock::now()) {}
+	~CpuProfileScope()
+	{
+		if (m_profiler->IsEnabled())
+			m_profiler->AddCpuTime(m_section, std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - m_start).count());
+	}
+
+private:
+	Profiler* m_profiler = nullptr;
+	size_t m_section = 0;
+	std::chrono::high_resolution_clock::time_point m_start{};
+};
+
+class GpuProfileScope
+{
+public:
+	GpuProfileScope(Profiler* profiler, size_t section) : m_profiler(profiler), m_section(section)
+	{
+		m_active = m_profiler->IsEnabled() && m_profiler->BeginGpu(m_section);
+	}
+	~GpuProfileScope()
+	{
+		if (m_active)
+			m_profiler->EndGpu();
+	}
+
+private:
+	Profiler* m_profiler = nullptr;
+	size_t m_section = 0;
+	bool m_active = false;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+// the profiler and the section are looked up once per call site
+#define PROFILE_SECTION(name) \
+	static Profiler* const PROFILE_CONCAT(profiler, __LINE__) = Profiler::GetInstance().get(); \
+	static const size_t PROFILE_CONCAT(profileSection, __LINE__) = PROFILE_CONCAT(profiler, __LINE__)->RegisterSection(name)
+// CPU time of the enclosing block
+#define PROFILE_CPU_SCOPE(name) \
+	PROFILE_SECTION(name); \
+	CpuProfileScope PROFILE_CONCAT(cpuProfileScope, __LINE__)(PROFILE_CONCAT(profiler, __LINE__), PROFILE_CONCAT(profileSection, __LINE__))
+// CPU and GPU time of the enclosing block
+#define PROFILE_SCOPE(name) \
+	PROFILE_SECTION(name); \
+	CpuProfileScope PROFILE_CONCAT(cpuProfileScope, __LINE__)(PROFILE_CONCAT(profiler, __LINE__), PROFILE_CONCAT(profileSection, __LINE__)); \
+	GpuProfileScope PROFILE_CONCAT(gpuProfileScope, __LINE__)(PROFILE_CONCAT(profiler, __LINE__), PROFILE_CONCAT(profileSection, __LINE__))
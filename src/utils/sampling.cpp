@@ -0,0 +1,187 @@
+#include "sampling.h"
+
+#include <cmath>
+#include <future>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SAMPLING_SSE2
+#endif
+
+namespace {
+// the angle is taken from 24 random bits: a quarter turn is 2^22 of them, the remainder around the nearest
+// quarter turn lies within +-pi/4 where the cephes sinf and cosf polynomials are accurate to float precision
+constexpr float ANGLE_PER_STEP = 6.28318530717958647692f / 16777216.0f;
+constexpr float UNIT_PER_STEP = 1.0f / 16777216.0f;
+
+constexpr float SIN_C0 = -1.6666654611e-1f;
+constexpr float SIN_C1 = 8.3321608736e-3f;
+constexpr float SIN_C2 = -1.9515295891e-4f;
+constexpr float COS_C0 = 4.166664568298827e-2f;
+constexpr float COS_C1 = -1.388731625493765e-3f;
+constexpr float COS_C2 = 2.443315711809948e-5f;
+
+glm::vec3 SurfacePoint(const Philox4x32& philox, uint64_t index, const glm::mat3& transform)
+{
+	Philox4x32::Block bits = philox({ static_cast<uint32_t>(index), static_cast<uint32_t>(index >> 32), 0u, 0u });
+	int32_t steps = static_cast<int32_t>(bits[0] >> 8);
+	int32_t quadrant = (steps + (1 << 21)) >> 22;
+	float r = static_cast<float>(steps - (quadrant << 22)) * ANGLE_PER_STEP;
+	float r2 = r * r;
+	float s = ((SIN_C2 * r2 + SIN_C1) * r2 + SIN_C0) * r2 * r + r;
+	float c = ((COS_C2 * r2 + COS_C1) * r2 + COS_C0) * r2 * r2 - 0.5f * r2 + 1.0f;
+	// rotate by the quarter turns
+	float cosTheta = (quadrant & 1) ? s : c;
+	float sinTheta = (quadrant & 1) ? c : s;
+	cosTheta = ((quadrant + 1) & 2) ? -cosTheta : cosTheta;
+	sinTheta = (quadrant & 2) ? -sinTheta : sinTheta;
+
+	// z is uniform on the sphere by archimedes' hat box theorem
+	float z = 1.0f - 2.0f * (static_cast<float>(bits[1] >> 8) * UNIT_PER_STEP);
+	float radius = std::sqrt((std::max)(1.0f - z * z, 0.0f));
+	return transform * glm::vec3(radius * cosTheta, radius * sinTheta, z);
+}
+
+#ifdef SAMPLING_SSE2
+// 32 x 32 -> 64 bit products of the four lanes with m
+void MulHiLo(__m128i a, __m128i m, __m128i& hi, __m128i& lo)
+{
+	__m128i even = _mm_mul_epu32(a, m);  // lanes 0 and 2
+	__m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), m);  // lanes 1 and 3
+	lo = _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+	hi = _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 3, 1)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 3, 1)));
+}
+
+__m128 Negate(__m128 value, __m128i mask)
+{
+	return _mm_xor_ps(value, _mm_castsi128_ps(_mm_and_si128(mask, _mm_set1_epi32(static_cast<int>(0x80000000u)))));
+}
+
+__m128 Select(__m128i mask, __m128 a, __m128 b)
+{
+	__m128 m = _mm_castsi128_ps(mask);
+	return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b));
+}
+
+// SurfacePoint for the four points from index on, the lanes hold one point each
+void SurfacePoints4(const Philox4x32& philox, uint64_t index, const glm::mat3& transform, glm::vec3* points)
+{
+	__m128i c0 = _mm_setr_epi32(static_cast<int>(index), static_cast<int>(index + 1), static_cast<int>(index + 2), static_cast<int>(index + 3));
+	__m128i c1 = _mm_setr_epi32(static_cast<int>(index >> 32), static_cast<int>((index + 1) >> 32), static_cast<int>((index + 2) >> 32), static_cast<int>((index + 3) >> 32));
+	__m128i c2 = _mm_setzero_si128();
+	__m128i c3 = _mm_setzero_si128();
+	__m128i k0 = _mm_set1_epi32(static_cast<int>(philox.GetKey(0)));
+	__m128i k1 = _mm_set1_epi32(static_cast<int>(philox.GetKey(1)));
+	const __m128i M0 = _mm_set1_epi32(static_cast<int>(Philox4x32::M0));
+	const __m128i M1 = _mm_set1_epi32(static_cast<int>(Philox4x32::M1));
+	for (int round = 0; round < Philox4x32::ROUNDS; round++) {
+		if (round > 0) {
+			k0 = _mm_add_epi32(k0, _mm_set1_epi32(static_cast<int>(Philox4x32::W0)));
+			k1 = _mm_add_epi32(k1, _mm_set1_epi32(static_cast<int>(Philox4x32::W1)));
+		}
+		__m128i hi0, lo0, hi1, lo1;
+		MulHiLo(c0, M0, hi0, lo0);
+		MulHiLo(c2, M1, hi1, lo1);
+		c0 = _mm_xor_si128(_mm_xor_si128(hi1, c1), k0);
+		c1 = lo1;
+		c2 = _mm_xor_si128(_mm_xor_si128(hi0, c3), k1);
+		c3 = lo0;
+	}
+
+	__m128i steps = _mm_srli_epi32(c0, 8);
+	__m128i quadrant = _mm_srai_epi32(_mm_add_epi32(steps, _mm_set1_epi32(1 << 21)), 22);
+	__m128 r = _mm_mul_ps(_mm_cvtepi32_ps(_mm_sub_epi32(steps, _mm_slli_epi32(quadrant, 22))), _mm_set1_ps(ANGLE_PER_STEP));
+	__m128 r2 = _mm_mul_ps(r, r);
+	// same operation order as SurfacePoint, the two give the same bits
+	__m128 sinPoly = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(SIN_C2), r2), _mm_set1_ps(SIN_C1));
+	sinPoly = _mm_add_ps(_mm_mul_ps(sinPoly, r2), _mm_set1_ps(SIN_C0));
+	__m128 s = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(sinPoly, r2), r), r);
+	__m128 cosPoly = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(COS_C2), r2), _mm_set1_ps(COS_C1));
+	cosPoly = _mm_add_ps(_mm_mul_ps(cosPoly, r2), _mm_set1_ps(COS_C0));
+	__m128 c = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(_mm_mul_ps(cosPoly, r2), r2), _mm_mul_ps(_mm_set1_ps(0.5f), r2)), _mm_set1_ps(1.0f));
+	__m128i one = _mm_set1_epi32(1);
+	__m128i odd = _mm_cmpeq_epi32(_mm_and_si128(quadrant, one), one);
+	__m128 cosTheta = Negate(Select(odd, s, c), _mm_slli_epi32(_mm_add_epi32(quadrant, one), 30));
+	__m128 sinTheta = Negate(Select(odd, c, s), _mm_slli_epi32(quadrant, 30));
+
+	__m128 z = _mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(_mm_set1_ps(2.0f), _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(c1, 8)), _mm_set1_ps(UNIT_PER_STEP))));
+	__m128 radius = _mm_sqrt_ps(_mm_max_ps(_mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(z, z)), _mm_setzero_ps()));
+	__m128 x = _mm_mul_ps(radius, cosTheta);
+	__m128 y = _mm_mul_ps(radius, sinTheta);
+
+	alignas(16) float result[3][4];
+	for (int row = 0; row < 3; row++) {
+		__m128 value = _mm_mul_ps(_mm_set1_ps(transform[0][row]), x);
+		value = _mm_add_ps(value, _mm_mul_ps(_mm_set1_ps(transform[1][row]), y));
+		value = _mm_add_ps(value, _mm_mul_ps(_mm_set1_ps(transform[2][row]), z));
+		_mm_store_ps(result[row], value);
+	}
+	for (int i = 0; i < 4; i++) {
+		points[i] = glm::vec3(result[0][i], result[1][i], result[2][i]);
+	}
+}
+#endif
+}
+
+Philox4x32::Block Philox4x32::operator()(Block counter) const
+{
+	uint32_t key[2] = { m_key[0], m_key[1] };
+	for (int round = 0; round < ROUNDS; round++) {
+		if (round > 0) {
+			key[0] += W0;
+			key[1] += W1;
+		}
+		uint64_t product0 = static_cast<uint64_t>(M0) * counter[0];
+		uint64_t product1 = static_cast<uint64_t>(M1) * counter[2];
+		counter = { static_cast<uint32_t>(product1 >> 32) ^ counter[1] ^ key[0], static_cast<uint32_t>(product1),
+			static_cast<uint32_t>(product0 >> 32) ^ counter[3] ^ key[1], static_cast<uint32_t>(product0) };
+	}
+	return counter;
+}
+
+std::shared_ptr<PointSampler> PointSampler::GetInstance()
+{
+	static std::mutex mutex;
+	std::lock_guard<std::mutex> lock(mutex);
+	if (m_instance == nullptr) {
+		m_instance = std::make_shared<PointSampler>();
+	}
+	return m_instance;
+}
+
+PointSampler::PointSampler(size_t threadCount) : m_pool(threadCount)
+{
+}
+
+void PointSampler::SampleSurface(uint64_t seed, const glm::mat3& transform, size_t count, std::vector<glm::vec3>& points)
+{
+	points.resize(count);
+	if (count <= CHUNK_SIZE) {
+		SampleSurface(seed, transform, 0, count, points.data());
+		return;
+	}
+	std::vector<std::future<void>> chunks;
+	for (size_t first = 0; first < count; first += CHUNK_SIZE) {
+		size_t chunkCount = (std::min)(CHUNK_SIZE, count - first);
+		chunks.push_back(m_pool.Enqueue([seed, transform, first, chunkCount, &points]() {
+			SampleSurface(seed, transform, first, chunkCount, points.data() + first);
+			}));
+	}
+	for (auto& chunk : chunks) {
+		chunk.get();
+	}
+}
+
+void PointSampler::SampleSurface(uint64_t seed, const glm::mat3& transform, uint64_t first, size_t count, glm::vec3* points)
+{
+	Philox4x32 philox(seed);
+	size_t i = 0;
+#ifdef SAMPLING_SSE2
+	for (; i + 4 <= count; i += 4) {
+		SurfacePoints4(philox, first + i, transform, points + i);
+	}
+#endif
+	for (; i < count; i++) {
+		points[i] = SurfacePoint(philox, first + i, transform);
+	}
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <glm/glm.hpp>
+
+#include <array>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+#include "../threadpool/threadpool.h"
+
+// Philox4x32-10 counter based generator (Salmon et al., "Parallel Random Numbers: As Easy as 1, 2, 3").
+// A block of four numbers is a pure function of the key and the counter, so sample i can be drawn without
+// drawing the samples before it, by any thread, and always comes out the same.
+class Philox4x32
+{
+public:
+	using Block = std::array<uint32_t, 4>;
+
+	explicit Philox4x32(uint64_t seed) : m_key{ static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32) } {}
+	Block operator()(Block counter) const;
+	uint32_t GetKey(int i) const { return m_key[i]; }
+
+	static constexpr uint32_t M0 = 0xD2511F53u;
+	static constexpr uint32_t M1 = 0xCD9E8D57u;
+	static constexpr uint32_t W0 = 0x9E3779B9u;  // key increments between rounds
+	static constexpr uint32_t W1 = 0xBB67AE85u;
+	static constexpr int ROUNDS = 10;
+
+private:
+	uint32_t m_key[2];
+};
+
+// Procedural point clouds for the debug primitives. Point i is made from counter i of a Philox4x32 keyed by
+// the seed, so the cloud only depends on the seed and the parameters, not on how it is split over the threads.
+// The points are generated four at a time with SSE2 when the target has it, in chunks spread over a thread pool.
+class PointSampler
+{
+public:
+	static std::shared_ptr<PointSampler> GetInstance();
+	explicit PointSampler(size_t threadCount = (std::max)(std::thread::hardware_concurrency(), 1u));
+	PointSampler(const PointSampler&) = delete;
+	PointSampler& operator=(const PointSampler&) = delete;
+
+	// count points uniformly distributed over the unit sphere and mapped by transform: a scaled identity gives a
+	// sphere, rotation * scale an ellipsoid whose semi axes are the columns of transform
+	void SampleSurface(uint64_t seed, const glm::mat3& transform, size_t count, std::vector<glm::vec3>& points);
+	// points [first, first + count) of the same sequence, single threaded
+	static void SampleSurface(uint64_t seed, const glm::mat3& transform, uint64_t first, size_t count, glm::vec3* points);
+
+private:
+	static constexpr size_t CHUNK_SIZE = 1 << 16;
+
+	static inline std::shared_ptr<PointSampler> m_instance = nullptr;
+	ThreadPool m_pool;
+};